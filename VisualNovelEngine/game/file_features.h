@@ -1,4 +1,8 @@
 #pragma once
+#include <fstream>
+#include <cstdint>
+#include <utility>
+
 #include "string_features.h"
 
 bool exists(const std::wstring& name)
@@ -12,6 +16,140 @@ bool exists(const std::wstring& name)
 		return false;
 }
 
+// write time and size of file, files generated from it store them and are valid only while both match
+bool get_file_stamp(const std::wstring& name, uint64_t& write_time, uint64_t& size)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+
+	if (!GetFileAttributesExW(name.c_str(), GetFileExInfoStandard, &data))
+		return false;
+
+	write_time = (uint64_t(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+	size = (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+
+	return true;
+}
+
+// Read only view of whole file, file stays open and mapped until view is closed or destroyed. Other handles can still
+// write the file, but not truncate it.
+struct MappedFileView_t
+{
+	MappedFileView_t()
+	{
+	}
+
+	MappedFileView_t(const MappedFileView_t&) = delete;
+	MappedFileView_t& operator=(const MappedFileView_t&) = delete;
+
+	MappedFileView_t(MappedFileView_t&& other)
+	{
+		*this = std::move(other);
+	}
+
+	MappedFileView_t& operator=(MappedFileView_t&& other)
+	{
+		if (this == &other)
+			return *this;
+
+		close();
+
+		std::swap(file, other.file);
+		std::swap(mapping, other.mapping);
+
+		std::swap(data, other.data);
+		std::swap(size, other.size);
+
+		return *this;
+	}
+
+	~MappedFileView_t()
+	{
+		close();
+	}
+
+	bool open(const std::wstring& name)
+	{
+		close();
+
+		file = CreateFileW(name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size;
+
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (!mapping)
+		{
+			close();
+			return false;
+		}
+
+		data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (!data)
+		{
+			close();
+			return false;
+		}
+
+		size = uint64_t(file_size.QuadPart);
+
+		return true;
+	}
+
+	void close()
+	{
+		if (data)
+			UnmapViewOfFile(data);
+
+		if (mapping)
+			CloseHandle(mapping);
+
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+
+		data = nullptr;
+		size = 0;
+	}
+
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+};
+
+bool read_file(const std::wstring& name, std::vector<uint8_t>& data)
+{
+	std::ifstream file(name, std::ios::binary | std::ios::ate);
+
+	if (!file.is_open())
+		return false;
+
+	std::streamsize size = file.tellg();
+
+	if (size < 0)
+		return false;
+
+	data.resize(size_t(size));
+
+	file.seekg(0, std::ios::beg);
+	file.read((char*)data.data(), size);
+
+	return file.good();
+}
+
 std::string get_file_ext_(std::string name)
 {
 	return find_str311(name, ".");
@@ -0,0 +1,152 @@
+#pragma once
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+
+// Heap allocations of each thread, counted by replaced global operator new and imgui allocator functions. Frame
+// profiler takes allocations of main thread per frame from it.
+thread_local uint64_t thread_allocations = 0;
+
+void* counted_allocate(size_t size)
+{
+	thread_allocations++;
+
+	void* memory = malloc(size ? size : 1);
+
+	if (!memory)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void* counted_allocate(size_t size, size_t alignment)
+{
+	thread_allocations++;
+
+#ifdef _MSC_VER
+	void* memory = _aligned_malloc(size ? size : 1, alignment);
+#else
+	void* memory = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+
+	if (!memory)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+// passed to ImGui::SetAllocatorFunctions, imgui allocates with malloc otherwise
+void* counted_imgui_allocate(size_t size, void* user_data)
+{
+	thread_allocations++;
+
+	return malloc(size);
+}
+
+void counted_imgui_free(void* memory, void* user_data)
+{
+	free(memory);
+}
+
+void counted_aligned_free(void* memory)
+{
+#ifdef _MSC_VER
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+void* operator new(size_t size)
+{
+	return counted_allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return counted_allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return counted_allocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return counted_allocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return counted_allocate(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return counted_allocate(size, size_t(alignment));
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	counted_aligned_free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	counted_aligned_free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	counted_aligned_free(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	counted_aligned_free(memory);
+}
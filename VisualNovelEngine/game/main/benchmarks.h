@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <locale>
+#include <codecvt>
+#include <ostream>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+
+#include <Windows.h>
+
+#include "translation.h"
+#include "text_encoding.h"
+
+// results are added here, so compiler cant drop measured work
+volatile uint64_t benchmark_sink = 0;
+
+// time of one call in microseconds, best of few runs so scheduling noise isnt measured
+template <class F>
+double measure_call_us(int calls, F function)
+{
+	double best_us = DBL_MAX;
+
+	for (int run = 0; run < 5; run++)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < calls; i++)
+			function();
+
+		best_us = std::min(best_us, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	return best_us / calls;
+}
+
+struct BenchmarkTranslationKey_t
+{
+	const wchar_t* text;
+	uint64_t hash;
+};
+
+// hashed by compiler, as LANG does
+#define BENCHMARK_TRANSLATION_KEY(text) { text, std::integral_constant<uint64_t, get_translation_hash(text)>::value }
+
+// about as many LANG calls as main menu with settings window open makes in one frame
+const BenchmarkTranslationKey_t BENCHMARK_TRANSLATION_KEYS[] =
+{
+	BENCHMARK_TRANSLATION_KEY(L"Animated dialogue text"), BENCHMARK_TRANSLATION_KEY(L"Apply"), BENCHMARK_TRANSLATION_KEY(L"Audio settings"),
+	BENCHMARK_TRANSLATION_KEY(L"Auto save"), BENCHMARK_TRANSLATION_KEY(L"Back to game"), BENCHMARK_TRANSLATION_KEY(L"Button name"),
+	BENCHMARK_TRANSLATION_KEY(L"Buttons"), BENCHMARK_TRANSLATION_KEY(L"Cancel"), BENCHMARK_TRANSLATION_KEY(L"Character name"),
+	BENCHMARK_TRANSLATION_KEY(L"Character text"), BENCHMARK_TRANSLATION_KEY(L"Close"), BENCHMARK_TRANSLATION_KEY(L"Create new scenario"),
+	BENCHMARK_TRANSLATION_KEY(L"Create new scene"), BENCHMARK_TRANSLATION_KEY(L"Delete scene"), BENCHMARK_TRANSLATION_KEY(L"Edit scene"),
+	BENCHMARK_TRANSLATION_KEY(L"Enter player name"), BENCHMARK_TRANSLATION_KEY(L"Enter save name"), BENCHMARK_TRANSLATION_KEY(L"Exit to main menu"),
+	BENCHMARK_TRANSLATION_KEY(L"Game settings"), BENCHMARK_TRANSLATION_KEY(L"History"), BENCHMARK_TRANSLATION_KEY(L"Load save"),
+	BENCHMARK_TRANSLATION_KEY(L"Loading..."), BENCHMARK_TRANSLATION_KEY(L"Main character text"), BENCHMARK_TRANSLATION_KEY(L"Menu language"),
+	BENCHMARK_TRANSLATION_KEY(L"Music volume"), BENCHMARK_TRANSLATION_KEY(L"Pause rendering when idle"), BENCHMARK_TRANSLATION_KEY(L"Play"),
+	BENCHMARK_TRANSLATION_KEY(L"Quit game"), BENCHMARK_TRANSLATION_KEY(L"Render mode"), BENCHMARK_TRANSLATION_KEY(L"Save game"),
+	BENCHMARK_TRANSLATION_KEY(L"Scene editor"), BENCHMARK_TRANSLATION_KEY(L"Select save"), BENCHMARK_TRANSLATION_KEY(L"Select scenario"),
+	BENCHMARK_TRANSLATION_KEY(L"Show FPS counter"), BENCHMARK_TRANSLATION_KEY(L"Sound volume"), BENCHMARK_TRANSLATION_KEY(L"Start new game"),
+	BENCHMARK_TRANSLATION_KEY(L"Text animation speed"), BENCHMARK_TRANSLATION_KEY(L"Texture quality"), BENCHMARK_TRANSLATION_KEY(L"Video settings"),
+	BENCHMARK_TRANSLATION_KEY(L"Window mode"),
+};
+
+// translation lookups of one menu frame in language of 120 strings: linear scan encoding match to UTF-8 on every call
+// (as LANG did before catalog), catalog with hash computed on call and catalog with hash of literal
+void benchmark_translation_lookups(std::ostream& out)
+{
+	const int key_count = sizeof(BENCHMARK_TRANSLATION_KEYS) / sizeof(BENCHMARK_TRANSLATION_KEYS[0]);
+
+	GameLanguage_t language;
+
+	for (int i = 0; i < 120; i++)
+	{
+		TranslatedText_t string;
+
+		string.original_text = i < key_count ? BENCHMARK_TRANSLATION_KEYS[i].text : L"Unused menu string " + std::to_wstring(i);
+		string.translation_text = L"\x041f\x0435\x0440\x0435\x0432\x043e\x0434 " + string.original_text;
+
+		encode_utf8(string.translation_text.data(), string.translation_text.size(), string.translation_utf8);
+
+		// keys are spread over language, as in language files
+		language.strings.insert(language.strings.begin() + (i * 7) % (language.strings.size() + 1), string);
+	}
+
+	language.build_catalog();
+
+	double linear_us = measure_call_us(2000, [&]
+	{
+		for (int i = 0; i < key_count; i++)
+		{
+			for (int c = 0; c < language.strings.size(); c++)
+			{
+				if (language.strings.at(c).original_text == BENCHMARK_TRANSLATION_KEYS[i].text)
+				{
+					static char buffer[1024];
+					WideCharToMultiByte(CP_UTF8, 0, language.strings.at(c).translation_text.c_str(), -1, buffer, sizeof(buffer), NULL, NULL);
+
+					benchmark_sink += uint8_t(buffer[0]);
+					break;
+				}
+			}
+		}
+	});
+
+	double runtime_hash_us = measure_call_us(20000, [&]
+	{
+		for (int i = 0; i < key_count; i++)
+			benchmark_sink += uintptr_t(language.find(BENCHMARK_TRANSLATION_KEYS[i].text, get_translation_hash(BENCHMARK_TRANSLATION_KEYS[i].text)));
+	});
+
+	double literal_hash_us = measure_call_us(20000, [&]
+	{
+		for (int i = 0; i < key_count; i++)
+			benchmark_sink += uintptr_t(language.find(BENCHMARK_TRANSLATION_KEYS[i].text, BENCHMARK_TRANSLATION_KEYS[i].hash));
+	});
+
+	char line[256];
+	snprintf(line, sizeof(line), "translation lookups, %d per frame in %d strings: linear scan with encoding %.2f us, catalog %.2f us, catalog with literal hash %.2f us per frame\n", key_count, int(language.strings.size()), linear_us, runtime_hash_us, literal_hash_us);
+
+	out << line;
+}
+
+// UTF-8 encoding and decoding throughput of text_encoding.h against wstring_convert, which s2ws and ws2s used before,
+// in megabytes of UTF-8 per second
+void benchmark_text_encoding(std::ostream& out)
+{
+	struct BenchmarkText_t
+	{
+		const char* name;
+		std::vector<wchar_t> text;
+	};
+
+	BenchmarkText_t texts[3] = { { "ascii 4k chars" }, { "cyrillic 4k chars" }, { "24-char file name" } };
+
+	for (int i = 0; i < 4096; i++)
+	{
+		texts[0].text.push_back(wchar_t(L'a' + i % 26));
+		texts[1].text.push_back(i % 6 == 5 ? wchar_t(L' ') : wchar_t(0x0430 + i % 32));
+	}
+
+	const wchar_t file_name[] = L"background_forest_01.png";
+	texts[2].text.assign(file_name, file_name + 24);
+
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> converter;
+
+	for (int t = 0; t < 3; t++)
+	{
+		const std::vector<wchar_t>& text = texts[t].text;
+
+		std::wstring wide(text.begin(), text.end());
+		std::string encoded = converter.to_bytes(wide);
+
+		std::string utf8;
+		std::wstring decoded;
+
+		int calls = std::max(int(4000000 / encoded.size()), 1);
+
+		double encode_old_us = measure_call_us(calls / 8, [&] { benchmark_sink += converter.to_bytes(wide).size(); });
+		double decode_old_us = measure_call_us(calls / 8, [&] { benchmark_sink += converter.from_bytes(encoded).size(); });
+
+		double encode_us = measure_call_us(calls, [&] { encode_utf8(text.data(), text.size(), utf8); benchmark_sink += utf8.size(); });
+		double decode_us = measure_call_us(calls, [&] { decode_utf8(encoded.data(), encoded.size(), decoded); benchmark_sink += decoded.size(); });
+
+		double megabytes = double(encoded.size()) / (1024.0 * 1024.0);
+
+		char line[256];
+		snprintf(line, sizeof(line), "text encoding, %-18s encode %.0f -> %.0f MB/s, decode %.0f -> %.0f MB/s\n", texts[t].name, megabytes / (encode_old_us / 1000000.0), megabytes / (encode_us / 1000000.0), megabytes / (decode_old_us / 1000000.0), megabytes / (decode_us / 1000000.0));
+
+		out << line;
+	}
+}
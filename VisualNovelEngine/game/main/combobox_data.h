@@ -9,7 +9,8 @@ const char* ScreenMode[] =
 #ifdef DCS_OPENGL
 const char* RenderMode[] =
 {
-	"OpenGL"
+	"OpenGL",
+	"OpenGL 3.3"
 };
 #else
 const char* RenderMode[] =
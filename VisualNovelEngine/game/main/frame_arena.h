@@ -0,0 +1,129 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cstddef>
+#include <cwchar>
+
+#include "text_encoding.h"
+
+const size_t FRAME_ARENA_BLOCK_SIZE = 64 * 1024;
+
+// Memory for temporary strings and imgui labels of one frame, released all at once when next frame starts. Allocation
+// is pointer bump. If frame didnt fit in one block, blocks are replaced by one which fits, so steady frames dont touch
+// heap. Main thread only.
+struct FrameArena_t
+{
+	struct Block_t
+	{
+		std::unique_ptr<char[]> data;
+		size_t size = 0;
+	};
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+	{
+		if (!blocks.empty())
+		{
+			Block_t& block = blocks.back();
+
+			size_t offset = (block_used + alignment - 1) & ~(alignment - 1);
+
+			if (offset + size <= block.size)
+			{
+				block_used = offset + size;
+				used += size;
+
+				return block.data.get() + offset;
+			}
+		}
+
+		add_block(size + alignment);
+		return allocate(size, alignment);
+	}
+
+	void add_block(size_t min_size)
+	{
+		Block_t block;
+
+		block.size = min_size > FRAME_ARENA_BLOCK_SIZE ? min_size : FRAME_ARENA_BLOCK_SIZE;
+		block.data.reset(new char[block.size]);
+
+		blocks.push_back(std::move(block));
+		block_used = 0;
+	}
+
+	// pointers of last frame are invalid after it
+	void reset()
+	{
+		peak = used > peak ? used : peak;
+
+		if (blocks.size() > 1)
+		{
+			size_t total = 0;
+
+			for (int i = 0; i < blocks.size(); i++)
+				total += blocks.at(i).size;
+
+			blocks.clear();
+			add_block(total);
+		}
+
+		block_used = 0;
+		used = 0;
+	}
+
+	// printf formatted string
+	const char* format(const char* fmt, ...)
+	{
+		va_list args;
+
+		va_start(args, fmt);
+		int length = vsnprintf(nullptr, 0, fmt, args);
+		va_end(args);
+
+		if (length < 0)
+			return "";
+
+		char* text = (char*)allocate(size_t(length) + 1, 1);
+
+		va_start(args, fmt);
+		vsnprintf(text, size_t(length) + 1, fmt, args);
+		va_end(args);
+
+		return text;
+	}
+
+	const char* utf8(const wchar_t* text, size_t length)
+	{
+		char* out = (char*)allocate(get_utf8_capacity(length) + 1, 1);
+
+		size_t size = encode_utf8(text, length, out);
+		out[size] = '\0';
+
+		// encoded text is usually shorter than capacity, rest is given back
+		block_used -= get_utf8_capacity(length) - size;
+		used -= get_utf8_capacity(length) - size;
+
+		return out;
+	}
+
+	const char* utf8(const wchar_t* text)
+	{
+		return utf8(text, wcslen(text));
+	}
+
+	const char* utf8(const std::wstring& text)
+	{
+		return utf8(text.data(), text.size());
+	}
+
+	std::vector<Block_t> blocks;
+	size_t block_used = 0;
+
+	// bytes of current and busiest frame
+	size_t used = 0;
+	size_t peak = 0;
+};
@@ -0,0 +1,264 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "trace.h"
+#include "allocation_counter.h"
+
+// frames kept for percentiles, bars and csv export
+const int FRAME_PROFILER_HISTORY = 300;
+
+// deepest nesting of phase scopes, deeper scopes are not measured
+const int FRAME_PROFILER_MAX_DEPTH = 16;
+
+enum FramePhase_t
+{
+	FRAME_PHASE_TEXTURE_STREAMING, // residency, uploads
+	FRAME_PHASE_INTRO,
+	FRAME_PHASE_GAME_LAYOUT, // game_render without phases below
+	FRAME_PHASE_TEXTURE_LOOKUP,
+	FRAME_PHASE_TEXT,
+	FRAME_PHASE_AUDIO,
+	FRAME_PHASE_IMGUI_RENDER,
+	FRAME_PHASE_SUBMIT, // clear and draw data submit of renderer
+	FRAME_PHASE_PRESENT, // present and vsync wait
+	FRAME_PHASE_OTHER, // input, imgui new frame, anything not measured
+	FRAME_PHASE_COUNT
+};
+
+const char* FRAME_PHASE_NAMES[FRAME_PHASE_COUNT] =
+{
+	"Texture streaming",
+	"Intro",
+	"Game layout",
+	"Texture lookup",
+	"Text",
+	"Audio",
+	"ImGui render",
+	"Draw submit",
+	"Present",
+	"Other"
+};
+
+struct FrameProfilerSample_t
+{
+	uint64_t frame = 0;
+
+	float frame_ms = 0.0f;
+	float phase_ms[FRAME_PHASE_COUNT] = {};
+
+	// heap allocations of main thread, see allocation_counter.h
+	int allocations = 0;
+};
+
+// CPU time of frame phases. Phases are exclusive, nested phase time is not counted in its parent, so phases of frame
+// add up to its frame time. Frames and phases are traced too.
+struct FrameProfiler_t
+{
+	void begin_frame()
+	{
+		tracer.begin("Frame");
+
+		frame_start = std::chrono::steady_clock::now();
+		frame_start_allocations = thread_allocations;
+		depth = 0;
+
+		current = FrameProfilerSample_t();
+		current.frame = frames;
+	}
+
+	void begin(FramePhase_t phase)
+	{
+		auto now = std::chrono::steady_clock::now();
+
+		if (depth > 0 && depth <= FRAME_PROFILER_MAX_DEPTH)
+			current.phase_ms[stack[depth - 1].phase] += elapsed_ms(stack[depth - 1].start, now);
+
+		if (depth < FRAME_PROFILER_MAX_DEPTH)
+		{
+			stack[depth] = { phase, now };
+			tracer.begin(FRAME_PHASE_NAMES[phase]);
+		}
+
+		depth++;
+	}
+
+	void end()
+	{
+		if (depth == 0)
+			return;
+
+		auto now = std::chrono::steady_clock::now();
+
+		depth--;
+
+		if (depth < FRAME_PROFILER_MAX_DEPTH)
+		{
+			current.phase_ms[stack[depth].phase] += elapsed_ms(stack[depth].start, now);
+			tracer.end(FRAME_PHASE_NAMES[stack[depth].phase]);
+		}
+
+		// parent continues from now
+		if (depth > 0 && depth <= FRAME_PROFILER_MAX_DEPTH)
+			stack[depth - 1].start = now;
+	}
+
+	void end_frame()
+	{
+		current.frame_ms = elapsed_ms(frame_start, std::chrono::steady_clock::now());
+		current.allocations = int(thread_allocations - frame_start_allocations);
+
+		float measured_ms = 0.0f;
+
+		for (int i = 0; i < FRAME_PHASE_COUNT; i++)
+			measured_ms += current.phase_ms[i];
+
+		current.phase_ms[FRAME_PHASE_OTHER] = std::max(current.frame_ms - measured_ms, 0.0f);
+
+		history[next_sample] = current;
+		next_sample = (next_sample + 1) % FRAME_PROFILER_HISTORY;
+		samples = std::min(samples + 1, FRAME_PROFILER_HISTORY);
+
+		frames++;
+
+		tracer.end("Frame");
+	}
+
+	const FrameProfilerSample_t& last_sample()
+	{
+		return history[(next_sample + FRAME_PROFILER_HISTORY - 1) % FRAME_PROFILER_HISTORY];
+	}
+
+	// frame time below which given fraction of kept frames are
+	float percentile(float fraction)
+	{
+		if (samples == 0)
+			return 0.0f;
+
+		for (int i = 0; i < samples; i++)
+			percentile_scratch[i] = history[i].frame_ms;
+
+		int idx = std::min(int(fraction * samples), samples - 1);
+		std::nth_element(percentile_scratch, percentile_scratch + idx, percentile_scratch + samples);
+
+		return percentile_scratch[idx];
+	}
+
+	float average(FramePhase_t phase)
+	{
+		if (samples == 0)
+			return 0.0f;
+
+		float total = 0.0f;
+
+		for (int i = 0; i < samples; i++)
+			total += history[i].phase_ms[phase];
+
+		return total / samples;
+	}
+
+	float average_frame()
+	{
+		if (samples == 0)
+			return 0.0f;
+
+		float total = 0.0f;
+
+		for (int i = 0; i < samples; i++)
+			total += history[i].frame_ms;
+
+		return total / samples;
+	}
+
+	float average_allocations()
+	{
+		if (samples == 0)
+			return 0.0f;
+
+		float total = 0.0f;
+
+		for (int i = 0; i < samples; i++)
+			total += float(history[i].allocations);
+
+		return total / samples;
+	}
+
+	// kept frames from oldest, one row per frame
+	bool export_csv(const std::wstring& path)
+	{
+		std::ofstream file(path, std::ios::trunc);
+
+		if (!file.is_open())
+			return false;
+
+		file << "frame,frame_ms,allocations";
+
+		for (int i = 0; i < FRAME_PHASE_COUNT; i++)
+			file << "," << FRAME_PHASE_NAMES[i];
+
+		file << "\n";
+
+		int first = samples < FRAME_PROFILER_HISTORY ? 0 : next_sample;
+
+		for (int i = 0; i < samples; i++)
+		{
+			FrameProfilerSample_t& sample = history[(first + i) % FRAME_PROFILER_HISTORY];
+
+			file << sample.frame << "," << sample.frame_ms << "," << sample.allocations;
+
+			for (int c = 0; c < FRAME_PHASE_COUNT; c++)
+				file << "," << sample.phase_ms[c];
+
+			file << "\n";
+		}
+
+		return file.good();
+	}
+
+	static float elapsed_ms(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<float, std::milli>(end - start).count();
+	}
+
+	struct PhaseStart_t
+	{
+		FramePhase_t phase;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
+	uint64_t frame_start_allocations = 0;
+
+	PhaseStart_t stack[FRAME_PROFILER_MAX_DEPTH];
+	int depth = 0;
+
+	FrameProfilerSample_t current;
+
+	FrameProfilerSample_t history[FRAME_PROFILER_HISTORY];
+
+	// frame times reordered by percentile, overlay asks for few of them every frame
+	float percentile_scratch[FRAME_PROFILER_HISTORY];
+	int next_sample = 0;
+	int samples = 0;
+
+	uint64_t frames = 0;
+};
+
+// measures phase until end of scope
+struct FrameProfilerScope_t
+{
+	FrameProfilerScope_t(FrameProfiler_t& profiler, FramePhase_t phase) : profiler(profiler)
+	{
+		profiler.begin(phase);
+	}
+
+	~FrameProfilerScope_t()
+	{
+		profiler.end();
+	}
+
+	FrameProfiler_t& profiler;
+};
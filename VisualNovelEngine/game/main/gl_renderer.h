@@ -0,0 +1,435 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include <Windows.h>
+#include <gl/GL.h>
+
+#include "../../imgui/imgui.h"
+
+#include "trace.h"
+
+// GL 1.1 headers of Windows dont have these, functions are loaded with wglGetProcAddress
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STREAM_DRAW 0x88E0
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_TEXTURE0 0x84C0
+#define GL_FUNC_ADD 0x8006
+#endif
+
+typedef char GLchar;
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+
+typedef void (APIENTRY* PFN_GL_GEN_VERTEX_ARRAYS)(GLsizei n, GLuint* arrays);
+typedef void (APIENTRY* PFN_GL_BIND_VERTEX_ARRAY)(GLuint array);
+typedef void (APIENTRY* PFN_GL_DELETE_VERTEX_ARRAYS)(GLsizei n, const GLuint* arrays);
+typedef void (APIENTRY* PFN_GL_GEN_BUFFERS)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRY* PFN_GL_BIND_BUFFER)(GLenum target, GLuint buffer);
+typedef void (APIENTRY* PFN_GL_DELETE_BUFFERS)(GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY* PFN_GL_BUFFER_DATA)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void* (APIENTRY* PFN_GL_MAP_BUFFER_RANGE)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean(APIENTRY* PFN_GL_UNMAP_BUFFER)(GLenum target);
+typedef void (APIENTRY* PFN_GL_ENABLE_VERTEX_ATTRIB_ARRAY)(GLuint index);
+typedef void (APIENTRY* PFN_GL_VERTEX_ATTRIB_POINTER)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+typedef GLuint(APIENTRY* PFN_GL_CREATE_SHADER)(GLenum type);
+typedef void (APIENTRY* PFN_GL_SHADER_SOURCE)(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+typedef void (APIENTRY* PFN_GL_COMPILE_SHADER)(GLuint shader);
+typedef void (APIENTRY* PFN_GL_GET_SHADERIV)(GLuint shader, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_GL_DELETE_SHADER)(GLuint shader);
+typedef GLuint(APIENTRY* PFN_GL_CREATE_PROGRAM)();
+typedef void (APIENTRY* PFN_GL_ATTACH_SHADER)(GLuint program, GLuint shader);
+typedef void (APIENTRY* PFN_GL_LINK_PROGRAM)(GLuint program);
+typedef void (APIENTRY* PFN_GL_GET_PROGRAMIV)(GLuint program, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_GL_DELETE_PROGRAM)(GLuint program);
+typedef void (APIENTRY* PFN_GL_USE_PROGRAM)(GLuint program);
+typedef GLint(APIENTRY* PFN_GL_GET_UNIFORM_LOCATION)(GLuint program, const GLchar* name);
+typedef void (APIENTRY* PFN_GL_UNIFORM_1I)(GLint location, GLint v0);
+typedef void (APIENTRY* PFN_GL_UNIFORM_MATRIX_4FV)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+typedef void (APIENTRY* PFN_GL_ACTIVE_TEXTURE)(GLenum texture);
+typedef void (APIENTRY* PFN_GL_BLEND_EQUATION)(GLenum mode);
+typedef void (APIENTRY* PFN_GL_BLEND_FUNC_SEPARATE)(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha);
+typedef void (APIENTRY* PFN_GL_DRAW_ELEMENTS_BASE_VERTEX)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint base_vertex);
+
+const char* GL_RENDERER_VERTEX_SHADER =
+	"#version 330 core\n"
+	"uniform mat4 projection;\n"
+	"layout (location = 0) in vec2 position;\n"
+	"layout (location = 1) in vec2 uv;\n"
+	"layout (location = 2) in vec4 color;\n"
+	"out vec2 frag_uv;\n"
+	"out vec4 frag_color;\n"
+	"void main()\n"
+	"{\n"
+	"	frag_uv = uv;\n"
+	"	frag_color = color;\n"
+	"	gl_Position = projection * vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+const char* GL_RENDERER_FRAGMENT_SHADER =
+	"#version 330 core\n"
+	"uniform sampler2D sampled_texture;\n"
+	"in vec2 frag_uv;\n"
+	"in vec4 frag_color;\n"
+	"layout (location = 0) out vec4 out_color;\n"
+	"void main()\n"
+	"{\n"
+	"	out_color = frag_color * texture(sampled_texture, frag_uv);\n"
+	"}\n";
+
+// Draws ImDrawData with GL 3.3 core features: one shader, one VAO, and vertex and index buffers streamed once per frame
+// by orphaning (buffer is reallocated and mapped with invalidate, so driver never waits for GPU reading last frame).
+// All draw lists share buffers, commands are drawn with base vertex. Only state which changes between commands (scissor,
+// texture) is set per command, and GL state is not backed up, the loop draws nothing else with GL between frames.
+struct GlRenderer_t
+{
+	// some drivers return 1, 2, 3 or -1 instead of null for functions they dont have
+	template <class T>
+	bool load(T& function, const char* name)
+	{
+		PROC address = wglGetProcAddress(name);
+		intptr_t value = intptr_t(address);
+
+		if (value == 0 || value == 1 || value == 2 || value == 3 || value == -1)
+		{
+			function = nullptr;
+			return false;
+		}
+
+		function = (T)address;
+		return true;
+	}
+
+	// needs current GL 3.3 context, false if driver doesnt have it
+	bool init()
+	{
+		TraceScope_t trace_scope("GlRenderer_t::init");
+
+		bool loaded = load(gl_gen_vertex_arrays, "glGenVertexArrays") && load(gl_bind_vertex_array, "glBindVertexArray") && load(gl_delete_vertex_arrays, "glDeleteVertexArrays") &&
+			load(gl_gen_buffers, "glGenBuffers") && load(gl_bind_buffer, "glBindBuffer") && load(gl_delete_buffers, "glDeleteBuffers") &&
+			load(gl_buffer_data, "glBufferData") && load(gl_map_buffer_range, "glMapBufferRange") && load(gl_unmap_buffer, "glUnmapBuffer") &&
+			load(gl_enable_vertex_attrib_array, "glEnableVertexAttribArray") && load(gl_vertex_attrib_pointer, "glVertexAttribPointer") &&
+			load(gl_create_shader, "glCreateShader") && load(gl_shader_source, "glShaderSource") && load(gl_compile_shader, "glCompileShader") &&
+			load(gl_get_shaderiv, "glGetShaderiv") && load(gl_delete_shader, "glDeleteShader") && load(gl_create_program, "glCreateProgram") &&
+			load(gl_attach_shader, "glAttachShader") && load(gl_link_program, "glLinkProgram") && load(gl_get_programiv, "glGetProgramiv") &&
+			load(gl_delete_program, "glDeleteProgram") && load(gl_use_program, "glUseProgram") && load(gl_get_uniform_location, "glGetUniformLocation") &&
+			load(gl_uniform_1i, "glUniform1i") && load(gl_uniform_matrix_4fv, "glUniformMatrix4fv") && load(gl_active_texture, "glActiveTexture") &&
+			load(gl_blend_equation, "glBlendEquation") && load(gl_blend_func_separate, "glBlendFuncSeparate") &&
+			load(gl_draw_elements_base_vertex, "glDrawElementsBaseVertex");
+
+		if (!loaded)
+			return false;
+
+		GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, GL_RENDERER_VERTEX_SHADER);
+		GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, GL_RENDERER_FRAGMENT_SHADER);
+
+		if (!vertex_shader || !fragment_shader)
+		{
+			if (vertex_shader)
+				gl_delete_shader(vertex_shader);
+
+			if (fragment_shader)
+				gl_delete_shader(fragment_shader);
+
+			return false;
+		}
+
+		program = gl_create_program();
+
+		gl_attach_shader(program, vertex_shader);
+		gl_attach_shader(program, fragment_shader);
+		gl_link_program(program);
+
+		// program keeps them
+		gl_delete_shader(vertex_shader);
+		gl_delete_shader(fragment_shader);
+
+		GLint linked = GL_FALSE;
+		gl_get_programiv(program, GL_LINK_STATUS, &linked);
+
+		if (linked != GL_TRUE)
+		{
+			gl_delete_program(program);
+			program = 0;
+
+			return false;
+		}
+
+		projection_location = gl_get_uniform_location(program, "projection");
+
+		gl_use_program(program);
+		gl_uniform_1i(gl_get_uniform_location(program, "sampled_texture"), 0);
+		gl_use_program(0);
+
+		gl_gen_vertex_arrays(1, &vertex_array);
+		gl_gen_buffers(1, &vertex_buffer);
+		gl_gen_buffers(1, &index_buffer);
+
+		// attribute layout is VAO state, set once
+		gl_bind_vertex_array(vertex_array);
+		gl_bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
+		gl_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+
+		gl_enable_vertex_attrib_array(0);
+		gl_enable_vertex_attrib_array(1);
+		gl_enable_vertex_attrib_array(2);
+
+		gl_vertex_attrib_pointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (const void*)offsetof(ImDrawVert, pos));
+		gl_vertex_attrib_pointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (const void*)offsetof(ImDrawVert, uv));
+		gl_vertex_attrib_pointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (const void*)offsetof(ImDrawVert, col));
+
+		gl_bind_vertex_array(0);
+		gl_bind_buffer(GL_ARRAY_BUFFER, 0);
+
+		ready = true;
+		return true;
+	}
+
+	void shutdown()
+	{
+		if (!ready)
+			return;
+
+		gl_delete_buffers(1, &vertex_buffer);
+		gl_delete_buffers(1, &index_buffer);
+		gl_delete_vertex_arrays(1, &vertex_array);
+		gl_delete_program(program);
+
+		vertex_buffer = 0;
+		index_buffer = 0;
+		vertex_array = 0;
+		program = 0;
+
+		ready = false;
+	}
+
+	GLuint compile_shader(GLenum type, const char* source)
+	{
+		GLuint shader = gl_create_shader(type);
+
+		gl_shader_source(shader, 1, &source, nullptr);
+		gl_compile_shader(shader);
+
+		GLint compiled = GL_FALSE;
+		gl_get_shaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+		if (compiled != GL_TRUE)
+		{
+			gl_delete_shader(shader);
+			return 0;
+		}
+
+		return shader;
+	}
+
+	// reallocates buffer (driver gives new memory if GPU still reads old one) and maps it for writing
+	void* orphan_and_map(GLenum target, size_t size, size_t& capacity)
+	{
+		// grows in steps, so buffer size doesnt change every frame
+		if (size > capacity)
+			capacity = size + size / 2;
+
+		gl_buffer_data(target, GLsizeiptr(capacity), nullptr, GL_STREAM_DRAW);
+		return gl_map_buffer_range(target, 0, GLsizeiptr(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+
+	void render(ImDrawData* draw_data)
+	{
+		int framebuffer_width = int(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+		int framebuffer_height = int(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+
+		if (!ready || framebuffer_width <= 0 || framebuffer_height <= 0 || draw_data->TotalVtxCount == 0 || draw_data->TotalIdxCount == 0)
+			return;
+
+		glViewport(0, 0, framebuffer_width, framebuffer_height);
+
+		glEnable(GL_BLEND);
+		gl_blend_equation(GL_FUNC_ADD);
+		gl_blend_func_separate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_STENCIL_TEST);
+		glEnable(GL_SCISSOR_TEST);
+
+		float left = draw_data->DisplayPos.x;
+		float right = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
+		float top = draw_data->DisplayPos.y;
+		float bottom = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+
+		const float projection[16] =
+		{
+			2.0f / (right - left), 0.0f, 0.0f, 0.0f,
+			0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
+			0.0f, 0.0f, -1.0f, 0.0f,
+			(right + left) / (left - right), (top + bottom) / (bottom - top), 0.0f, 1.0f
+		};
+
+		gl_use_program(program);
+		gl_uniform_matrix_4fv(projection_location, 1, GL_FALSE, projection);
+
+		gl_active_texture(GL_TEXTURE0);
+
+		gl_bind_vertex_array(vertex_array);
+		gl_bind_buffer(GL_ARRAY_BUFFER, vertex_buffer);
+
+		// all draw lists in one upload per buffer
+		ImDrawVert* vertices = (ImDrawVert*)orphan_and_map(GL_ARRAY_BUFFER, size_t(draw_data->TotalVtxCount) * sizeof(ImDrawVert), vertex_buffer_capacity);
+		ImDrawIdx* indices = (ImDrawIdx*)orphan_and_map(GL_ELEMENT_ARRAY_BUFFER, size_t(draw_data->TotalIdxCount) * sizeof(ImDrawIdx), index_buffer_capacity);
+
+		bool vertices_mapped = vertices != nullptr;
+		bool indices_mapped = indices != nullptr;
+
+		if (vertices_mapped && indices_mapped)
+		{
+			for (int i = 0; i < draw_data->CmdListsCount; i++)
+			{
+				const ImDrawList* draw_list = draw_data->CmdLists[i];
+
+				memcpy(vertices, draw_list->VtxBuffer.Data, size_t(draw_list->VtxBuffer.Size) * sizeof(ImDrawVert));
+				memcpy(indices, draw_list->IdxBuffer.Data, size_t(draw_list->IdxBuffer.Size) * sizeof(ImDrawIdx));
+
+				vertices += draw_list->VtxBuffer.Size;
+				indices += draw_list->IdxBuffer.Size;
+			}
+		}
+
+		// unmapping buffer which isnt mapped raises GL_INVALID_OPERATION
+		bool unmapped = true;
+
+		if (vertices_mapped)
+			unmapped = gl_unmap_buffer(GL_ARRAY_BUFFER) == GL_TRUE;
+
+		if (indices_mapped)
+			unmapped = gl_unmap_buffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE && unmapped;
+
+		// buffer contents are undefined if mapping failed or was lost, frame is skipped
+		if (vertices_mapped && indices_mapped && unmapped)
+			draw_commands(draw_data, framebuffer_height);
+
+		gl_bind_vertex_array(0);
+		gl_bind_buffer(GL_ARRAY_BUFFER, 0);
+		gl_use_program(0);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// window clear respects scissor
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	void draw_commands(ImDrawData* draw_data, int framebuffer_height)
+	{
+		ImVec2 clip_offset = draw_data->DisplayPos;
+		ImVec2 clip_scale = draw_data->FramebufferScale;
+
+		int vertex_offset = 0;
+		size_t index_offset = 0;
+
+		GLuint bound_texture = 0;
+		bool texture_bound = false;
+
+		int scissor[4] = { -1, -1, -1, -1 };
+
+		for (int i = 0; i < draw_data->CmdListsCount; i++)
+		{
+			const ImDrawList* draw_list = draw_data->CmdLists[i];
+
+			for (int c = 0; c < draw_list->CmdBuffer.Size; c++)
+			{
+				const ImDrawCmd& cmd = draw_list->CmdBuffer[c];
+
+				// callbacks of this game dont touch GL
+				if (cmd.UserCallback)
+				{
+					if (cmd.UserCallback != ImDrawCallback_ResetRenderState)
+						cmd.UserCallback(draw_list, &cmd);
+
+					continue;
+				}
+
+				float clip_min_x = (cmd.ClipRect.x - clip_offset.x) * clip_scale.x;
+				float clip_min_y = (cmd.ClipRect.y - clip_offset.y) * clip_scale.y;
+				float clip_max_x = (cmd.ClipRect.z - clip_offset.x) * clip_scale.x;
+				float clip_max_y = (cmd.ClipRect.w - clip_offset.y) * clip_scale.y;
+
+				if (clip_max_x <= clip_min_x || clip_max_y <= clip_min_y)
+					continue;
+
+				int new_scissor[4] = { int(clip_min_x), int(framebuffer_height - clip_max_y), int(clip_max_x - clip_min_x), int(clip_max_y - clip_min_y) };
+
+				if (memcmp(scissor, new_scissor, sizeof(scissor)) != 0)
+				{
+					memcpy(scissor, new_scissor, sizeof(scissor));
+					glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+				}
+
+				GLuint texture;
+				memcpy(&texture, &cmd.TextureId, sizeof(GLuint));
+
+				if (!texture_bound || texture != bound_texture)
+				{
+					glBindTexture(GL_TEXTURE_2D, texture);
+
+					bound_texture = texture;
+					texture_bound = true;
+				}
+
+				gl_draw_elements_base_vertex(GL_TRIANGLES, GLsizei(cmd.ElemCount), sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+					(const void*)((index_offset + cmd.IdxOffset) * sizeof(ImDrawIdx)), GLint(vertex_offset + cmd.VtxOffset));
+			}
+
+			vertex_offset += draw_list->VtxBuffer.Size;
+			index_offset += draw_list->IdxBuffer.Size;
+		}
+	}
+
+	bool ready = false;
+
+	GLuint program = 0;
+	GLint projection_location = -1;
+
+	GLuint vertex_array = 0;
+	GLuint vertex_buffer = 0;
+	GLuint index_buffer = 0;
+
+	size_t vertex_buffer_capacity = 0;
+	size_t index_buffer_capacity = 0;
+
+	PFN_GL_GEN_VERTEX_ARRAYS gl_gen_vertex_arrays = nullptr;
+	PFN_GL_BIND_VERTEX_ARRAY gl_bind_vertex_array = nullptr;
+	PFN_GL_DELETE_VERTEX_ARRAYS gl_delete_vertex_arrays = nullptr;
+	PFN_GL_GEN_BUFFERS gl_gen_buffers = nullptr;
+	PFN_GL_BIND_BUFFER gl_bind_buffer = nullptr;
+	PFN_GL_DELETE_BUFFERS gl_delete_buffers = nullptr;
+	PFN_GL_BUFFER_DATA gl_buffer_data = nullptr;
+	PFN_GL_MAP_BUFFER_RANGE gl_map_buffer_range = nullptr;
+	PFN_GL_UNMAP_BUFFER gl_unmap_buffer = nullptr;
+	PFN_GL_ENABLE_VERTEX_ATTRIB_ARRAY gl_enable_vertex_attrib_array = nullptr;
+	PFN_GL_VERTEX_ATTRIB_POINTER gl_vertex_attrib_pointer = nullptr;
+	PFN_GL_CREATE_SHADER gl_create_shader = nullptr;
+	PFN_GL_SHADER_SOURCE gl_shader_source = nullptr;
+	PFN_GL_COMPILE_SHADER gl_compile_shader = nullptr;
+	PFN_GL_GET_SHADERIV gl_get_shaderiv = nullptr;
+	PFN_GL_DELETE_SHADER gl_delete_shader = nullptr;
+	PFN_GL_CREATE_PROGRAM gl_create_program = nullptr;
+	PFN_GL_ATTACH_SHADER gl_attach_shader = nullptr;
+	PFN_GL_LINK_PROGRAM gl_link_program = nullptr;
+	PFN_GL_GET_PROGRAMIV gl_get_programiv = nullptr;
+	PFN_GL_DELETE_PROGRAM gl_delete_program = nullptr;
+	PFN_GL_USE_PROGRAM gl_use_program = nullptr;
+	PFN_GL_GET_UNIFORM_LOCATION gl_get_uniform_location = nullptr;
+	PFN_GL_UNIFORM_1I gl_uniform_1i = nullptr;
+	PFN_GL_UNIFORM_MATRIX_4FV gl_uniform_matrix_4fv = nullptr;
+	PFN_GL_ACTIVE_TEXTURE gl_active_texture = nullptr;
+	PFN_GL_BLEND_EQUATION gl_blend_equation = nullptr;
+	PFN_GL_BLEND_FUNC_SEPARATE gl_blend_func_separate = nullptr;
+	PFN_GL_DRAW_ELEMENTS_BASE_VERTEX gl_draw_elements_base_vertex = nullptr;
+};
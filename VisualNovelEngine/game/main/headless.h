@@ -0,0 +1,242 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+#include "../../imgui/imgui.h"
+
+#include "frame_profiler.h"
+#include "render_stats.h"
+
+// Script line: "<frame> <command> [arguments]", # starts comment. Commands:
+//   mouse <x> <y> - move mouse
+//   click <x> <y> - move mouse and click left button
+//   key <name> - press key (space, escape, enter, tab, backspace, up, down, left, right)
+//   text <text> - type rest of line
+//   start <scenario> <player> - start scenario file as player, skipping intro and main menu
+//   screenshot - draw frame on CPU to game\screenshots, see SoftwareRasterizer_t
+//   quit - last frame
+struct HeadlessInputEvent_t
+{
+	int frame = 0;
+	std::string command;
+
+	float x = 0.0f;
+	float y = 0.0f;
+
+	std::string name; // key, scenario
+	std::string text; // typed text, player
+};
+
+struct HeadlessFrameStats_t
+{
+	FrameProfilerSample_t sample;
+
+	int vertices = 0;
+	int indices = 0;
+	int draw_calls = 0;
+	int texture_switches = 0;
+};
+
+// Drives game frames without window and GPU: fixed display size and delta time, scripted input. Draw data is only
+// counted, see RenderStats_t.
+struct HeadlessRun_t
+{
+	bool load_script(const std::wstring& path)
+	{
+		std::ifstream file(path);
+
+		if (!file.is_open())
+			return false;
+
+		std::string line;
+
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line.at(0) == '#')
+				continue;
+
+			std::istringstream stream(line);
+			HeadlessInputEvent_t event;
+
+			if (!(stream >> event.frame >> event.command))
+				continue;
+
+			if (event.command == "mouse" || event.command == "click")
+				stream >> event.x >> event.y;
+			else if (event.command == "key")
+				stream >> event.name;
+			else if (event.command == "start")
+				stream >> event.name >> event.text;
+			else if (event.command == "text")
+				std::getline(stream >> std::ws, event.text);
+			else if (event.command == "quit")
+				frames = event.frame + 1;
+
+			events.push_back(event);
+		}
+
+		return true;
+	}
+
+	bool has_command(const std::string& command)
+	{
+		for (int i = 0; i < events.size(); i++)
+		{
+			if (events.at(i).command == command)
+				return true;
+		}
+
+		return false;
+	}
+
+	template <class F>
+	void for_each_event(int frame, F callback)
+	{
+		for (int i = 0; i < events.size(); i++)
+		{
+			if (events.at(i).frame == frame)
+				callback(events.at(i));
+		}
+	}
+
+	static ImGuiKey get_key(const std::string& name)
+	{
+		if (name == "space")
+			return ImGuiKey_Space;
+
+		if (name == "escape")
+			return ImGuiKey_Escape;
+
+		if (name == "enter")
+			return ImGuiKey_Enter;
+
+		if (name == "tab")
+			return ImGuiKey_Tab;
+
+		if (name == "backspace")
+			return ImGuiKey_Backspace;
+
+		if (name == "up")
+			return ImGuiKey_UpArrow;
+
+		if (name == "down")
+			return ImGuiKey_DownArrow;
+
+		if (name == "left")
+			return ImGuiKey_LeftArrow;
+
+		if (name == "right")
+			return ImGuiKey_RightArrow;
+
+		return ImGuiKey_None;
+	}
+
+	// keys and mouse button pressed last frame go up, so every press is seen as one click
+	void release_input(ImGuiIO& io)
+	{
+		for (int i = 0; i < held_keys.size(); i++)
+			io.AddKeyEvent(held_keys.at(i), false);
+
+		held_keys.clear();
+
+		if (mouse_held)
+			io.AddMouseButtonEvent(0, false);
+
+		mouse_held = false;
+	}
+
+	// false for commands which arent input
+	bool apply_input(ImGuiIO& io, const HeadlessInputEvent_t& event)
+	{
+		if (event.command == "mouse" || event.command == "click")
+		{
+			io.AddMousePosEvent(event.x, event.y);
+
+			if (event.command == "click")
+			{
+				io.AddMouseButtonEvent(0, true);
+				mouse_held = true;
+			}
+
+			return true;
+		}
+
+		if (event.command == "key")
+		{
+			ImGuiKey key = get_key(event.name);
+
+			if (key != ImGuiKey_None)
+			{
+				io.AddKeyEvent(key, true);
+				held_keys.push_back(key);
+			}
+
+			return true;
+		}
+
+		if (event.command == "text")
+		{
+			io.AddInputCharactersUTF8(event.text.c_str());
+			return true;
+		}
+
+		return false;
+	}
+
+	void add_frame(const FrameProfilerSample_t& sample, const RenderStats_t& render_stats)
+	{
+		HeadlessFrameStats_t frame_stats;
+
+		frame_stats.sample = sample;
+
+		frame_stats.vertices = render_stats.vertices;
+		frame_stats.indices = render_stats.indices;
+		frame_stats.draw_calls = render_stats.draw_calls;
+		frame_stats.texture_switches = render_stats.texture_switches;
+
+		stats.push_back(frame_stats);
+	}
+
+	bool write_csv(const std::wstring& path)
+	{
+		std::ofstream file(path, std::ios::trunc);
+
+		if (!file.is_open())
+			return false;
+
+		file << "frame,cpu_ms,allocations,vertices,indices,draw_calls,texture_switches";
+
+		for (int i = 0; i < FRAME_PHASE_COUNT; i++)
+			file << "," << FRAME_PHASE_NAMES[i];
+
+		file << "\n";
+
+		for (int i = 0; i < stats.size(); i++)
+		{
+			HeadlessFrameStats_t& frame_stats = stats.at(i);
+
+			file << i << "," << frame_stats.sample.frame_ms << "," << frame_stats.sample.allocations << "," << frame_stats.vertices << "," << frame_stats.indices << "," << frame_stats.draw_calls << "," << frame_stats.texture_switches;
+
+			for (int c = 0; c < FRAME_PHASE_COUNT; c++)
+				file << "," << frame_stats.sample.phase_ms[c];
+
+			file << "\n";
+		}
+
+		return file.good();
+	}
+
+	ImVec2 display_size = ImVec2(1280, 720);
+	float delta_time = 1.0f / 60.0f;
+
+	// changed by quit command
+	int frames = 600;
+
+	std::vector<HeadlessInputEvent_t> events;
+	std::vector<HeadlessFrameStats_t> stats;
+
+	std::vector<ImGuiKey> held_keys;
+	bool mouse_held = false;
+};
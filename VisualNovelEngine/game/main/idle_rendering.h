@@ -0,0 +1,140 @@
+#pragma once
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <Windows.h>
+
+// frames keep being rebuilt this long after last input or animation, so imgui can finish hover and window fade effects
+const float IDLE_RENDERING_SETTLE_TIME = 0.25f;
+
+// Stops rebuilding frames while nothing on screen changes, main loop blocks on window messages instead. Anything
+// animated calls keep_awake every frame it changes the picture, anything that changes it later (text being revealed)
+// asks for frame with wake_after. Worker threads call wake when render thread has their results to apply. Music and
+// discord presence dont need frames, idle loop doesnt wake without reason.
+struct IdleRendering_t
+{
+	IdleRendering_t()
+	{
+		wake_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+	}
+
+	~IdleRendering_t()
+	{
+		if (wake_event)
+			CloseHandle(wake_event);
+	}
+
+	void keep_awake()
+	{
+		animating = true;
+	}
+
+	// frame is needed in given time, earliest request of frame counts
+	void wake_after(float seconds)
+	{
+		auto time = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(seconds));
+
+		if (!frame_wake_requested || time < frame_wake_time)
+			frame_wake_time = time;
+
+		frame_wake_requested = true;
+	}
+
+	// any thread, wakes idle loop or makes its next wait return at once
+	void wake()
+	{
+		SetEvent(wake_event);
+	}
+
+	// called once per frame after everything was built
+	void end_frame(bool had_input)
+	{
+		if (had_input || animating)
+			last_activity = std::chrono::steady_clock::now();
+
+		animating = false;
+
+		// requests of last built frame, older ones are stale
+		timer_requested = frame_wake_requested;
+		timer_time = frame_wake_time;
+
+		frame_wake_requested = false;
+	}
+
+	bool should_wait()
+	{
+		return std::chrono::duration<float>(std::chrono::steady_clock::now() - last_activity).count() >= IDLE_RENDERING_SETTLE_TIME;
+	}
+
+	// blocks until message arrives to thread queue, worker calls wake or frame asked by wake_after is due
+	void wait()
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		DWORD timeout = INFINITE;
+
+		if (timer_requested)
+			timeout = DWORD(std::max(std::ceil(std::chrono::duration<float, std::milli>(timer_time - start).count()), 0.0f));
+
+		DWORD result = MsgWaitForMultipleObjectsEx(1, &wake_event, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+
+		wake_time = std::chrono::steady_clock::now();
+		idle_seconds += std::chrono::duration<double>(wake_time - start).count();
+
+		if (result == WAIT_OBJECT_0 + 1)
+		{
+			waking = true;
+			wakes++;
+		}
+		else if (result == WAIT_OBJECT_0)
+		{
+			// results of workers can open new imgui windows, they take few frames to settle like input
+			last_activity = wake_time;
+			worker_wakes++;
+		}
+		else if (result == WAIT_TIMEOUT)
+		{
+			timer_requested = false;
+			timer_wakes++;
+		}
+	}
+
+	// first frame after input woke the loop is on screen, time since wake up is the latency player notices
+	void frame_presented()
+	{
+		if (!waking)
+			return;
+
+		waking = false;
+
+		wake_latency_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - wake_time).count();
+		max_wake_latency_ms = std::max(max_wake_latency_ms, wake_latency_ms);
+	}
+
+	HANDLE wake_event = NULL;
+
+	bool animating = false;
+	bool waking = false;
+
+	// wake_after of frame being built, and of last built frame which wait uses
+	bool frame_wake_requested = false;
+	bool timer_requested = false;
+
+	std::chrono::steady_clock::time_point frame_wake_time;
+	std::chrono::steady_clock::time_point timer_time;
+
+	std::chrono::steady_clock::time_point last_activity = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point wake_time;
+
+	float wake_latency_ms = 0.0f;
+	float max_wake_latency_ms = 0.0f;
+
+	// by input, workers and wake_after
+	uint64_t wakes = 0;
+	uint64_t worker_wakes = 0;
+	uint64_t timer_wakes = 0;
+
+	double idle_seconds = 0.0;
+};
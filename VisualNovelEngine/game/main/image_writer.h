@@ -0,0 +1,131 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "software_rasterizer.h"
+#include "trace.h"
+
+struct ImageWriteJob_t
+{
+	std::string path;
+
+	int width = 0;
+	int height = 0;
+
+	// RGBA8, see SoftwareRasterizer_t
+	std::vector<uint32_t> pixels;
+};
+
+// Encodes and writes PNG images on worker threads. Queue is bounded, so frames cant pile up in memory faster than
+// they are written.
+struct ImageWriter_t
+{
+	~ImageWriter_t()
+	{
+		finish();
+	}
+
+	void start(int worker_count, int max_queued_images)
+	{
+		if (workers.size() > 0)
+			return;
+
+		stopping = false;
+		max_queued = max_queued_images > 0 ? max_queued_images : 1;
+
+		for (int i = 0; i < worker_count; i++)
+			workers.emplace_back(&ImageWriter_t::worker_thread, this);
+	}
+
+	// blocks while queue is full
+	void write(ImageWriteJob_t& job)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queue_changed.wait(lock, [this] { return queued.size() < max_queued; });
+
+			queued.push_back(std::move(job));
+		}
+
+		queue_changed.notify_all();
+	}
+
+	// writes queued images and stops workers
+	void finish()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		queue_changed.notify_all();
+
+		for (int i = 0; i < workers.size(); i++)
+		{
+			if (workers.at(i).joinable())
+				workers.at(i).join();
+		}
+
+		workers.clear();
+	}
+
+	void worker_thread()
+	{
+		tracer.set_thread_name("Image writer");
+
+		while (true)
+		{
+			ImageWriteJob_t job;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				queue_changed.wait(lock, [this] { return stopping || !queued.empty(); });
+
+				if (queued.empty())
+					return;
+
+				job = std::move(queued.front());
+				queued.pop_front();
+			}
+
+			queue_changed.notify_all();
+
+			bool result;
+
+			{
+				TraceScope_t trace_scope("write_rgba_png");
+				result = write_rgba_png(job.path, job.width, job.height, job.pixels);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (result)
+				written++;
+			else
+			{
+				failed++;
+				failed_paths.push_back(job.path);
+			}
+		}
+	}
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable queue_changed;
+
+	std::deque<ImageWriteJob_t> queued;
+	size_t max_queued = 1;
+
+	bool stopping = false;
+
+	int written = 0;
+	int failed = 0;
+
+	std::vector<std::string> failed_paths;
+};
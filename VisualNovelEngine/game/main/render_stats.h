@@ -0,0 +1,48 @@
+#pragma once
+#include "../../imgui/imgui.h"
+
+// Draw calls and texture switches of last rendered frame, collected from imgui draw data.
+struct RenderStats_t
+{
+	void collect(ImDrawData* draw_data)
+	{
+		draw_calls = 0;
+		texture_switches = 0;
+		vertices = 0;
+		indices = 0;
+
+		if (!draw_data)
+			return;
+
+		ImTextureID last_texture = (ImTextureID)NULL;
+
+		for (int i = 0; i < draw_data->CmdListsCount; i++)
+		{
+			const ImDrawList* draw_list = draw_data->CmdLists[i];
+
+			vertices += draw_list->VtxBuffer.Size;
+			indices += draw_list->IdxBuffer.Size;
+
+			for (int c = 0; c < draw_list->CmdBuffer.Size; c++)
+			{
+				const ImDrawCmd& command = draw_list->CmdBuffer[c];
+
+				if (command.UserCallback)
+					continue;
+
+				draw_calls++;
+
+				if (command.GetTexID() != last_texture)
+				{
+					texture_switches++;
+					last_texture = command.GetTexID();
+				}
+			}
+		}
+	}
+
+	int draw_calls = 0;
+	int texture_switches = 0;
+	int vertices = 0;
+	int indices = 0;
+};
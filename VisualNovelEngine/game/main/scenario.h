@@ -1,36 +1,111 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <Windows.h>
 #include <D3DX11.h>
 #include <vector>
+#include <cstdint>
 
 #include <SFML/Graphics.hpp>
 
 #include "../config.h"
+#include "scenario_names.h"
+#include "texture_registry.h"
+#include "texture_atlas.h"
 
 struct ScenarioTexture_t
 {
 #ifndef DCS_OPENGL
-	ID3D11ShaderResourceView* texture_data;
+	ID3D11ShaderResourceView* texture_data = nullptr;
 #else
 	sf::Texture texture_data;
 #endif
 
 	std::wstring texture_name;
+	std::wstring texture_path;
+
+	// size of source image, texture itself can be downscaled
+	unsigned width = 0;
+	unsigned height = 0;
+
+	// character textures are trimmed and uploaded into atlas page of their scenario
+	bool character_texture = false;
+
+	// uv is rectangle of texture in atlas page
+	TextureAtlasPage_t* atlas_page = nullptr;
+
+	float uv_min[2] = { 0.0f, 0.0f };
+	float uv_max[2] = { 1.0f, 1.0f };
+
+	// rectangle of trimmed texture in its full image, relative to full image size
+	float trim_min[2] = { 0.0f, 0.0f };
+	float trim_max[2] = { 1.0f, 1.0f };
+
+	// set once decoded texture was uploaded, placeholder is drawn until then
+	bool ready = false;
+
+	bool loading = false;
+	bool failed = false;
+
+	size_t memory_size = 0;
+
+	uint64_t last_used_frame = 0;
+	uint64_t prefetch_frame = 0;
+
+	// composite textures are made of these textures blended in order, instead of being loaded from texture_path
+	std::vector<TextureHandle_t> layers;
 };
 
 struct ScenarioDialogueScenePersonData_t
 {
 	std::wstring person_name;
-	std::wstring person_texture;
 
-	std::wstring person_texture_left;
-	std::wstring person_texture_right;
-	std::wstring person_texture_head;
+	// names are interned in scenario_name_table
+	std::wstring_view person_texture;
+
+	std::wstring_view person_texture_left;
+	std::wstring_view person_texture_right;
+	std::wstring_view person_texture_head;
+
+	TextureHandle_t person_texture_handle = INVALID_TEXTURE_HANDLE;
+
+	TextureHandle_t person_texture_left_handle = INVALID_TEXTURE_HANDLE;
+	TextureHandle_t person_texture_right_handle = INVALID_TEXTURE_HANDLE;
+	TextureHandle_t person_texture_head_handle = INVALID_TEXTURE_HANDLE;
+
+	// left, right and head parts flattened into one texture, invalid if there is only one part
+	TextureHandle_t person_composite_handle = INVALID_TEXTURE_HANDLE;
 
 	bool talking;
 	std::wstring talking_text;
 
+	template <class F>
+	void for_each_texture(F callback)
+	{
+		callback(person_texture_handle);
+
+		if (person_composite_handle != INVALID_TEXTURE_HANDLE)
+		{
+			callback(person_composite_handle);
+			return;
+		}
+
+		callback(person_texture_left_handle);
+		callback(person_texture_right_handle);
+		callback(person_texture_head_handle);
+	}
+
+	void resolve_textures(const TextureRegistry_t& registry)
+	{
+		person_texture_handle = registry.find(person_texture);
+
+		person_texture_left_handle = registry.find(person_texture_left);
+		person_texture_right_handle = registry.find(person_texture_right);
+		person_texture_head_handle = registry.find(person_texture_head);
+
+		person_composite_handle = INVALID_TEXTURE_HANDLE;
+	}
+
 	bool is_valid_name()
 	{
 		if (person_name != L"NONE")
@@ -80,7 +155,12 @@ struct ScenarioDialogueSceneScriptAction_t
 struct ScenarioDialogueSceneButton_t
 {
 	std::wstring button_name;
-	std::wstring button_scenario_to_load;
+
+	// interned
+	std::wstring_view button_scenario_to_load;
+
+	// index of button_scenario_to_load in scenarios, resolved once scenario is loaded
+	int scenario_to_load_idx = -1;
 
 	ScenarioDialogueSceneScriptAction_t button_script_callback;
 
@@ -107,12 +187,13 @@ struct ScenarioDialogueScene_t
 	{
 	};
 
-	std::wstring background_texture;
-	std::wstring background_overlay_texture;
+	// names are interned in scenario_name_table
+	std::wstring_view background_texture;
+	std::wstring_view background_overlay_texture;
 
-	std::wstring background_music;
+	std::wstring_view background_music;
 
-	std::wstring additional_scene_sound;
+	std::wstring_view additional_scene_sound;
 
 	ScenarioDialogueScenePersonData_t person1;
 	ScenarioDialogueScenePersonData_t person2;
@@ -126,7 +207,62 @@ struct ScenarioDialogueScene_t
 	ScenarioDialogueSceneButton_t button3;
 	ScenarioDialogueSceneButton_t button4;
 
-	std::wstring overlay_texture;
+	std::wstring_view overlay_texture;
+
+	TextureHandle_t background_texture_handle = INVALID_TEXTURE_HANDLE;
+	TextureHandle_t background_overlay_texture_handle = INVALID_TEXTURE_HANDLE;
+	TextureHandle_t overlay_texture_handle = INVALID_TEXTURE_HANDLE;
+
+	// calls callback for every texture handle used by scene, in drawing order
+	template <class F>
+	void for_each_texture(F callback)
+	{
+		callback(background_texture_handle);
+		callback(background_overlay_texture_handle);
+
+		for_each_character_texture(callback);
+
+		callback(overlay_texture_handle);
+	}
+
+	template <class F>
+	void for_each_character_texture(F callback)
+	{
+		person1.for_each_texture(callback);
+		person2.for_each_texture(callback);
+		person3.for_each_texture(callback);
+		person4.for_each_texture(callback);
+	}
+
+	template <class F>
+	void for_each_person(F callback)
+	{
+		callback(person1);
+		callback(person2);
+		callback(person3);
+		callback(person4);
+	}
+
+	template <class F>
+	void for_each_button(F callback)
+	{
+		callback(button1);
+		callback(button2);
+		callback(button3);
+		callback(button4);
+	}
+
+	void resolve_textures(const TextureRegistry_t& registry)
+	{
+		background_texture_handle = registry.find(background_texture);
+		background_overlay_texture_handle = registry.find(background_overlay_texture);
+		overlay_texture_handle = registry.find(overlay_texture);
+
+		person1.resolve_textures(registry);
+		person2.resolve_textures(registry);
+		person3.resolve_textures(registry);
+		person4.resolve_textures(registry);
+	}
 };
 
 struct Scenario_t
@@ -140,7 +276,16 @@ struct Scenario_t
 	std::vector<ScenarioTexture_t> textures;
 	std::vector<ScenarioDialogueScene_t> scenes;
 
+	TextureRegistry_t texture_registry;
+	TextureAtlas_t texture_atlas;
+
+	// changes every time textures are (re)loaded, used to drop stale async loads
+	int texture_generation = 0;
+
 	bool loaded;
+
+	// queued to scenario_loader
+	bool loading = false;
 };
 
 struct GameSave_t
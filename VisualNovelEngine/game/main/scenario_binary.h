@@ -0,0 +1,469 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+
+#include <Windows.h>
+
+#include "scenario.h"
+#include "../file_features.h"
+
+// Compiled scenario (.scb) layout:
+// header | scene table (offset of every scene record) | scene records | string table | string data
+// Scene records store string ids, strings are interned and stored once as UTF-16 code units.
+// Compiled scenario is used only while write time and size of text scenario match the header. Text scenarios from
+// patches or archives keep their own write time, which may be older than compiled scenario of previous version.
+
+static_assert(sizeof(wchar_t) == 2, "compiled scenarios store UTF-16 strings");
+
+const char SCENARIO_BINARY_MAGIC[4] = { 'D', 'S', 'C', 'B' };
+const uint32_t SCENARIO_BINARY_VERSION = 2;
+
+const uint32_t SCENARIO_BINARY_FLAG_ADVANCED_SCENES = 1 << 0;
+
+struct ScenarioBinaryHeader_t
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t flags;
+
+	uint32_t scene_count;
+	uint32_t scene_table_offset;
+
+	uint32_t string_count;
+	uint32_t string_table_offset;
+
+	uint32_t string_data_offset;
+	uint32_t string_data_size;
+
+	uint32_t padding;
+
+	uint64_t source_write_time;
+	uint64_t source_size;
+};
+
+struct ScenarioBinaryString_t
+{
+	uint32_t offset; // in wchar_t units from string data start
+	uint32_t length;
+};
+
+struct ScenarioBinaryPerson_t
+{
+	uint32_t person_name;
+	uint32_t person_texture;
+
+	uint32_t person_texture_left;
+	uint32_t person_texture_right;
+	uint32_t person_texture_head;
+
+	uint32_t talking_text;
+	uint32_t talking;
+};
+
+struct ScenarioBinaryButton_t
+{
+	uint32_t button_name;
+	uint32_t button_scenario_to_load;
+};
+
+struct ScenarioBinaryScene_t
+{
+	uint32_t background_texture;
+	uint32_t background_overlay_texture;
+
+	uint32_t background_music;
+	uint32_t additional_scene_sound;
+
+	ScenarioBinaryPerson_t persons[4];
+
+	uint32_t main_character_text;
+	uint32_t main_character_talking;
+
+	ScenarioBinaryButton_t buttons[4];
+
+	uint32_t overlay_texture;
+};
+
+// read only memory mapped view of compiled scenario
+struct ScenarioBinaryFile_t
+{
+	ScenarioBinaryFile_t()
+	{
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+
+		data = nullptr;
+		size = 0;
+
+		header = nullptr;
+	}
+
+	~ScenarioBinaryFile_t()
+	{
+		close();
+	}
+
+	bool open(const std::wstring& path);
+	void close();
+
+	uint32_t scene_count()
+	{
+		return header ? header->scene_count : 0;
+	}
+
+	const ScenarioBinaryScene_t* scene(uint32_t idx)
+	{
+		const uint32_t* scene_table = (const uint32_t*)(data + header->scene_table_offset);
+		return (const ScenarioBinaryScene_t*)(data + scene_table[idx]);
+	}
+
+	// points directly into mapped file
+	std::wstring_view string(uint32_t id)
+	{
+		const ScenarioBinaryString_t* string_table = (const ScenarioBinaryString_t*)(data + header->string_table_offset);
+		const wchar_t* string_data = (const wchar_t*)(data + header->string_data_offset);
+
+		if (id >= header->string_count)
+			return std::wstring_view();
+
+		return std::wstring_view(string_data + string_table[id].offset, string_table[id].length);
+	}
+
+	HANDLE file;
+	HANDLE mapping;
+
+	const uint8_t* data;
+	uint64_t size;
+
+	const ScenarioBinaryHeader_t* header;
+};
+
+void ScenarioBinaryFile_t::close()
+{
+	if (data)
+		UnmapViewOfFile(data);
+
+	if (mapping)
+		CloseHandle(mapping);
+
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+
+	data = nullptr;
+	size = 0;
+
+	header = nullptr;
+}
+
+bool ScenarioBinaryFile_t::open(const std::wstring& path)
+{
+	close();
+
+	file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < sizeof(ScenarioBinaryHeader_t))
+	{
+		close();
+		return false;
+	}
+
+	mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (!mapping)
+	{
+		close();
+		return false;
+	}
+
+	data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!data)
+	{
+		close();
+		return false;
+	}
+
+	size = file_size.QuadPart;
+	header = (const ScenarioBinaryHeader_t*)data;
+
+	// validate everything once so accessors dont have to
+	bool valid = memcmp(header->magic, SCENARIO_BINARY_MAGIC, sizeof(SCENARIO_BINARY_MAGIC)) == 0 && header->version == SCENARIO_BINARY_VERSION;
+
+	valid = valid && uint64_t(header->scene_table_offset) + uint64_t(header->scene_count) * sizeof(uint32_t) <= size;
+	valid = valid && uint64_t(header->string_table_offset) + uint64_t(header->string_count) * sizeof(ScenarioBinaryString_t) <= size;
+	valid = valid && uint64_t(header->string_data_offset) + uint64_t(header->string_data_size) * sizeof(wchar_t) <= size;
+
+	for (uint32_t i = 0; valid && i < header->scene_count; i++)
+	{
+		const uint32_t* scene_table = (const uint32_t*)(data + header->scene_table_offset);
+		valid = uint64_t(scene_table[i]) + sizeof(ScenarioBinaryScene_t) <= size;
+	}
+
+	for (uint32_t i = 0; valid && i < header->string_count; i++)
+	{
+		const ScenarioBinaryString_t* string_table = (const ScenarioBinaryString_t*)(data + header->string_table_offset);
+		valid = uint64_t(string_table[i].offset) + string_table[i].length <= header->string_data_size;
+	}
+
+	if (!valid)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+// .sc -> .scb
+std::wstring get_compiled_scenario_path(const std::wstring& scenario_path)
+{
+	return scenario_path + L"b";
+}
+
+struct ScenarioBinaryStringPool_t
+{
+	// str has to outlive pool, it is kept as key
+	uint32_t intern(std::wstring_view str)
+	{
+		auto it = ids.find(str);
+
+		if (it != ids.end())
+			return it->second;
+
+		ScenarioBinaryString_t entry;
+
+		entry.offset = data.size();
+		entry.length = str.length();
+
+		data.insert(data.end(), str.begin(), str.end());
+		table.push_back(entry);
+
+		uint32_t id = table.size() - 1;
+		ids.emplace(str, id);
+
+		return id;
+	}
+
+	std::unordered_map<std::wstring_view, uint32_t> ids;
+
+	std::vector<ScenarioBinaryString_t> table;
+	std::vector<wchar_t> data;
+};
+
+ScenarioBinaryPerson_t compile_scenario_person(ScenarioBinaryStringPool_t& pool, const ScenarioDialogueScenePersonData_t& person)
+{
+	ScenarioBinaryPerson_t p;
+
+	p.person_name = pool.intern(person.person_name);
+	p.person_texture = pool.intern(person.person_texture);
+
+	p.person_texture_left = pool.intern(person.person_texture_left);
+	p.person_texture_right = pool.intern(person.person_texture_right);
+	p.person_texture_head = pool.intern(person.person_texture_head);
+
+	p.talking_text = pool.intern(person.talking_text);
+	p.talking = person.talking;
+
+	return p;
+}
+
+bool compile_scenario(const std::wstring& scenario_path, const std::vector<ScenarioDialogueScene_t>& scenes, bool advanced_scenes)
+{
+	ScenarioBinaryStringPool_t pool;
+	std::vector<ScenarioBinaryScene_t> records;
+
+	records.reserve(scenes.size());
+
+	for (int i = 0; i < scenes.size(); i++)
+	{
+		const ScenarioDialogueScene_t& scene = scenes.at(i);
+		ScenarioBinaryScene_t record;
+
+		record.background_texture = pool.intern(scene.background_texture);
+		record.background_overlay_texture = pool.intern(scene.background_overlay_texture);
+
+		record.background_music = pool.intern(scene.background_music);
+		record.additional_scene_sound = pool.intern(scene.additional_scene_sound);
+
+		record.persons[0] = compile_scenario_person(pool, scene.person1);
+		record.persons[1] = compile_scenario_person(pool, scene.person2);
+		record.persons[2] = compile_scenario_person(pool, scene.person3);
+		record.persons[3] = compile_scenario_person(pool, scene.person4);
+
+		record.main_character_text = pool.intern(scene.main_character.talking_text);
+		record.main_character_talking = scene.main_character.talking;
+
+		record.buttons[0] = { pool.intern(scene.button1.button_name), pool.intern(scene.button1.button_scenario_to_load) };
+		record.buttons[1] = { pool.intern(scene.button2.button_name), pool.intern(scene.button2.button_scenario_to_load) };
+		record.buttons[2] = { pool.intern(scene.button3.button_name), pool.intern(scene.button3.button_scenario_to_load) };
+		record.buttons[3] = { pool.intern(scene.button4.button_name), pool.intern(scene.button4.button_scenario_to_load) };
+
+		record.overlay_texture = pool.intern(scene.overlay_texture);
+
+		records.push_back(record);
+	}
+
+	ScenarioBinaryHeader_t header;
+
+	memcpy(header.magic, SCENARIO_BINARY_MAGIC, sizeof(SCENARIO_BINARY_MAGIC));
+	header.version = SCENARIO_BINARY_VERSION;
+	header.flags = advanced_scenes ? SCENARIO_BINARY_FLAG_ADVANCED_SCENES : 0;
+	header.padding = 0;
+
+	if (!get_file_stamp(scenario_path, header.source_write_time, header.source_size))
+		return false;
+
+	header.scene_count = records.size();
+	header.scene_table_offset = sizeof(ScenarioBinaryHeader_t);
+
+	uint32_t records_offset = header.scene_table_offset + header.scene_count * sizeof(uint32_t);
+
+	header.string_count = pool.table.size();
+	header.string_table_offset = records_offset + header.scene_count * sizeof(ScenarioBinaryScene_t);
+
+	header.string_data_offset = header.string_table_offset + header.string_count * sizeof(ScenarioBinaryString_t);
+	header.string_data_size = pool.data.size();
+
+	std::vector<uint32_t> scene_table(records.size());
+
+	for (int i = 0; i < scene_table.size(); i++)
+		scene_table.at(i) = records_offset + i * sizeof(ScenarioBinaryScene_t);
+
+	// written next to compiled scenario and moved over it, game reading old one never sees half written file
+	std::wstring path = get_compiled_scenario_path(scenario_path);
+	std::wstring temporary_path = path + L".tmp";
+
+	std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)scene_table.data(), scene_table.size() * sizeof(uint32_t));
+	file.write((const char*)records.data(), records.size() * sizeof(ScenarioBinaryScene_t));
+	file.write((const char*)pool.table.data(), pool.table.size() * sizeof(ScenarioBinaryString_t));
+	file.write((const char*)pool.data.data(), pool.data.size() * sizeof(wchar_t));
+
+	bool written = file.good();
+	file.close();
+
+	if (!written || !MoveFileExW(temporary_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(temporary_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+// Names of compiled scenario, every string id is interned once per file and its view is shared by all scenes using it.
+struct ScenarioBinaryNames_t
+{
+	ScenarioBinaryNames_t(ScenarioBinaryFile_t& file) : binary(file)
+	{
+		interned.resize(binary.header->string_count);
+	}
+
+	std::wstring_view get(uint32_t id)
+	{
+		if (id >= interned.size())
+			return std::wstring_view();
+
+		if (!interned.at(id).data())
+			interned.at(id) = scenario_name_table.intern(binary.string(id));
+
+		return interned.at(id);
+	}
+
+	ScenarioBinaryFile_t& binary;
+	std::vector<std::wstring_view> interned;
+};
+
+void load_compiled_scenario_person(ScenarioBinaryFile_t& binary, ScenarioBinaryNames_t& names, const ScenarioBinaryPerson_t& p, ScenarioDialogueScenePersonData_t& person)
+{
+	person.person_name = binary.string(p.person_name);
+	person.person_texture = names.get(p.person_texture);
+
+	person.person_texture_left = names.get(p.person_texture_left);
+	person.person_texture_right = names.get(p.person_texture_right);
+	person.person_texture_head = names.get(p.person_texture_head);
+
+	person.talking_text = binary.string(p.talking_text);
+	person.talking = p.talking;
+}
+
+// loads compiled scenario if it was compiled from current text scenario and for same scene mode
+bool load_compiled_scenario(const std::wstring& scenario_path, bool advanced_scenes, std::vector<ScenarioDialogueScene_t>& scenes)
+{
+	uint64_t write_time;
+	uint64_t size;
+
+	if (!get_file_stamp(scenario_path, write_time, size))
+		return false;
+
+	ScenarioBinaryFile_t binary;
+
+	if (!binary.open(get_compiled_scenario_path(scenario_path)))
+		return false;
+
+	if (binary.header->source_write_time != write_time || binary.header->source_size != size)
+		return false;
+
+	if (bool(binary.header->flags & SCENARIO_BINARY_FLAG_ADVANCED_SCENES) != advanced_scenes)
+		return false;
+
+	scenes.reserve(scenes.size() + binary.scene_count());
+
+	// names are views, only dialogue text, person and button names are copied into scenes
+	ScenarioBinaryNames_t names(binary);
+
+	for (uint32_t i = 0; i < binary.scene_count(); i++)
+	{
+		const ScenarioBinaryScene_t* record = binary.scene(i);
+		ScenarioDialogueScene_t scene;
+
+		scene.background_texture = names.get(record->background_texture);
+		scene.background_overlay_texture = names.get(record->background_overlay_texture);
+
+		scene.background_music = names.get(record->background_music);
+		scene.additional_scene_sound = names.get(record->additional_scene_sound);
+
+		load_compiled_scenario_person(binary, names, record->persons[0], scene.person1);
+		load_compiled_scenario_person(binary, names, record->persons[1], scene.person2);
+		load_compiled_scenario_person(binary, names, record->persons[2], scene.person3);
+		load_compiled_scenario_person(binary, names, record->persons[3], scene.person4);
+
+		scene.main_character.talking_text = binary.string(record->main_character_text);
+		scene.main_character.talking = record->main_character_talking;
+
+		scene.button1.button_name = binary.string(record->buttons[0].button_name);
+		scene.button1.button_scenario_to_load = names.get(record->buttons[0].button_scenario_to_load);
+
+		scene.button2.button_name = binary.string(record->buttons[1].button_name);
+		scene.button2.button_scenario_to_load = names.get(record->buttons[1].button_scenario_to_load);
+
+		scene.button3.button_name = binary.string(record->buttons[2].button_name);
+		scene.button3.button_scenario_to_load = names.get(record->buttons[2].button_scenario_to_load);
+
+		scene.button4.button_name = binary.string(record->buttons[3].button_name);
+		scene.button4.button_scenario_to_load = names.get(record->buttons[3].button_scenario_to_load);
+
+		scene.overlay_texture = names.get(record->overlay_texture);
+
+		scenes.push_back(std::move(scene));
+	}
+
+	return true;
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "scenario.h"
+#include "trace.h"
+
+struct ScenarioLoadJob_t
+{
+	int scenario_idx;
+
+	// ScenarioLoader_t::generation at queue time, results of cancelled loads are dropped
+	int generation;
+
+	std::wstring textures_dir;
+	std::wstring file_path;
+
+	// filled by worker
+	std::vector<ScenarioTexture_t> textures;
+	TextureRegistry_t texture_registry;
+
+	std::vector<ScenarioDialogueScene_t> scenes;
+};
+
+// Lists textures and parses scenes of scenarios on worker thread, render thread applies loaded scenarios to
+// Scenario_t between frames. One worker keeps loads in order of requests.
+struct ScenarioLoader_t
+{
+	typedef void (*LoadFunction_t)(ScenarioLoadJob_t& job);
+	typedef void (*ReadyFunction_t)();
+
+	~ScenarioLoader_t()
+	{
+		shutdown();
+	}
+
+	void start(LoadFunction_t load_function)
+	{
+		if (worker.joinable())
+			return;
+
+		load = load_function;
+		stopping = false;
+
+		worker = std::thread(&ScenarioLoader_t::worker_thread, this);
+	}
+
+	void shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			stopping = true;
+
+			pending.clear();
+			loaded.clear();
+		}
+
+		jobs_changed.notify_all();
+		loaded_changed.notify_all();
+
+		if (worker.joinable())
+			worker.join();
+	}
+
+	void queue(const ScenarioLoadJob_t& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			pending.push_back(job);
+			pending.back().generation = generation;
+		}
+
+		jobs_changed.notify_one();
+	}
+
+	// drops all queued and loaded scenarios, load in progress is dropped once it finishes
+	void cancel()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			pending.clear();
+			loaded.clear();
+
+			generation++;
+		}
+
+		loaded_changed.notify_all();
+	}
+
+	bool pop_loaded(ScenarioLoadJob_t& job)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (loaded.empty())
+			return false;
+
+		job = std::move(loaded.front());
+		loaded.pop_front();
+
+		return true;
+	}
+
+	// blocks until loaded scenario is there, false if nothing is being loaded
+	bool wait_loaded(ScenarioLoadJob_t& job)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		loaded_changed.wait(lock, [this] { return stopping || !loaded.empty() || (pending.empty() && loading == 0); });
+
+		if (loaded.empty())
+			return false;
+
+		job = std::move(loaded.front());
+		loaded.pop_front();
+
+		return true;
+	}
+
+	// loaded scenarios wait to be applied
+	bool has_loaded()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return loaded.size() > 0;
+	}
+
+	bool is_busy()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return pending.size() > 0 || loaded.size() > 0 || loading > 0;
+	}
+
+	void worker_thread()
+	{
+		tracer.set_thread_name("Scenario loader");
+
+		while (true)
+		{
+			ScenarioLoadJob_t job;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				jobs_changed.wait(lock, [this] { return stopping || !pending.empty(); });
+
+				if (stopping)
+					return;
+
+				job = std::move(pending.front());
+				pending.pop_front();
+
+				loading++;
+			}
+
+			load(job);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				loading--;
+
+				if (stopping)
+					return;
+
+				if (job.generation == generation)
+					loaded.push_back(std::move(job));
+			}
+
+			loaded_changed.notify_all();
+
+			if (ready)
+				ready();
+		}
+	}
+
+	std::thread worker;
+
+	std::mutex mutex;
+	std::condition_variable jobs_changed;
+	std::condition_variable loaded_changed;
+
+	std::deque<ScenarioLoadJob_t> pending;
+	std::deque<ScenarioLoadJob_t> loaded;
+
+	LoadFunction_t load = nullptr;
+
+	// called by worker after scenario was loaded, render thread may be waiting for it
+	ReadyFunction_t ready = nullptr;
+
+	int loading = 0;
+	int generation = 0;
+
+	bool stopping = false;
+};
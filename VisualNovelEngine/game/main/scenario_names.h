@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstring>
+
+// Names of textures, sounds and target scenarios repeat across scenes and scenarios, each is stored once and scenes
+// keep views of it. Stored names live until exit, so views stay valid when scenes are copied or reloaded. Scenarios
+// can be loaded on worker threads.
+struct ScenarioNameTable_t
+{
+	std::wstring_view intern(std::wstring_view name)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = names.find(name);
+
+		if (it != names.end())
+			return it->first;
+
+		std::unique_ptr<wchar_t[]> storage(new wchar_t[name.size() + 1]);
+
+		memcpy(storage.get(), name.data(), name.size() * sizeof(wchar_t));
+		storage[name.size()] = L'\0';
+
+		std::wstring_view stored(storage.get(), name.size());
+		names.emplace(stored, std::move(storage));
+
+		return stored;
+	}
+
+	// view key points into its own storage
+	std::unordered_map<std::wstring_view, std::unique_ptr<wchar_t[]>> names;
+	std::mutex mutex;
+};
+
+ScenarioNameTable_t scenario_name_table;
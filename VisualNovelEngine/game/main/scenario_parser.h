@@ -0,0 +1,195 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <locale>
+
+#include "scenario.h"
+#include "../string_features.h"
+
+// Single pass .sc reader. Scenes are produced one by one while the file is read, already read lines are never kept or copied.
+// Used by the game and by the scenario editor.
+struct ScenarioSceneReader_t
+{
+	ScenarioSceneReader_t(const std::wstring& path, const std::string& locale, bool advanced)
+	{
+		file.open(path.c_str());
+		file.imbue(std::locale(locale));
+
+		advanced_scenes = advanced;
+		line_number = 0;
+	}
+
+	~ScenarioSceneReader_t()
+	{
+		if (file.is_open())
+			file.close();
+	}
+
+	bool is_open()
+	{
+		return file.is_open();
+	}
+
+	// reads lines until next [scene_end], returns false when file has no more complete scenes
+	bool read_next_scene(ScenarioDialogueScene_t& scene);
+
+	std::wifstream file;
+	bool advanced_scenes;
+
+	int line_number;
+};
+
+void parse_scene_person_line(ScenarioDialogueScenePersonData_t& person, const std::vector<std::wstring>& splitted_str, bool advanced_scenes)
+{
+	person.person_name = splitted_str.at(0);
+	person.person_texture = scenario_name_table.intern(splitted_str.at(1));
+
+	person.talking_text = splitted_str.at(2);
+
+	if (advanced_scenes && splitted_str.size() > 5)
+	{
+		person.person_texture_left = scenario_name_table.intern(splitted_str.at(3));
+		person.person_texture_right = scenario_name_table.intern(splitted_str.at(4));
+		person.person_texture_head = scenario_name_table.intern(splitted_str.at(5));
+	}
+
+	if (person.talking_text == L"NONE")
+		person.talking = false;
+	else
+		person.talking = true;
+}
+
+void parse_scene_line(ScenarioDialogueScene_t& scene, const std::wstring& line, int line_param_read_stage, bool advanced_scenes)
+{
+	std::vector<std::wstring> splitted_str = split_string(line, L':');
+
+	if (splitted_str.size() >= 3 && line_param_read_stage == 0)
+	{
+		scene.button1.button_name = L"NONE";
+		scene.button2.button_name = L"NONE";
+		scene.button3.button_name = L"NONE";
+		scene.button4.button_name = L"NONE";
+
+		scene.background_overlay_texture = L"NONE";
+		scene.overlay_texture = L"NONE";
+
+		scene.person1.person_texture_left = L"NONE";
+		scene.person1.person_texture_right = L"NONE";
+		scene.person1.person_texture_head = L"NONE";
+
+		scene.person2.person_texture_left = L"NONE";
+		scene.person2.person_texture_right = L"NONE";
+		scene.person2.person_texture_head = L"NONE";
+
+		scene.person3.person_texture_left = L"NONE";
+		scene.person3.person_texture_right = L"NONE";
+		scene.person3.person_texture_head = L"NONE";
+
+		scene.person4.person_texture_left = L"NONE";
+		scene.person4.person_texture_right = L"NONE";
+		scene.person4.person_texture_head = L"NONE";
+
+		if (advanced_scenes && splitted_str.size() > 3)
+		{
+			scene.background_texture = scenario_name_table.intern(splitted_str.at(0));
+			scene.background_overlay_texture = scenario_name_table.intern(splitted_str.at(1));
+
+			scene.background_music = scenario_name_table.intern(splitted_str.at(2));
+			scene.additional_scene_sound = scenario_name_table.intern(splitted_str.at(3));
+		}
+		else
+		{
+			scene.background_texture = scenario_name_table.intern(splitted_str.at(0));
+			scene.background_music = scenario_name_table.intern(splitted_str.at(1));
+			scene.additional_scene_sound = scenario_name_table.intern(splitted_str.at(2));
+		}
+	}
+	else if (splitted_str.size() >= 3 && line_param_read_stage == 1)
+		parse_scene_person_line(scene.person1, splitted_str, advanced_scenes);
+	else if (splitted_str.size() >= 3 && line_param_read_stage == 2)
+		parse_scene_person_line(scene.person2, splitted_str, advanced_scenes);
+	else if (splitted_str.size() >= 3 && line_param_read_stage == 3)
+		parse_scene_person_line(scene.person3, splitted_str, advanced_scenes);
+	else if (splitted_str.size() >= 3 && line_param_read_stage == 4)
+		parse_scene_person_line(scene.person4, splitted_str, advanced_scenes);
+	else if (splitted_str.size() == 1 && line_param_read_stage == 5)
+	{
+		scene.main_character.talking_text = splitted_str.at(0);
+
+		if (scene.main_character.talking_text == L"NONE")
+			scene.main_character.talking = false;
+		else
+			scene.main_character.talking = true;
+	}
+	else if (splitted_str.size() == 2 && line_param_read_stage == 6)
+	{
+		scene.button1.button_name = splitted_str.at(0);
+		scene.button1.button_scenario_to_load = scenario_name_table.intern(splitted_str.at(1));
+	}
+	else if (splitted_str.size() == 2 && line_param_read_stage == 7)
+	{
+		scene.button2.button_name = splitted_str.at(0);
+		scene.button2.button_scenario_to_load = scenario_name_table.intern(splitted_str.at(1));
+	}
+	else if (splitted_str.size() == 2 && line_param_read_stage == 8)
+	{
+		scene.button3.button_name = splitted_str.at(0);
+		scene.button3.button_scenario_to_load = scenario_name_table.intern(splitted_str.at(1));
+	}
+	else if (splitted_str.size() == 2 && line_param_read_stage == 9)
+	{
+		scene.button4.button_name = splitted_str.at(0);
+		scene.button4.button_scenario_to_load = scenario_name_table.intern(splitted_str.at(1));
+	}
+	else if (splitted_str.size() == 1 && line_param_read_stage == 10 && advanced_scenes)
+	{
+		scene.overlay_texture = scenario_name_table.intern(splitted_str.at(0));
+	}
+}
+
+bool ScenarioSceneReader_t::read_next_scene(ScenarioDialogueScene_t& scene)
+{
+	if (!file.is_open())
+		return false;
+
+	bool found_scene_start = false;
+	int line_param_read_stage = -1;
+
+	scene = ScenarioDialogueScene_t();
+
+	std::wstring line;
+
+	while (std::getline(file, line))
+	{
+		line_number++;
+
+		if (line == L"[scene_start]")
+		{
+			found_scene_start = true;
+			continue;
+		}
+
+		if (line == L"[scene_end]")
+			return true;
+
+		if (found_scene_start)
+		{
+			line_param_read_stage++;
+			parse_scene_line(scene, line, line_param_read_stage, advanced_scenes);
+		}
+	}
+
+	return false;
+}
+
+// reads whole scenario file, scenes are appended to the given list
+void parse_scenario_file(const std::wstring& path, const std::string& locale, bool advanced_scenes, std::vector<ScenarioDialogueScene_t>& scenes)
+{
+	ScenarioSceneReader_t reader(path, locale, advanced_scenes);
+
+	ScenarioDialogueScene_t scene;
+
+	while (reader.read_next_scene(scene))
+		scenes.push_back(std::move(scene));
+}
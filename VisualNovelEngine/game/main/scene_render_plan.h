@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "../../imgui/imgui.h"
+
+#include "scenario.h"
+#include "typewriter.h"
+
+// Textured rectangle of scene. If quad has parts, its texture is composite of them and parts are drawn instead while
+// composite cant be drawn.
+struct SceneRenderQuad_t
+{
+	void add_part(TextureHandle_t part)
+	{
+		parts[parts_count++] = part;
+	}
+
+	TextureHandle_t handle = INVALID_TEXTURE_HANDLE;
+
+	TextureHandle_t parts[3];
+	int parts_count = 0;
+
+	ImVec2 p_min;
+	ImVec2 p_max;
+};
+
+// Layout of scene: quads, talking name and text, dialogue box geometry. Built when scene is entered or display size
+// changes, frames only replay it.
+struct SceneRenderPlan_t
+{
+	bool is_valid_for(int scenario, int scene, const ImVec2& display, bool advanced)
+	{
+		return valid && scenario_idx == scenario && scene_idx == scene && display_size.x == display.x && display_size.y == display.y && advanced_scenes == advanced;
+	}
+
+	// scene data plan was built from changed
+	void invalidate()
+	{
+		valid = false;
+	}
+
+	bool valid = false;
+
+	int scenario_idx = -1;
+	int scene_idx = -1;
+
+	ImVec2 display_size;
+	bool advanced_scenes = false;
+
+	// background, background overlay and characters in draw order
+	std::vector<SceneRenderQuad_t> quads;
+
+	int characters_count = 0;
+	int focused_character = -1;
+
+	std::wstring talking_name;
+	std::wstring talking_text;
+
+	std::string talking_name_utf8;
+
+	TextLayout_t talking_text_layout;
+
+	ImVec2 box_position;
+	ImVec2 box_size;
+
+	ImVec2 name_position;
+	ImVec2 name_size;
+
+	uint64_t builds = 0;
+};
@@ -0,0 +1,433 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <SFML/Graphics.hpp>
+
+#include "../../imgui/imgui.h"
+
+#include "text_encoding.h"
+#include "software_rasterizer.h"
+
+// Checks of engine internals run by -self_test launch parameter. Every test writes failed checks to report and
+// returns false if there were any.
+
+std::string get_self_test_units(const std::vector<uint32_t>& units)
+{
+	std::string text;
+
+	for (int i = 0; i < units.size(); i++)
+	{
+		char unit[16];
+		snprintf(unit, sizeof(unit), i > 0 ? " %X" : "%X", units.at(i));
+
+		text += unit;
+	}
+
+	return text;
+}
+
+std::vector<wchar_t> get_wide_units(const std::vector<uint32_t>& units)
+{
+	return std::vector<wchar_t>(units.begin(), units.end());
+}
+
+std::vector<uint32_t> get_code_units(const wchar_t* text, size_t length)
+{
+	return std::vector<uint32_t>(text, text + length);
+}
+
+std::vector<uint32_t> get_code_units(const char* text, size_t length)
+{
+	std::vector<uint32_t> units;
+
+	for (size_t i = 0; i < length; i++)
+		units.push_back(uint8_t(text[i]));
+
+	return units;
+}
+
+// UTF-8 of wide units through block path of encode_utf8
+std::vector<uint32_t> encode_self_test_text(const std::vector<wchar_t>& text)
+{
+	std::vector<char> utf8(get_utf8_capacity(text.size()) + 1);
+	return get_code_units(utf8.data(), encode_utf8(text.data(), text.size(), utf8.data()));
+}
+
+// UTF-8 of wide units one character at a time, as tails after last block are encoded
+std::vector<uint32_t> encode_self_test_text_scalar(const std::vector<wchar_t>& text)
+{
+	std::vector<char> utf8(get_utf8_capacity(text.size()) + 1);
+
+	char* out = utf8.data();
+
+	for (size_t i = 0; i < text.size();)
+		out = encode_utf8_character(text.data(), text.size(), i, out);
+
+	return get_code_units(utf8.data(), out - utf8.data());
+}
+
+std::vector<uint32_t> decode_self_test_text(const std::vector<char>& text)
+{
+	std::vector<wchar_t> wide(text.size() + 1);
+	return get_code_units(wide.data(), decode_utf8(text.data(), text.size(), wide.data()));
+}
+
+std::vector<uint32_t> decode_self_test_text_scalar(const std::vector<char>& text)
+{
+	std::vector<wchar_t> wide(text.size() + 1);
+
+	wchar_t* out = wide.data();
+
+	for (size_t i = 0; i < text.size();)
+		out = write_wide_code_point(decode_utf8_character(text.data(), text.size(), i), out);
+
+	return get_code_units(wide.data(), out - wide.data());
+}
+
+bool check_self_test_units(std::ostream& report, const char* check, const std::vector<uint32_t>& input, const std::vector<uint32_t>& result, const std::vector<uint32_t>& expected)
+{
+	if (result == expected)
+		return true;
+
+	report << "text encoding, " << check << ": " << get_self_test_units(input) << " gave " << get_self_test_units(result) << ", expected " << get_self_test_units(expected) << "\n";
+	return false;
+}
+
+// Known encodings of surrogate pairs, lone surrogates and invalid UTF-8, then round trips of text with non ASCII
+// characters at every position around 8 and 16 character blocks, so block path and scalar tail are both compared.
+bool test_text_encoding(std::ostream& report)
+{
+	bool passed = true;
+
+	struct EncodingCase_t
+	{
+		const char* name;
+
+		std::vector<uint32_t> wide;
+		std::vector<uint32_t> utf8;
+	};
+
+	const bool utf16 = sizeof(wchar_t) == 2;
+
+	std::vector<EncodingCase_t> encoding_cases =
+	{
+		{ "ascii", { 0x41, 0x62, 0x7F }, { 0x41, 0x62, 0x7F } },
+		{ "cyrillic", { 0x416, 0x44F }, { 0xD0, 0x96, 0xD1, 0x8F } },
+		{ "euro sign", { 0x20AC }, { 0xE2, 0x82, 0xAC } },
+		{ "lone low surrogate", { 0xDC00, 0x61 }, { 0xEF, 0xBF, 0xBD, 0x61 } },
+		{ "high surrogate at end", { 0x61, 0xD83D }, { 0x61, 0xEF, 0xBF, 0xBD } },
+		{ "reversed surrogates", { 0xDE00, 0xD83D }, { 0xEF, 0xBF, 0xBD, 0xEF, 0xBF, 0xBD } },
+	};
+
+	if (utf16)
+	{
+		encoding_cases.push_back({ "surrogate pair", { 0xD83D, 0xDE00 }, { 0xF0, 0x9F, 0x98, 0x80 } });
+		encoding_cases.push_back({ "surrogate pair across block", { 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0xD83D, 0xDE00, 0x62 }, { 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0xF0, 0x9F, 0x98, 0x80, 0x62 } });
+	}
+	else
+	{
+		encoding_cases.push_back({ "supplementary code point", { 0x1F600 }, { 0xF0, 0x9F, 0x98, 0x80 } });
+	}
+
+	for (int i = 0; i < encoding_cases.size(); i++)
+	{
+		EncodingCase_t& encoding_case = encoding_cases.at(i);
+		std::vector<wchar_t> text = get_wide_units(encoding_case.wide);
+
+		passed &= check_self_test_units(report, encoding_case.name, encoding_case.wide, encode_self_test_text(text), encoding_case.utf8);
+	}
+
+	struct DecodingCase_t
+	{
+		const char* name;
+
+		std::vector<uint32_t> utf8;
+		std::vector<uint32_t> wide;
+	};
+
+	std::vector<DecodingCase_t> decoding_cases =
+	{
+		{ "lone continuation byte", { 0x80, 0x41 }, { 0xFFFD, 0x41 } },
+		{ "overlong slash", { 0xC0, 0xAF }, { 0xFFFD, 0xFFFD } },
+		{ "overlong three byte", { 0xE0, 0x80, 0xAF }, { 0xFFFD } },
+		{ "truncated at end", { 0x41, 0xE2, 0x82 }, { 0x41, 0xFFFD } },
+		{ "truncated before ascii", { 0xE2, 0x82, 0x41 }, { 0xFFFD, 0x41 } },
+		{ "encoded surrogate", { 0xED, 0xA0, 0x80 }, { 0xFFFD } },
+		{ "above U+10FFFF", { 0xF4, 0x90, 0x80, 0x80 }, { 0xFFFD } },
+		{ "invalid lead bytes", { 0xF5, 0xFF, 0xFE }, { 0xFFFD, 0xFFFD, 0xFFFD } },
+		{ "sequence across block", { 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0xE2, 0x82, 0xAC, 0x62 }, { 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x20AC, 0x62 } },
+		{ "invalid byte across block", { 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0xE2, 0x82, 0x62 }, { 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0xFFFD, 0x62 } },
+	};
+
+	if (utf16)
+		decoding_cases.push_back({ "four byte sequence", { 0xF0, 0x9F, 0x98, 0x80 }, { 0xD83D, 0xDE00 } });
+	else
+		decoding_cases.push_back({ "four byte sequence", { 0xF0, 0x9F, 0x98, 0x80 }, { 0x1F600 } });
+
+	for (int i = 0; i < decoding_cases.size(); i++)
+	{
+		DecodingCase_t& decoding_case = decoding_cases.at(i);
+		std::vector<char> text(decoding_case.utf8.begin(), decoding_case.utf8.end());
+
+		passed &= check_self_test_units(report, decoding_case.name, decoding_case.utf8, decode_self_test_text(text), decoding_case.wide);
+	}
+
+	// one or two units of every kind at every position of ASCII text up to three blocks long
+	std::vector<std::vector<uint32_t>> characters = { { 0xE9 }, { 0x416 }, { 0x20AC } };
+
+	if (utf16)
+		characters.push_back({ 0xD83D, 0xDE00 });
+	else
+		characters.push_back({ 0x1F600 });
+
+	for (int length = 0; length <= 48; length++)
+	{
+		for (int position = 0; position <= length; position++)
+		{
+			for (int c = 0; c < characters.size(); c++)
+			{
+				std::vector<uint32_t> units;
+
+				for (int i = 0; i < length; i++)
+					units.push_back(0x61 + i % 26);
+
+				units.insert(units.begin() + position, characters.at(c).begin(), characters.at(c).end());
+
+				std::vector<wchar_t> text = get_wide_units(units);
+				std::vector<uint32_t> encoded = encode_self_test_text(text);
+
+				passed &= check_self_test_units(report, "encode blocks against scalar", units, encoded, encode_self_test_text_scalar(text));
+
+				std::vector<char> utf8(encoded.begin(), encoded.end());
+
+				passed &= check_self_test_units(report, "decode blocks against scalar", encoded, decode_self_test_text(utf8), decode_self_test_text_scalar(utf8));
+				passed &= check_self_test_units(report, "round trip", units, decode_self_test_text(utf8), units);
+			}
+		}
+	}
+
+	// random mixed text, same every run
+	uint32_t seed = 12345;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		std::vector<uint32_t> units;
+
+		for (int c = 0; c < i % 70; c++)
+		{
+			seed = seed * 1664525 + 1013904223;
+
+			int kind = (seed >> 24) % 8;
+			uint32_t value = (seed >> 8) & 0xFFFF;
+
+			if (kind < 4)
+				units.push_back(0x20 + value % 0x5F);
+			else if (kind == 4)
+				units.push_back(0x80 + value % 0x780);
+			else if (kind == 5)
+				units.push_back(0xE000 + value % 0x1FFE);
+			else if (kind == 6)
+				units.push_back(0x800 + value % 0xD000);
+			else if (utf16)
+			{
+				units.push_back(0xD800 + value % 0x400);
+				units.push_back(0xDC00 + (value >> 6) % 0x400);
+			}
+			else
+				units.push_back(0x10000 + value * 16 % 0x100000);
+		}
+
+		std::vector<wchar_t> text = get_wide_units(units);
+		std::vector<uint32_t> encoded = encode_self_test_text(text);
+		std::vector<char> utf8(encoded.begin(), encoded.end());
+
+		passed &= check_self_test_units(report, "random round trip", units, decode_self_test_text(utf8), units);
+	}
+
+	return passed;
+}
+
+const int REFERENCE_SCENE_WIDTH = 256;
+const int REFERENCE_SCENE_HEIGHT = 160;
+
+// drawn by GL path of SFML build (gl_renderer.h, textures without smoothing) from same scene
+const char* REFERENCE_SCENE_IMAGE = ".\\game\\tests\\software_rasterizer_reference.png";
+
+// GPU rounds color once, rasterizer after interpolation, texture modulation and blending, so pixels differ by a few
+// levels, most on one pixel wide anti-aliased fringes, whose alpha falls from 255 to 0 across pixel. Some GPUs may pick
+// neighbour pixel on edge or texel, those are counted.
+const int REFERENCE_SCENE_CHANNEL_TOLERANCE = 8;
+const int REFERENCE_SCENE_MAX_MISMATCHED_PIXELS = 16;
+
+// scene is drawn by rasterizer with workers as in -headless, several times so workers go through frames after first
+const int REFERENCE_SCENE_WORKERS = 3;
+const int REFERENCE_SCENE_FRAMES = 4;
+
+// 8x8 RGBA8 texels of distinct colors, drawn magnified so filtering and texel positions are visible
+std::vector<uint8_t> get_reference_checkerboard()
+{
+	std::vector<uint8_t> pixels;
+
+	for (int y = 0; y < 8; y++)
+	{
+		for (int x = 0; x < 8; x++)
+		{
+			bool dark = (x + y) % 2 == 1;
+
+			pixels.push_back(uint8_t(dark ? x * 16 : 255 - x * 16));
+			pixels.push_back(uint8_t(dark ? y * 16 : 255 - y * 16));
+			pixels.push_back(uint8_t(dark ? 64 : 192));
+			pixels.push_back(255);
+		}
+	}
+
+	return pixels;
+}
+
+// 32x32 RGBA8 disc with alpha falling to its edge, as soft edges of character sprites
+std::vector<uint8_t> get_reference_sprite()
+{
+	std::vector<uint8_t> pixels;
+
+	for (int y = 0; y < 32; y++)
+	{
+		for (int x = 0; x < 32; x++)
+		{
+			int distance = (x * 2 - 31) * (x * 2 - 31) + (y * 2 - 31) * (y * 2 - 31);
+
+			pixels.push_back(uint8_t(128 + x * 4));
+			pixels.push_back(uint8_t(255 - y * 4));
+			pixels.push_back(160);
+			pixels.push_back(uint8_t(std::max(255 - distance * 255 / (31 * 31), 0)));
+		}
+	}
+
+	return pixels;
+}
+
+// Frame with what game frames are made of: gradients, magnified, tinted, transparent and rotated textures, anti-aliased
+// shapes and lines, and clipped text of default font. Draws in current imgui context, its font atlas is built.
+void build_reference_scene(ImTextureID checkerboard, ImTextureID sprite)
+{
+	ImGuiIO& io = ImGui::GetIO();
+
+	io.DisplaySize = ImVec2(REFERENCE_SCENE_WIDTH, REFERENCE_SCENE_HEIGHT);
+	io.DeltaTime = 1.0f / 60.0f;
+
+	ImGui::NewFrame();
+
+	ImDrawList* draw_list = ImGui::GetBackgroundDrawList();
+
+	draw_list->AddRectFilledMultiColor(ImVec2(0, 0), ImVec2(REFERENCE_SCENE_WIDTH, REFERENCE_SCENE_HEIGHT), IM_COL32(40, 40, 90, 255), IM_COL32(90, 40, 40, 255), IM_COL32(20, 90, 20, 255), IM_COL32(10, 10, 10, 255));
+
+	draw_list->AddImage(checkerboard, ImVec2(8, 8), ImVec2(72, 72));
+	draw_list->AddImage(sprite, ImVec2(40, 40), ImVec2(104, 104), ImVec2(0, 0), ImVec2(1, 1), IM_COL32(255, 200, 200, 230));
+	// corners on 1/16 pixel grid of rasterizer, but not in positions where pixel centers fall exactly on texel edges
+	draw_list->AddImageQuad(checkerboard, ImVec2(150.25f, 90.0625f), ImVec2(190.25f, 110.0625f), ImVec2(170.25f, 150.0625f), ImVec2(130.25f, 130.0625f));
+
+	draw_list->AddCircleFilled(ImVec2(200, 40), 28, IM_COL32(255, 220, 0, 180));
+	draw_list->AddCircle(ImVec2(200, 40), 30, IM_COL32(255, 255, 255, 255), 0, 2.0f);
+	draw_list->AddLine(ImVec2(8, 150), ImVec2(110, 90), IM_COL32(0, 255, 255, 255), 3.0f);
+	draw_list->AddRect(ImVec2(4, 112), ImVec2(124, 156), IM_COL32(255, 255, 255, 200), 6.0f, 0, 1.5f);
+
+	draw_list->PushClipRect(ImVec2(8, 116), ImVec2(96, 152));
+	draw_list->AddText(ImVec2(10, 118), IM_COL32(255, 255, 255, 255), "Reference scene\nclipped text line");
+	draw_list->PopClipRect();
+
+	ImGui::Render();
+}
+
+// reference scene drawn by software_rasterizer.h against image of it from GPU, frame drawn by rasterizer is written
+// next to report if they differ
+bool test_software_rasterizer(std::ostream& report)
+{
+	sf::Image reference;
+
+	if (!reference.loadFromFile(REFERENCE_SCENE_IMAGE) || reference.getSize().x != REFERENCE_SCENE_WIDTH || reference.getSize().y != REFERENCE_SCENE_HEIGHT)
+	{
+		report << "software rasterizer: no " << REFERENCE_SCENE_WIDTH << "x" << REFERENCE_SCENE_HEIGHT << " image " << REFERENCE_SCENE_IMAGE << "\n";
+		return false;
+	}
+
+	ImGuiContext* context = ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+
+	io.IniFilename = nullptr;
+
+	unsigned char* font_pixels;
+	int font_width;
+	int font_height;
+
+	io.Fonts->GetTexDataAsRGBA32(&font_pixels, &font_width, &font_height);
+	io.Fonts->SetTexID((ImTextureID)io.Fonts);
+
+	std::vector<uint8_t> checkerboard = get_reference_checkerboard();
+	std::vector<uint8_t> sprite = get_reference_sprite();
+
+	// nearest filtering as SFML textures of reference image
+	SoftwareRasterizer_t rasterizer;
+
+	rasterizer.set_texture(io.Fonts->TexID, font_width, font_height, font_pixels);
+	rasterizer.set_texture((ImTextureID)&checkerboard, 8, 8, checkerboard.data());
+	rasterizer.set_texture((ImTextureID)&sprite, 32, 32, sprite.data());
+
+	rasterizer.start(REFERENCE_SCENE_WORKERS);
+
+	build_reference_scene((ImTextureID)&checkerboard, (ImTextureID)&sprite);
+	rasterizer.render(ImGui::GetDrawData());
+
+	std::vector<uint32_t> first_frame = rasterizer.pixels;
+	bool frames_equal = true;
+
+	// every frame has same tiles, workers drawing ones of other frame or none would change pixels or hang
+	for (int i = 1; i < REFERENCE_SCENE_FRAMES; i++)
+	{
+		build_reference_scene((ImTextureID)&checkerboard, (ImTextureID)&sprite);
+		rasterizer.render(ImGui::GetDrawData());
+
+		frames_equal &= rasterizer.pixels == first_frame;
+	}
+
+	rasterizer.shutdown();
+
+	ImGui::DestroyContext(context);
+
+	if (!frames_equal)
+	{
+		report << "software rasterizer: " << REFERENCE_SCENE_FRAMES << " frames of reference scene drawn by " << REFERENCE_SCENE_WORKERS << " workers differ\n";
+
+		rasterizer.write_png(".\\game\\profiles\\self_test software_rasterizer.png");
+		return false;
+	}
+
+	const uint32_t* expected = (const uint32_t*)reference.getPixelsPtr();
+
+	int mismatched_pixels = 0;
+	int max_difference = 0;
+
+	for (int i = 0; i < rasterizer.pixels.size(); i++)
+	{
+		int difference = 0;
+
+		for (int c = 0; c < 32; c += 8)
+			difference = std::max(difference, std::abs(int((rasterizer.pixels.at(i) >> c) & 0xFF) - int((expected[i] >> c) & 0xFF)));
+
+		if (difference > REFERENCE_SCENE_CHANNEL_TOLERANCE)
+			mismatched_pixels++;
+
+		max_difference = std::max(max_difference, difference);
+	}
+
+	if (mismatched_pixels <= REFERENCE_SCENE_MAX_MISMATCHED_PIXELS)
+		return true;
+
+	report << "software rasterizer: " << mismatched_pixels << " pixels of reference scene differ by more than " << REFERENCE_SCENE_CHANNEL_TOLERANCE << ", up to " << max_difference << "\n";
+
+	rasterizer.write_png(".\\game\\profiles\\self_test software_rasterizer.png");
+	return false;
+}
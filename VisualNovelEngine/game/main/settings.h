@@ -1,5 +1,8 @@
 #pragma once
 
+// version key of video_settings.ini, increased when meaning of a stored value changes
+const int VIDEO_SETTINGS_VERSION = 1;
+
 struct VideoSettings_t
 {
 	bool vsync;
@@ -12,6 +15,9 @@ struct VideoSettings_t
 
 	int render_mode;
 	int texture_quality;
+
+	int texture_memory_budget; // in megabytes, 0 - unlimited
+	int texture_prefetch_scenes;
 };
 
 struct AudioSettings_t
@@ -29,4 +35,7 @@ struct GameSettings_t
 	int text_animation_speed;
 
 	int menu_language;
+
+	// main loop waits for input instead of rebuilding frames while nothing animates
+	bool idle_rendering;
 };
\ No newline at end of file
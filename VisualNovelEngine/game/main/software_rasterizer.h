@@ -0,0 +1,748 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <emmintrin.h>
+
+#include <SFML/Graphics.hpp>
+
+#include "../../imgui/imgui.h"
+
+#include "trace.h"
+
+// frame is split to square tiles, every tile is drawn by one thread, so threads never write same pixels
+const int SOFTWARE_RASTERIZER_TILE_SIZE = 64;
+
+// vertex positions are snapped to 1/16 of pixel, as on GPU
+const int SOFTWARE_RASTERIZER_SUBPIXEL_BITS = 4;
+const int SOFTWARE_RASTERIZER_SUBPIXELS = 1 << SOFTWARE_RASTERIZER_SUBPIXEL_BITS;
+
+// RGBA8, straight alpha
+struct SoftwareTexture_t
+{
+	int width = 0;
+	int height = 0;
+
+	std::vector<uint8_t> pixels;
+};
+
+// triangle of draw data after setup, vertices are ordered so its area is positive
+struct SoftwareTriangle_t
+{
+	const ImDrawVert* vertices[3];
+	const SoftwareTexture_t* texture;
+
+	// fixed point positions
+	int x[3];
+	int y[3];
+
+	int64_t area;
+
+	// bounds of covered pixels clipped by scissor, max is exclusive
+	int min_x;
+	int min_y;
+	int max_x;
+	int max_y;
+
+	// all vertices have same uv (imgui rectangles and text background use white pixel of font atlas)
+	bool same_uv;
+	bool same_color;
+};
+
+// result / 255 with rounding, for x up to 255 * 255 * 2
+inline uint32_t div_255(uint32_t x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+bool write_rgba_png(const std::string& path, int width, int height, const std::vector<uint32_t>& pixels)
+{
+	if (pixels.empty() || pixels.size() != size_t(width) * height)
+		return false;
+
+	sf::Image image;
+	image.create(width, height, (const sf::Uint8*)pixels.data());
+
+	return image.saveToFile(path);
+}
+
+// Draws ImDrawData on CPU as imgui backends do on GPU: textured, vertex colored, scissored triangles with alpha blending
+// (src alpha, one minus src alpha). Textures are registered by their ImTextureID, triangles of unknown textures are
+// sampled as transparent, like unbound texture. Tiles are drawn by calling thread together with workers of start().
+struct SoftwareRasterizer_t
+{
+	~SoftwareRasterizer_t()
+	{
+		shutdown();
+	}
+
+	// workers stay for all frames, so frames of -render_scenes dont start threads
+	void start(int worker_count)
+	{
+		if (workers.size() > 0)
+			return;
+
+		stopping = false;
+
+		// workers get frame of start, worker reading it when it first runs could miss first render
+		uint64_t started_frame = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			started_frame = frame;
+		}
+
+		for (int i = 0; i < worker_count; i++)
+			workers.emplace_back(&SoftwareRasterizer_t::worker_thread, this, started_frame);
+	}
+
+	void shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		frame_started.notify_all();
+
+		for (int i = 0; i < workers.size(); i++)
+		{
+			if (workers.at(i).joinable())
+				workers.at(i).join();
+		}
+
+		workers.clear();
+	}
+
+	void set_texture(ImTextureID id, int width, int height, const uint8_t* pixels)
+	{
+		SoftwareTexture_t& texture = textures[id];
+
+		texture.width = width;
+		texture.height = height;
+
+		if (pixels)
+			texture.pixels.assign(pixels, pixels + size_t(width) * height * 4);
+		else
+			texture.pixels.assign(size_t(width) * height * 4, 0);
+	}
+
+	// rectangle of existing texture
+	void update_texture(ImTextureID id, int x, int y, int width, int height, const uint8_t* pixels)
+	{
+		auto it = textures.find(id);
+
+		if (it == textures.end())
+			return;
+
+		SoftwareTexture_t& texture = it->second;
+
+		if (x < 0 || y < 0 || x + width > texture.width || y + height > texture.height)
+			return;
+
+		for (int row = 0; row < height; row++)
+			memcpy(texture.pixels.data() + (size_t(y + row) * texture.width + x) * 4, pixels + size_t(row) * width * 4, size_t(width) * 4);
+	}
+
+	void remove_texture(ImTextureID id)
+	{
+		textures.erase(id);
+	}
+
+	const SoftwareTexture_t* find_texture(ImTextureID id)
+	{
+		auto it = textures.find(id);
+		return it != textures.end() ? &it->second : nullptr;
+	}
+
+	void render(ImDrawData* draw_data)
+	{
+		TraceScope_t trace_scope("software_rasterizer_render");
+
+		width = int(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+		height = int(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+
+		if (width <= 0 || height <= 0)
+			return;
+
+		pixels.resize(size_t(width) * height);
+
+		tiles_x = (width + SOFTWARE_RASTERIZER_TILE_SIZE - 1) / SOFTWARE_RASTERIZER_TILE_SIZE;
+		tiles_y = (height + SOFTWARE_RASTERIZER_TILE_SIZE - 1) / SOFTWARE_RASTERIZER_TILE_SIZE;
+
+		tiles.resize(size_t(tiles_x) * tiles_y);
+
+		for (int i = 0; i < tiles.size(); i++)
+			tiles.at(i).clear();
+
+		triangles.clear();
+
+		setup_triangles(draw_data);
+
+		next_tile = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			frame++;
+			finished_workers = 0;
+		}
+
+		frame_started.notify_all();
+
+		render_tiles();
+
+		// every worker finishes frame before triangles and tiles of next one are set up
+		std::unique_lock<std::mutex> lock(mutex);
+		frame_finished.wait(lock, [this] { return finished_workers == workers.size(); });
+	}
+
+	void render_tiles()
+	{
+		int tile;
+
+		while ((tile = next_tile++) < int(tiles.size()))
+			render_tile(tile);
+	}
+
+	void worker_thread(uint64_t rendered_frame)
+	{
+		tracer.set_thread_name("Rasterizer");
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				frame_started.wait(lock, [&] { return stopping || frame != rendered_frame; });
+
+				if (stopping)
+					return;
+
+				rendered_frame = frame;
+			}
+
+			render_tiles();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				finished_workers++;
+			}
+
+			frame_finished.notify_all();
+		}
+	}
+
+	bool write_png(const std::string& path)
+	{
+		return write_rgba_png(path, width, height, pixels);
+	}
+
+	void setup_triangles(ImDrawData* draw_data)
+	{
+		ImVec2 clip_offset = draw_data->DisplayPos;
+		ImVec2 clip_scale = draw_data->FramebufferScale;
+
+		for (int i = 0; i < draw_data->CmdListsCount; i++)
+		{
+			const ImDrawList* draw_list = draw_data->CmdLists[i];
+
+			for (int c = 0; c < draw_list->CmdBuffer.Size; c++)
+			{
+				const ImDrawCmd& cmd = draw_list->CmdBuffer[c];
+
+				// callbacks expect GPU render state, there is none
+				if (cmd.UserCallback)
+					continue;
+
+				int clip_min_x = std::max(int((cmd.ClipRect.x - clip_offset.x) * clip_scale.x), 0);
+				int clip_min_y = std::max(int((cmd.ClipRect.y - clip_offset.y) * clip_scale.y), 0);
+				int clip_max_x = std::min(int((cmd.ClipRect.z - clip_offset.x) * clip_scale.x), width);
+				int clip_max_y = std::min(int((cmd.ClipRect.w - clip_offset.y) * clip_scale.y), height);
+
+				if (clip_max_x <= clip_min_x || clip_max_y <= clip_min_y)
+					continue;
+
+				const SoftwareTexture_t* texture = find_texture(cmd.GetTexID());
+
+				const ImDrawVert* vertices = draw_list->VtxBuffer.Data + cmd.VtxOffset;
+				const ImDrawIdx* indices = draw_list->IdxBuffer.Data + cmd.IdxOffset;
+
+				for (unsigned e = 0; e + 2 < cmd.ElemCount; e += 3)
+				{
+					SoftwareTriangle_t triangle;
+
+					triangle.texture = texture;
+
+					for (int v = 0; v < 3; v++)
+					{
+						triangle.vertices[v] = vertices + indices[e + v];
+
+						triangle.x[v] = int(std::lround((triangle.vertices[v]->pos.x - clip_offset.x) * clip_scale.x * SOFTWARE_RASTERIZER_SUBPIXELS));
+						triangle.y[v] = int(std::lround((triangle.vertices[v]->pos.y - clip_offset.y) * clip_scale.y * SOFTWARE_RASTERIZER_SUBPIXELS));
+					}
+
+					triangle.area = int64_t(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - int64_t(triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+
+					if (triangle.area == 0)
+						continue;
+
+					if (triangle.area < 0)
+					{
+						std::swap(triangle.vertices[1], triangle.vertices[2]);
+						std::swap(triangle.x[1], triangle.x[2]);
+						std::swap(triangle.y[1], triangle.y[2]);
+
+						triangle.area = -triangle.area;
+					}
+
+					// pixels whose centers can be inside
+					int min_x = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+					int min_y = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+					int max_x = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+					int max_y = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+
+					triangle.min_x = std::max(min_x >> SOFTWARE_RASTERIZER_SUBPIXEL_BITS, clip_min_x);
+					triangle.min_y = std::max(min_y >> SOFTWARE_RASTERIZER_SUBPIXEL_BITS, clip_min_y);
+					triangle.max_x = std::min((max_x >> SOFTWARE_RASTERIZER_SUBPIXEL_BITS) + 1, clip_max_x);
+					triangle.max_y = std::min((max_y >> SOFTWARE_RASTERIZER_SUBPIXEL_BITS) + 1, clip_max_y);
+
+					if (triangle.max_x <= triangle.min_x || triangle.max_y <= triangle.min_y)
+						continue;
+
+					const ImDrawVert* v0 = triangle.vertices[0];
+					const ImDrawVert* v1 = triangle.vertices[1];
+					const ImDrawVert* v2 = triangle.vertices[2];
+
+					triangle.same_uv = v0->uv.x == v1->uv.x && v0->uv.x == v2->uv.x && v0->uv.y == v1->uv.y && v0->uv.y == v2->uv.y;
+					triangle.same_color = v0->col == v1->col && v0->col == v2->col;
+
+					int idx = int(triangles.size());
+					triangles.push_back(triangle);
+
+					// tiles keep triangles in draw order, so blending order is kept
+					for (int tile_y = triangle.min_y / SOFTWARE_RASTERIZER_TILE_SIZE; tile_y <= (triangle.max_y - 1) / SOFTWARE_RASTERIZER_TILE_SIZE; tile_y++)
+					{
+						for (int tile_x = triangle.min_x / SOFTWARE_RASTERIZER_TILE_SIZE; tile_x <= (triangle.max_x - 1) / SOFTWARE_RASTERIZER_TILE_SIZE; tile_x++)
+							tiles.at(size_t(tile_y) * tiles_x + tile_x).push_back(idx);
+					}
+				}
+			}
+		}
+	}
+
+	void render_tile(int tile)
+	{
+		int tile_min_x = (tile % tiles_x) * SOFTWARE_RASTERIZER_TILE_SIZE;
+		int tile_min_y = (tile / tiles_x) * SOFTWARE_RASTERIZER_TILE_SIZE;
+		int tile_max_x = std::min(tile_min_x + SOFTWARE_RASTERIZER_TILE_SIZE, width);
+		int tile_max_y = std::min(tile_min_y + SOFTWARE_RASTERIZER_TILE_SIZE, height);
+
+		for (int y = tile_min_y; y < tile_max_y; y++)
+			std::fill(pixels.begin() + size_t(y) * width + tile_min_x, pixels.begin() + size_t(y) * width + tile_max_x, clear_color);
+
+		std::vector<int>& tile_triangles = tiles.at(tile);
+
+		for (int i = 0; i < tile_triangles.size(); i++)
+			rasterize_triangle(triangles.at(tile_triangles.at(i)), tile_min_x, tile_min_y, tile_max_x, tile_max_y);
+	}
+
+	// texel at 16.16 fixed point texel position, clamped to edge
+	static uint32_t sample_nearest(const SoftwareTexture_t* texture, int u, int v)
+	{
+		int x = std::min(std::max(u >> 16, 0), texture->width - 1);
+		int y = std::min(std::max(v >> 16, 0), texture->height - 1);
+
+		return ((const uint32_t*)texture->pixels.data())[size_t(y) * texture->width + x];
+	}
+
+	// position is relative to texel centers, clamped to edge
+	static uint32_t sample_linear(const SoftwareTexture_t* texture, int u, int v)
+	{
+		int x0 = u >> 16;
+		int y0 = v >> 16;
+
+		int x1 = std::min(std::max(x0 + 1, 0), texture->width - 1);
+		int y1 = std::min(std::max(y0 + 1, 0), texture->height - 1);
+
+		x0 = std::min(std::max(x0, 0), texture->width - 1);
+		y0 = std::min(std::max(y0, 0), texture->height - 1);
+
+		const uint32_t* row0 = (const uint32_t*)texture->pixels.data() + size_t(y0) * texture->width;
+		const uint32_t* row1 = (const uint32_t*)texture->pixels.data() + size_t(y1) * texture->width;
+
+		return filter(row0[x0], row0[x1], row1[x0], row1[x1], (u >> 8) & 0xFF, (v >> 8) & 0xFF);
+	}
+
+	// all 4 texels are inside texture
+	static uint32_t sample_linear_interior(const SoftwareTexture_t* texture, int u, int v)
+	{
+		const uint32_t* row0 = (const uint32_t*)texture->pixels.data() + size_t(v >> 16) * texture->width + (u >> 16);
+		const uint32_t* row1 = row0 + texture->width;
+
+		return filter(row0[0], row0[1], row1[0], row1[1], (u >> 8) & 0xFF, (v >> 8) & 0xFF);
+	}
+
+	static uint32_t filter(uint32_t texel00, uint32_t texel10, uint32_t texel01, uint32_t texel11, uint32_t fraction_x, uint32_t fraction_y)
+	{
+		// texels drawn 1:1 are sampled at their centers
+		if ((fraction_x | fraction_y) == 0)
+			return texel00;
+
+		const __m128i zero = _mm_setzero_si128();
+
+		// 16 bits per channel, top row in low half and bottom row in high half
+		__m128i left = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(int(texel00)), _mm_cvtsi32_si128(int(texel01))), zero);
+		__m128i right = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(int(texel10)), _mm_cvtsi32_si128(int(texel11))), zero);
+
+		__m128i horizontal = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(left, _mm_set1_epi16(short(256 - fraction_x))), _mm_mullo_epi16(right, _mm_set1_epi16(short(fraction_x)))), 8);
+		__m128i vertical = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(horizontal, _mm_set1_epi16(short(256 - fraction_y))), _mm_mullo_epi16(_mm_srli_si128(horizontal, 8), _mm_set1_epi16(short(fraction_y)))), 8);
+
+		return uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(vertical, zero)));
+	}
+
+	// true if samples at both ends of span dont need clamping, positions change linearly along span. Bilinear samples
+	// also read texel after their position.
+	static bool is_span_interior(const SoftwareTexture_t* texture, bool linear, int u_start, int v_start, int u_end, int v_end)
+	{
+		int footprint = linear ? 1 : 0;
+		return std::min(u_start, u_end) >= 0 && std::min(v_start, v_end) >= 0 && (std::max(u_start, u_end) >> 16) + footprint < texture->width && (std::max(v_start, v_end) >> 16) + footprint < texture->height;
+	}
+
+	// Span of one color over texture row, as images drawn without rotation (backgrounds, characters, glyphs) are. Texel
+	// rows are found once, samples dont need clamping.
+	static void draw_row_span(uint32_t* destination, int count, const SoftwareTexture_t* texture, bool linear, int u, int u_step, int v, uint32_t color)
+	{
+		const uint32_t* row0 = (const uint32_t*)texture->pixels.data() + size_t(v >> 16) * texture->width;
+
+		if (!linear)
+		{
+			for (int i = 0; i < count; i++, u += u_step)
+				blend_pixel(destination[i], modulate(color, row0[u >> 16]));
+
+			return;
+		}
+
+		const uint32_t* row1 = row0 + texture->width;
+
+		const __m128i zero = _mm_setzero_si128();
+
+		// rows are blended first, their weights are same for whole span
+		const __m128i top_weight = _mm_set1_epi16(short(256 - ((v >> 8) & 0xFF)));
+		const __m128i bottom_weight = _mm_set1_epi16(short((v >> 8) & 0xFF));
+
+		for (int i = 0; i < count; i++, u += u_step)
+		{
+			int x = u >> 16;
+			short fraction_x = short((u >> 8) & 0xFF);
+
+			// 16 bits per channel, left texel in low half and right texel in high half
+			__m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row0 + x)), zero);
+			__m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row1 + x)), zero);
+
+			__m128i vertical = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top, top_weight), _mm_mullo_epi16(bottom, bottom_weight)), 8);
+			__m128i horizontal = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(vertical, _mm_set1_epi16(short(256 - fraction_x))), _mm_mullo_epi16(_mm_srli_si128(vertical, 8), _mm_set1_epi16(fraction_x))), 8);
+
+			blend_pixel(destination[i], modulate(color, uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(horizontal, zero)))));
+		}
+	}
+
+	// vertex color times texel
+	static uint32_t modulate(uint32_t color, uint32_t texel)
+	{
+		if (color == 0xFFFFFFFF)
+			return texel;
+
+		uint32_t result = 0;
+
+		for (int i = 0; i < 32; i += 8)
+			result |= div_255(((color >> i) & 0xFF) * ((texel >> i) & 0xFF)) << i;
+
+		return result;
+	}
+
+	static void blend_pixel(uint32_t& destination, uint32_t source)
+	{
+		uint32_t alpha = source >> 24;
+
+		if (alpha == 255)
+		{
+			destination = source;
+			return;
+		}
+
+		if (alpha == 0)
+			return;
+
+		// alpha channel is blended with one, one minus src alpha, so its source is 255
+		uint32_t rb = (source & 0xFF00FF) * alpha + (destination & 0xFF00FF) * (255 - alpha);
+		uint32_t ga = (((source >> 8) & 0xFF) | 0xFF0000) * alpha + ((destination >> 8) & 0xFF00FF) * (255 - alpha);
+
+		// divide both channels by 255 with rounding
+		rb += 0x800080;
+		ga += 0x800080;
+
+		rb = ((rb + ((rb >> 8) & 0xFF00FF)) >> 8) & 0xFF00FF;
+		ga = (ga + ((ga >> 8) & 0xFF00FF)) & 0xFF00FF00;
+
+		destination = rb | ga;
+	}
+
+	// same color over span, 4 pixels at once
+	static void blend_span(uint32_t* destination, int count, uint32_t source)
+	{
+		uint32_t alpha = source >> 24;
+
+		if (alpha == 0)
+			return;
+
+		if (alpha == 255)
+		{
+			std::fill(destination, destination + count, source);
+			return;
+		}
+
+		const __m128i zero = _mm_setzero_si128();
+
+		// source * alpha per channel, alpha channel is alpha * 255
+		__m128i source_term = _mm_unpacklo_epi8(_mm_set1_epi32(int(source | 0xFF000000)), zero);
+		source_term = _mm_mullo_epi16(source_term, _mm_set1_epi16(short(alpha)));
+
+		const __m128i inverse_alpha = _mm_set1_epi16(short(255 - alpha));
+		const __m128i rounding = _mm_set1_epi16(128);
+
+		int i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(destination + i));
+
+			__m128i low = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), inverse_alpha), source_term), rounding);
+			__m128i high = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), inverse_alpha), source_term), rounding);
+
+			low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+			high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+			_mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+		}
+
+		for (; i < count; i++)
+			blend_pixel(destination[i], source);
+	}
+
+	void rasterize_triangle(const SoftwareTriangle_t& triangle, int tile_min_x, int tile_min_y, int tile_max_x, int tile_max_y)
+	{
+		int min_x = std::max(triangle.min_x, tile_min_x);
+		int min_y = std::max(triangle.min_y, tile_min_y);
+		int max_x = std::min(triangle.max_x, tile_max_x);
+		int max_y = std::min(triangle.max_y, tile_max_y);
+
+		if (max_x <= min_x || max_y <= min_y)
+			return;
+
+		const SoftwareTexture_t* texture = triangle.texture;
+
+		// texture not known to rasterizer is transparent
+		if (!texture || texture->pixels.empty())
+			return;
+
+		// edge i is opposite to vertex i, its function is weight of vertex i times area
+		int64_t step_x[3];
+		int64_t step_y[3];
+		int64_t row[3];
+
+		int half = SOFTWARE_RASTERIZER_SUBPIXELS / 2;
+
+		for (int i = 0; i < 3; i++)
+		{
+			int a = (i + 1) % 3;
+			int b = (i + 2) % 3;
+
+			int64_t dx = triangle.x[b] - triangle.x[a];
+			int64_t dy = triangle.y[b] - triangle.y[a];
+
+			// top left fill rule, pixels on shared edge of two triangles are drawn once
+			int64_t bias = (dy < 0 || (dy == 0 && dx > 0)) ? 0 : -1;
+
+			int64_t px = int64_t(min_x) * SOFTWARE_RASTERIZER_SUBPIXELS + half;
+			int64_t py = int64_t(min_y) * SOFTWARE_RASTERIZER_SUBPIXELS + half;
+
+			row[i] = dx * (py - triangle.y[a]) - dy * (px - triangle.x[a]) + bias;
+
+			step_x[i] = -dy * SOFTWARE_RASTERIZER_SUBPIXELS;
+			step_y[i] = dx * SOFTWARE_RASTERIZER_SUBPIXELS;
+		}
+
+		const ImDrawVert* v0 = triangle.vertices[0];
+		const ImDrawVert* v1 = triangle.vertices[1];
+		const ImDrawVert* v2 = triangle.vertices[2];
+
+		bool linear = linear_filtering;
+
+		float inverse_area = 1.0f / float(triangle.area);
+
+		// attribute = value of vertex 0 + delta 1 * weight 1 + delta 2 * weight 2, weights are edge functions / area.
+		// Texture positions are in texels, relative to texel centers for linear filtering.
+		float u_origin = v0->uv.x * texture->width - (linear ? 0.5f : 0.0f);
+		float v_origin = v0->uv.y * texture->height - (linear ? 0.5f : 0.0f);
+
+		float u_delta_1 = (v1->uv.x - v0->uv.x) * texture->width;
+		float u_delta_2 = (v2->uv.x - v0->uv.x) * texture->width;
+		float v_delta_1 = (v1->uv.y - v0->uv.y) * texture->height;
+		float v_delta_2 = (v2->uv.y - v0->uv.y) * texture->height;
+
+		int u_step = int(std::lround((u_delta_1 * step_x[1] + u_delta_2 * step_x[2]) * inverse_area * 65536.0f));
+		int v_step = int(std::lround((v_delta_1 * step_x[1] + v_delta_2 * step_x[2]) * inverse_area * 65536.0f));
+
+		float colors[3][4];
+
+		for (int v = 0; v < 3; v++)
+		{
+			for (int i = 0; i < 4; i++)
+				colors[v][i] = float((triangle.vertices[v]->col >> (i * 8)) & 0xFF);
+		}
+
+		float color_step[4];
+
+		for (int i = 0; i < 4; i++)
+			color_step[i] = ((colors[1][i] - colors[0][i]) * step_x[1] + (colors[2][i] - colors[0][i]) * step_x[2]) * inverse_area;
+
+		uint32_t constant_texel = 0;
+
+		if (triangle.same_uv)
+		{
+			int u = int(std::lround(u_origin * 65536.0f));
+			int v = int(std::lround(v_origin * 65536.0f));
+
+			constant_texel = linear ? sample_linear(texture, u, v) : sample_nearest(texture, u, v);
+		}
+
+		for (int y = min_y; y < max_y; y++, row[0] += step_y[0], row[1] += step_y[1], row[2] += step_y[2])
+		{
+			// triangle is convex, covered pixels of row are one span, its ends are solved from edge functions
+			int64_t span_start = min_x;
+			int64_t span_end = max_x;
+
+			for (int i = 0; i < 3; i++)
+			{
+				if (step_x[i] > 0)
+				{
+					if (row[i] < 0)
+						span_start = std::max(span_start, min_x + (-row[i] + step_x[i] - 1) / step_x[i]);
+				}
+				else if (row[i] < 0)
+				{
+					span_end = min_x;
+				}
+				else if (step_x[i] < 0)
+				{
+					span_end = std::min(span_end, min_x + row[i] / -step_x[i] + 1);
+				}
+			}
+
+			if (span_start >= span_end)
+				continue;
+
+			uint32_t* line = pixels.data() + size_t(y) * width;
+
+			if (triangle.same_uv && triangle.same_color)
+			{
+				blend_span(line + span_start, int(span_end - span_start), modulate(v0->col, constant_texel));
+				continue;
+			}
+
+			// attributes at start of span
+			float l1 = float(row[1] + step_x[1] * (span_start - min_x)) * inverse_area;
+			float l2 = float(row[2] + step_x[2] * (span_start - min_x)) * inverse_area;
+
+			int u = int(std::lround((u_origin + u_delta_1 * l1 + u_delta_2 * l2) * 65536.0f));
+			int v = int(std::lround((v_origin + v_delta_1 * l1 + v_delta_2 * l2) * 65536.0f));
+
+			int count = int(span_end - span_start);
+
+			bool interior = is_span_interior(texture, linear, u, v, u + u_step * (count - 1), v + v_step * (count - 1));
+
+			if (triangle.same_color && interior && v_step == 0)
+			{
+				draw_row_span(line + span_start, count, texture, linear, u, u_step, v, v0->col);
+				continue;
+			}
+
+			if (triangle.same_color)
+			{
+				for (int x = int(span_start); x < span_end; x++, u += u_step, v += v_step)
+				{
+					uint32_t texel = interior && linear ? sample_linear_interior(texture, u, v) : linear ? sample_linear(texture, u, v) : sample_nearest(texture, u, v);
+					blend_pixel(line[x], modulate(v0->col, texel));
+				}
+
+				continue;
+			}
+
+			float color[4];
+
+			for (int i = 0; i < 4; i++)
+				color[i] = colors[0][i] + (colors[1][i] - colors[0][i]) * l1 + (colors[2][i] - colors[0][i]) * l2;
+
+			for (int x = int(span_start); x < span_end; x++, u += u_step, v += v_step)
+			{
+				uint32_t packed = 0;
+
+				for (int i = 0; i < 4; i++)
+				{
+					packed |= uint32_t(std::min(std::max(color[i] + 0.5f, 0.0f), 255.0f)) << (i * 8);
+					color[i] += color_step[i];
+				}
+
+				uint32_t texel = triangle.same_uv ? constant_texel : interior && linear ? sample_linear_interior(texture, u, v) : linear ? sample_linear(texture, u, v) : sample_nearest(texture, u, v);
+				blend_pixel(line[x], modulate(packed, texel));
+			}
+		}
+	}
+
+	std::unordered_map<ImTextureID, SoftwareTexture_t> textures;
+
+	// linear like D3D11 sampler of imgui, SFML textures arent smooth
+	bool linear_filtering = false;
+
+	// textures keep pixels for rasterizer only when it is used
+	bool enabled = false;
+
+	// RGBA8, opaque black
+	uint32_t clear_color = 0xFF000000;
+
+	int width = 0;
+	int height = 0;
+
+	std::vector<uint32_t> pixels;
+
+	std::vector<SoftwareTriangle_t> triangles;
+
+	int tiles_x = 0;
+	int tiles_y = 0;
+
+	std::vector<std::vector<int>> tiles;
+
+	std::atomic<int> next_tile{ 0 };
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable frame_started;
+	std::condition_variable frame_finished;
+
+	// frames started by render, every worker renders tiles of every frame
+	uint64_t frame = 0;
+	size_t finished_workers = 0;
+
+	bool stopping = false;
+};
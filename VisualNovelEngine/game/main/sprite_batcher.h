@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+
+#include "../../imgui/imgui.h"
+
+struct SceneSprite_t
+{
+	ImTextureID texture;
+
+	ImVec2 p_min;
+	ImVec2 p_max;
+
+	ImVec2 uv_min;
+	ImVec2 uv_max;
+};
+
+// sprites of one texture drawn with one command
+struct SceneSpriteBatch_t
+{
+	ImTextureID texture;
+	std::vector<int> sprites;
+};
+
+// Collects scene sprites of frame and draws them grouped by texture. Sprite joins earliest batch of its texture that
+// comes after last batch with sprite it overlaps, so every overlapping pair keeps painter's order and sprites which
+// dont overlap are reordered freely.
+struct SceneSpriteBatcher_t
+{
+	void add(ImTextureID texture, const ImVec2& p_min, const ImVec2& p_max, const ImVec2& uv_min, const ImVec2& uv_max)
+	{
+		sprites.push_back({ texture, p_min, p_max, uv_min, uv_max });
+	}
+
+	static bool overlaps(const SceneSprite_t& a, const SceneSprite_t& b)
+	{
+		return a.p_min.x < b.p_max.x && b.p_min.x < a.p_max.x && a.p_min.y < b.p_max.y && b.p_min.y < a.p_max.y;
+	}
+
+	// first batch sprite can join
+	int get_first_allowed_batch(const SceneSprite_t& sprite)
+	{
+		for (int i = used_batches - 1; i >= 0; i--)
+		{
+			std::vector<int>& batch_sprites = batches.at(i).sprites;
+
+			for (int c = 0; c < batch_sprites.size(); c++)
+			{
+				if (overlaps(sprite, sprites.at(batch_sprites.at(c))))
+					return i;
+			}
+		}
+
+		return 0;
+	}
+
+	void build_batches()
+	{
+		used_batches = 0;
+
+		for (int i = 0; i < sprites.size(); i++)
+		{
+			const SceneSprite_t& sprite = sprites.at(i);
+
+			int batch_idx = -1;
+
+			for (int c = get_first_allowed_batch(sprite); c < used_batches; c++)
+			{
+				if (batches.at(c).texture == sprite.texture)
+				{
+					batch_idx = c;
+					break;
+				}
+			}
+
+			if (batch_idx == -1)
+			{
+				// batches are reused between frames, so their vectors keep capacity
+				if (used_batches == batches.size())
+					batches.emplace_back();
+
+				batch_idx = used_batches++;
+
+				batches.at(batch_idx).texture = sprite.texture;
+				batches.at(batch_idx).sprites.clear();
+			}
+
+			batches.at(batch_idx).sprites.push_back(i);
+		}
+	}
+
+	// adds collected sprites to draw list and starts next frame
+	void flush(ImDrawList* draw_list)
+	{
+		sprites_count = int(sprites.size());
+		unbatched_draw_calls = 0;
+
+		for (int i = 0; i < sprites.size(); i++)
+		{
+			if (i == 0 || sprites.at(i).texture != sprites.at(i - 1).texture)
+				unbatched_draw_calls++;
+		}
+
+		build_batches();
+
+		draw_calls = used_batches;
+
+		for (int i = 0; i < used_batches; i++)
+		{
+			SceneSpriteBatch_t& batch = batches.at(i);
+
+			draw_list->PushTextureID(batch.texture);
+			draw_list->PrimReserve(int(batch.sprites.size()) * 6, int(batch.sprites.size()) * 4);
+
+			for (int c = 0; c < batch.sprites.size(); c++)
+			{
+				const SceneSprite_t& sprite = sprites.at(batch.sprites.at(c));
+
+				draw_list->PrimRectUV(sprite.p_min, sprite.p_max, sprite.uv_min, sprite.uv_max, IM_COL32_WHITE);
+			}
+
+			draw_list->PopTextureID();
+		}
+
+		sprites.clear();
+	}
+
+	std::vector<SceneSprite_t> sprites;
+
+	std::vector<SceneSpriteBatch_t> batches;
+	int used_batches = 0;
+
+	// of last flushed scene
+	int sprites_count = 0;
+	int draw_calls = 0;
+	int unbatched_draw_calls = 0; // commands in submission order, consecutive sprites of one texture share one
+};
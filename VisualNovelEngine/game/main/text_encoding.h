@@ -0,0 +1,221 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include <emmintrin.h>
+
+// UTF-8 and wide (UTF-16 on Windows) conversion without locale facets or size limits. ASCII runs are converted 8 or
+// 16 characters at a time with SSE2, invalid sequences and lone surrogates become U+FFFD.
+
+const uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+// largest UTF-8 size of wide string, surrogate pairs take 4 bytes for 2 units
+size_t get_utf8_capacity(size_t length)
+{
+	return length * (sizeof(wchar_t) == 2 ? 3 : 4);
+}
+
+char* write_utf8_code_point(uint32_t code_point, char* out)
+{
+	if (code_point < 0x80)
+	{
+		*out++ = char(code_point);
+	}
+	else if (code_point < 0x800)
+	{
+		*out++ = char(0xC0 | (code_point >> 6));
+		*out++ = char(0x80 | (code_point & 0x3F));
+	}
+	else if (code_point < 0x10000)
+	{
+		*out++ = char(0xE0 | (code_point >> 12));
+		*out++ = char(0x80 | ((code_point >> 6) & 0x3F));
+		*out++ = char(0x80 | (code_point & 0x3F));
+	}
+	else
+	{
+		*out++ = char(0xF0 | (code_point >> 18));
+		*out++ = char(0x80 | ((code_point >> 12) & 0x3F));
+		*out++ = char(0x80 | ((code_point >> 6) & 0x3F));
+		*out++ = char(0x80 | (code_point & 0x3F));
+	}
+
+	return out;
+}
+
+// encodes wide characters from text[i], pair of surrogates as one code point
+char* encode_utf8_character(const wchar_t* text, size_t length, size_t& i, char* out)
+{
+	uint32_t code_point = uint32_t(text[i++]);
+
+	if (code_point >= 0xD800 && code_point <= 0xDFFF)
+	{
+		if (code_point <= 0xDBFF && i < length && uint32_t(text[i]) >= 0xDC00 && uint32_t(text[i]) <= 0xDFFF)
+			code_point = 0x10000 + ((code_point - 0xD800) << 10) + (uint32_t(text[i++]) - 0xDC00);
+		else
+			code_point = REPLACEMENT_CHARACTER;
+	}
+	else if (code_point > 0x10FFFF)
+	{
+		code_point = REPLACEMENT_CHARACTER;
+	}
+
+	return write_utf8_code_point(code_point, out);
+}
+
+// out needs get_utf8_capacity(length) bytes, returns bytes written, no terminator
+size_t encode_utf8(const wchar_t* text, size_t length, char* out)
+{
+	char* start = out;
+	size_t i = 0;
+
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		const __m128i non_ascii_mask = _mm_set1_epi16(short(0xFF80));
+
+		while (i + 8 <= length)
+		{
+			__m128i units = _mm_loadu_si128((const __m128i*)(text + i));
+
+			// whole block is ASCII, units are narrowed to bytes
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, non_ascii_mask), _mm_setzero_si128())) == 0xFFFF)
+			{
+				_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(units, units));
+
+				out += 8;
+				i += 8;
+
+				continue;
+			}
+
+			// pair can end one unit after block
+			size_t block_end = i + 8;
+
+			while (i < block_end)
+				out = encode_utf8_character(text, length, i, out);
+		}
+	}
+
+	while (i < length)
+		out = encode_utf8_character(text, length, i, out);
+
+	return size_t(out - start);
+}
+
+// decodes one sequence from text[i], invalid bytes which could start or continue sequence are one U+FFFD
+uint32_t decode_utf8_character(const char* text, size_t length, size_t& i)
+{
+	uint8_t lead = uint8_t(text[i++]);
+
+	if (lead < 0x80)
+		return lead;
+
+	int continuation_bytes;
+	uint32_t code_point;
+	uint32_t min_code_point;
+
+	if (lead >= 0xC2 && lead <= 0xDF)
+	{
+		continuation_bytes = 1;
+		code_point = lead & 0x1F;
+		min_code_point = 0x80;
+	}
+	else if (lead >= 0xE0 && lead <= 0xEF)
+	{
+		continuation_bytes = 2;
+		code_point = lead & 0x0F;
+		min_code_point = 0x800;
+	}
+	else if (lead >= 0xF0 && lead <= 0xF4)
+	{
+		continuation_bytes = 3;
+		code_point = lead & 0x07;
+		min_code_point = 0x10000;
+	}
+	else
+	{
+		return REPLACEMENT_CHARACTER;
+	}
+
+	for (int c = 0; c < continuation_bytes; c++)
+	{
+		if (i >= length || (uint8_t(text[i]) & 0xC0) != 0x80)
+			return REPLACEMENT_CHARACTER;
+
+		code_point = (code_point << 6) | (uint8_t(text[i++]) & 0x3F);
+	}
+
+	// overlong, surrogate or out of range
+	if (code_point < min_code_point || (code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF)
+		return REPLACEMENT_CHARACTER;
+
+	return code_point;
+}
+
+wchar_t* write_wide_code_point(uint32_t code_point, wchar_t* out)
+{
+	if (sizeof(wchar_t) == 2 && code_point >= 0x10000)
+	{
+		code_point -= 0x10000;
+
+		*out++ = wchar_t(0xD800 + (code_point >> 10));
+		*out++ = wchar_t(0xDC00 + (code_point & 0x3FF));
+
+		return out;
+	}
+
+	*out++ = wchar_t(code_point);
+	return out;
+}
+
+// out needs length wide characters, returns characters written, no terminator
+size_t decode_utf8(const char* text, size_t length, wchar_t* out)
+{
+	wchar_t* start = out;
+	size_t i = 0;
+
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		while (i + 16 <= length)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(text + i));
+
+			// whole block is ASCII, bytes are widened to units
+			if (_mm_movemask_epi8(bytes) == 0)
+			{
+				_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi8(bytes, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*)(out + 8), _mm_unpackhi_epi8(bytes, _mm_setzero_si128()));
+
+				out += 16;
+				i += 16;
+
+				continue;
+			}
+
+			// sequence can end after block
+			size_t block_end = i + 16;
+
+			while (i < block_end)
+				out = write_wide_code_point(decode_utf8_character(text, length, i), out);
+		}
+	}
+
+	while (i < length)
+		out = write_wide_code_point(decode_utf8_character(text, length, i), out);
+
+	return size_t(out - start);
+}
+
+// into string of caller, its capacity is reused
+void encode_utf8(const wchar_t* text, size_t length, std::string& out)
+{
+	out.resize(get_utf8_capacity(length));
+	out.resize(encode_utf8(text, length, &out[0]));
+}
+
+void decode_utf8(const char* text, size_t length, std::wstring& out)
+{
+	out.resize(length);
+	out.resize(decode_utf8(text, length, &out[0]));
+}
@@ -0,0 +1,337 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cfloat>
+
+#include "../../imgui/imgui.h"
+#include "../../imgui/imgui_internal.h"
+
+// runs not drawn for this many frames are dropped
+const int TEXT_RUN_CACHE_MAX_AGE = 300;
+
+// longer text is drawn without cache, run of 4 vertices per byte stays in 16-bit indices
+const size_t TEXT_RUN_MAX_BYTES = 8192;
+
+uint64_t get_text_run_hash(const char* text, const char* text_end)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (; text < text_end; text++)
+	{
+		hash ^= uint64_t(uint8_t(*text));
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// Text rendered once at origin. Drawn vertices are kept moved to position and colored as they were last drawn, and
+// indices based on first vertex of last draw, so run drawn at same place copies both as they are.
+struct TextRun_t
+{
+	ImFont* font = nullptr;
+	float font_size = 0.0f;
+	float wrap_width = 0.0f;
+	uint64_t hash = 0;
+
+	std::string text;
+
+	// at origin, white
+	std::vector<ImDrawVert> vertices;
+	std::vector<ImDrawIdx> indices;
+
+	std::vector<ImDrawVert> drawn_vertices;
+	std::vector<ImDrawIdx> drawn_indices;
+
+	ImVec2 drawn_offset;
+	ImU32 drawn_color = 0;
+	unsigned int drawn_base = 0;
+
+	// bounds of vertices at origin
+	ImVec2 min;
+	ImVec2 max;
+
+	// item size, as CalcTextSize gives it
+	ImVec2 size;
+
+	int last_used_frame = 0;
+};
+
+// Retained vertices of text which stays same between frames, keyed by font, size, wrap width and text hash. Drawing
+// cached run copies its vertices and indices into draw list and moves them to position, glyphs arent looked up and
+// text isnt wrapped again. Runs are dropped when unused for TEXT_RUN_CACHE_MAX_AGE frames, and all of them when fonts
+// are reloaded. Main thread only.
+struct TextRunCache_t
+{
+	static uint64_t get_key(ImFont* font, float font_size, float wrap_width, uint64_t hash)
+	{
+		uint32_t size_bits;
+		uint32_t wrap_bits;
+
+		memcpy(&size_bits, &font_size, sizeof(size_bits));
+		memcpy(&wrap_bits, &wrap_width, sizeof(wrap_bits));
+
+		uint64_t key = hash;
+
+		key ^= uint64_t(uintptr_t(font)) * 0x9E3779B97F4A7C15ull;
+		key ^= ((uint64_t(size_bits) << 32) | wrap_bits) * 0xC2B2AE3D27D4EB4Full;
+
+		return key;
+	}
+
+	// run of text, rendered when it isnt cached
+	TextRun_t& get_run(ImFont* font, float font_size, float wrap_width, const char* text, const char* text_end, uint64_t hash)
+	{
+		TextRun_t& run = runs[get_key(font, font_size, wrap_width, hash)];
+
+		size_t length = size_t(text_end - text);
+
+		// other text with same key takes slot
+		if (run.font != font || run.font_size != font_size || run.wrap_width != wrap_width || run.hash != hash || run.text.size() != length || memcmp(run.text.data(), text, length) != 0)
+		{
+			generate(run, font, font_size, wrap_width, text, text_end, hash);
+			frame_misses++;
+		}
+		else
+			frame_hits++;
+
+		run.last_used_frame = frame;
+
+		return run;
+	}
+
+	void generate(TextRun_t& run, ImFont* font, float font_size, float wrap_width, const char* text, const char* text_end, uint64_t hash)
+	{
+		run.font = font;
+		run.font_size = font_size;
+		run.wrap_width = wrap_width;
+		run.hash = hash;
+
+		run.text.assign(text, text_end);
+
+		// same as AddText without clipping, so run can be drawn anywhere
+		scratch_draw_list._Data = ImGui::GetDrawListSharedData();
+		scratch_draw_list._ResetForNewFrame();
+
+		font->RenderText(&scratch_draw_list, font_size, ImVec2(0.0f, 0.0f), IM_COL32_WHITE, ImVec4(-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX), text, text_end, wrap_width, false);
+
+		run.vertices.assign(scratch_draw_list.VtxBuffer.begin(), scratch_draw_list.VtxBuffer.end());
+		run.indices.assign(scratch_draw_list.IdxBuffer.begin(), scratch_draw_list.IdxBuffer.end());
+
+		run.drawn_vertices = run.vertices;
+		run.drawn_indices = run.indices;
+
+		run.drawn_offset = ImVec2(0.0f, 0.0f);
+		run.drawn_color = IM_COL32_WHITE;
+		run.drawn_base = 0;
+
+		run.min = ImVec2(FLT_MAX, FLT_MAX);
+		run.max = ImVec2(-FLT_MAX, -FLT_MAX);
+
+		for (int i = 0; i < run.vertices.size(); i++)
+		{
+			run.min = ImMin(run.min, run.vertices.at(i).pos);
+			run.max = ImMax(run.max, run.vertices.at(i).pos);
+		}
+
+		if (text == text_end)
+		{
+			run.size = ImVec2(0.0f, font_size);
+		}
+		else
+		{
+			run.size = font->CalcTextSizeA(font_size, FLT_MAX, wrap_width, text, text_end);
+			run.size.x = IM_TRUNC(run.size.x + 0.99999f);
+		}
+	}
+
+	// copies run to draw list at position, skipped when it is outside of clip rect
+	void add_run(ImDrawList* draw_list, TextRun_t& run, const ImVec2& position, ImU32 color)
+	{
+		if (run.vertices.empty())
+			return;
+
+		IM_ASSERT(run.font->ContainerAtlas->TexID == draw_list->_CmdHeader.TextureId);
+
+		// text is pixel aligned, as in RenderText
+		ImVec2 offset(IM_TRUNC(position.x), IM_TRUNC(position.y));
+
+		const ImVec4& clip_rect = draw_list->_CmdHeader.ClipRect;
+
+		if (offset.x + run.min.x > clip_rect.z || offset.x + run.max.x < clip_rect.x || offset.y + run.min.y > clip_rect.w || offset.y + run.max.y < clip_rect.y)
+			return;
+
+		int vertices_count = int(run.vertices.size());
+		int indices_count = int(run.indices.size());
+
+		draw_list->PrimReserve(indices_count, vertices_count);
+
+		// text which didnt move keeps vertices of last draw
+		if (offset.x != run.drawn_offset.x || offset.y != run.drawn_offset.y || color != run.drawn_color)
+		{
+			for (int i = 0; i < vertices_count; i++)
+			{
+				ImDrawVert& vertex = run.drawn_vertices[i];
+
+				vertex.pos.x = run.vertices[i].pos.x + offset.x;
+				vertex.pos.y = run.vertices[i].pos.y + offset.y;
+				vertex.col = color;
+			}
+
+			run.drawn_offset = offset;
+			run.drawn_color = color;
+		}
+
+		// run indices start at 0
+		unsigned int base = draw_list->_VtxCurrentIdx;
+
+		if (base != run.drawn_base)
+		{
+			for (int i = 0; i < indices_count; i++)
+				run.drawn_indices[i] = ImDrawIdx(run.indices[i] + base);
+
+			run.drawn_base = base;
+		}
+
+		memcpy(draw_list->_VtxWritePtr, run.drawn_vertices.data(), vertices_count * sizeof(ImDrawVert));
+		memcpy(draw_list->_IdxWritePtr, run.drawn_indices.data(), indices_count * sizeof(ImDrawIdx));
+
+		draw_list->_VtxWritePtr += vertices_count;
+		draw_list->_IdxWritePtr += indices_count;
+		draw_list->_VtxCurrentIdx += vertices_count;
+	}
+
+	// same as ImDrawList::AddText, hash of text can be kept by caller
+	void add_text(ImDrawList* draw_list, ImFont* font, float font_size, const ImVec2& position, ImU32 color, const char* text, const char* text_end, float wrap_width, uint64_t hash)
+	{
+		if ((color & IM_COL32_A_MASK) == 0 || text == text_end)
+			return;
+
+		if (size_t(text_end - text) > TEXT_RUN_MAX_BYTES)
+		{
+			draw_list->AddText(font, font_size, position, color, text, text_end, wrap_width);
+			return;
+		}
+
+		add_run(draw_list, get_run(font, font_size, wrap_width, text, text_end, hash), position, color);
+	}
+
+	void add_text(ImDrawList* draw_list, ImFont* font, float font_size, const ImVec2& position, ImU32 color, const char* text, const char* text_end, float wrap_width = 0.0f)
+	{
+		add_text(draw_list, font, font_size, position, color, text, text_end, wrap_width, get_text_run_hash(text, text_end));
+	}
+
+	// text item of current window, as TextEx lays it out
+	void add_item(ImGuiWindow* window, const char* text, const char* text_end, float wrap_width)
+	{
+		ImGuiContext& g = *GImGui;
+
+		TextRun_t& run = get_run(g.Font, g.FontSize, wrap_width, text, text_end, get_text_run_hash(text, text_end));
+
+		ImVec2 text_position(window->DC.CursorPos.x, window->DC.CursorPos.y + window->DC.CurrLineTextBaseOffset);
+		ImRect bb(text_position, ImVec2(text_position.x + run.size.x, text_position.y + run.size.y));
+
+		ImGui::ItemSize(run.size, 0.0f);
+
+		if (!ImGui::ItemAdd(bb, 0))
+			return;
+
+		ImU32 color = ImGui::GetColorU32(ImGuiCol_Text);
+
+		if ((color & IM_COL32_A_MASK) != 0)
+			add_run(window->DrawList, run, bb.Min, color);
+	}
+
+	// ImGui::TextWrapped without formatting
+	void text_wrapped(const char* text, const char* text_end = nullptr)
+	{
+		ImGuiWindow* window = ImGui::GetCurrentWindow();
+
+		if (window->SkipItems)
+			return;
+
+		if (!text_end)
+			text_end = text + strlen(text);
+
+		if (size_t(text_end - text) > TEXT_RUN_MAX_BYTES)
+		{
+			ImGui::PushTextWrapPos(0.0f);
+			ImGui::TextUnformatted(text, text_end);
+			ImGui::PopTextWrapPos();
+
+			return;
+		}
+
+		// pushed wrap position is kept, as in TextWrapped
+		float wrap_position = window->DC.TextWrapPos >= 0.0f ? window->DC.TextWrapPos : 0.0f;
+
+		add_item(window, text, text_end, ImGui::CalcWrapWidthForPos(window->DC.CursorPos, wrap_position));
+	}
+
+	// ImGui::TextUnformatted
+	void text_unformatted(const char* text, const char* text_end = nullptr)
+	{
+		ImGuiWindow* window = ImGui::GetCurrentWindow();
+
+		if (window->SkipItems)
+			return;
+
+		if (!text_end)
+			text_end = text + strlen(text);
+
+		if (size_t(text_end - text) > TEXT_RUN_MAX_BYTES)
+		{
+			ImGui::TextUnformatted(text, text_end);
+			return;
+		}
+
+		float wrap_width = window->DC.TextWrapPos >= 0.0f ? ImGui::CalcWrapWidthForPos(window->DC.CursorPos, window->DC.TextWrapPos) : 0.0f;
+
+		add_item(window, text, text_end, wrap_width);
+	}
+
+	// called once per frame, before NewFrame
+	void end_frame()
+	{
+		hits = frame_hits;
+		misses = frame_misses;
+
+		frame_hits = 0;
+		frame_misses = 0;
+
+		frame++;
+
+		if (frame % 60 != 0)
+			return;
+
+		for (auto it = runs.begin(); it != runs.end();)
+		{
+			if (frame - it->second.last_used_frame > TEXT_RUN_CACHE_MAX_AGE)
+				it = runs.erase(it);
+			else
+				++it;
+		}
+	}
+
+	// glyphs of fonts change when they are loaded again
+	void clear()
+	{
+		runs.clear();
+	}
+
+	std::unordered_map<uint64_t, TextRun_t> runs;
+
+	ImDrawList scratch_draw_list{ nullptr };
+
+	int frame = 0;
+
+	// of last frame
+	int hits = 0;
+	int misses = 0;
+
+	int frame_hits = 0;
+	int frame_misses = 0;
+};
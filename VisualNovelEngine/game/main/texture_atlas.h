@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+#include <Windows.h>
+#include <D3DX11.h>
+
+#include <SFML/Graphics.hpp>
+
+#include "../config.h"
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "../../imgui/stb_rect_pack.h"
+
+const int TEXTURE_ATLAS_SIZE = 4096;
+
+// transparent border around every sprite, so filtering doesnt pick pixels of neighbour sprites
+const int TEXTURE_ATLAS_PADDING = 2;
+
+struct TextureAtlasPage_t
+{
+#ifndef DCS_OPENGL
+	ID3D11Texture2D* texture = nullptr;
+	ID3D11ShaderResourceView* texture_data = nullptr;
+#else
+	sf::Texture texture_data;
+#endif
+
+	bool created = false;
+
+	// resident sprites, page is released and packed from scratch once it drops to zero. Eviction drops whole pages.
+	int sprites = 0;
+
+	stbrp_context context;
+	stbrp_node nodes[TEXTURE_ATLAS_SIZE];
+};
+
+// Packs character sprites of one scenario into few big textures, sprites drawn one after another from same page
+// share texture and are merged into one draw command. Sprites are packed as they are uploaded.
+struct TextureAtlas_t
+{
+	// finds place for sprite of given size (without padding), returns place of its padded rectangle
+	bool allocate(int width, int height, int& page_idx, int& x, int& y)
+	{
+		int padded_width = width + TEXTURE_ATLAS_PADDING * 2;
+		int padded_height = height + TEXTURE_ATLAS_PADDING * 2;
+
+		if (padded_width > TEXTURE_ATLAS_SIZE || padded_height > TEXTURE_ATLAS_SIZE)
+			return false;
+
+		for (int i = 0; i < pages.size(); i++)
+		{
+			if (pack(pages.at(i), padded_width, padded_height, x, y))
+			{
+				page_idx = i;
+				return true;
+			}
+		}
+
+		pages.emplace_back();
+		reset(pages.back());
+
+		if (!pack(pages.back(), padded_width, padded_height, x, y))
+			return false;
+
+		page_idx = pages.size() - 1;
+		return true;
+	}
+
+	void reset(TextureAtlasPage_t& page)
+	{
+		page.sprites = 0;
+		stbrp_init_target(&page.context, TEXTURE_ATLAS_SIZE, TEXTURE_ATLAS_SIZE, page.nodes, TEXTURE_ATLAS_SIZE);
+	}
+
+	bool pack(TextureAtlasPage_t& page, int width, int height, int& x, int& y)
+	{
+		stbrp_rect rect;
+
+		rect.id = 0;
+		rect.w = width;
+		rect.h = height;
+
+		stbrp_pack_rects(&page.context, &rect, 1);
+
+		if (!rect.was_packed)
+			return false;
+
+		x = rect.x;
+		y = rect.y;
+
+		page.sprites++;
+		return true;
+	}
+
+	// deque never moves pages, packer context points into page itself
+	std::deque<TextureAtlasPage_t> pages;
+};
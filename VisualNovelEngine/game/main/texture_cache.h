@@ -0,0 +1,172 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+
+#include <Windows.h>
+
+#include "texture_image.h"
+#include "trace.h"
+#include "../file_features.h"
+
+// Decoded texture cache entry (.dtc) layout: header | RGBA8 pixels, ready for upload.
+// Entries are named by hash of source path, downscale factor and trimming. Entry is valid while write time and size of
+// source match the header, if only write time changed content hash of source decides (touched or copied files).
+
+const char TEXTURE_CACHE_MAGIC[4] = { 'D', 'T', 'X', 'C' };
+const uint32_t TEXTURE_CACHE_VERSION = 2;
+
+const wchar_t* TEXTURE_CACHE_DIRECTORY = L".\\game\\cache\\textures\\";
+
+struct TextureCacheHeader_t
+{
+	char magic[4];
+	uint32_t version;
+
+	uint32_t width;
+	uint32_t height;
+
+	uint32_t source_width;
+	uint32_t source_height;
+
+	uint32_t downscale;
+	uint32_t trimmed;
+
+	uint32_t trim_x;
+	uint32_t trim_y;
+
+	uint32_t full_width;
+	uint32_t full_height;
+
+	uint64_t source_write_time;
+	uint64_t source_size;
+	uint64_t source_hash;
+};
+
+std::wstring get_texture_cache_path(const std::wstring& path, int downscale, bool trim)
+{
+	std::wstringstream cache_path;
+	cache_path << TEXTURE_CACHE_DIRECTORY << std::hex << hash_bytes(path.data(), path.size() * sizeof(wchar_t)) << std::dec << L"_" << downscale << (trim ? L"t" : L"") << L".dtc";
+
+	return cache_path.str();
+}
+
+// true if entry still matches source, header is updated if source was only touched
+bool validate_texture_cache(const std::wstring& cache_path, const std::wstring& path, TextureCacheHeader_t& header)
+{
+	uint64_t write_time;
+	uint64_t size;
+
+	if (!get_file_stamp(path, write_time, size) || size != header.source_size)
+		return false;
+
+	if (write_time == header.source_write_time)
+		return true;
+
+	std::vector<uint8_t> file_data;
+
+	if (!read_file(path, file_data) || hash_bytes(file_data.data(), file_data.size()) != header.source_hash)
+		return false;
+
+	header.source_write_time = write_time;
+
+	std::fstream file(cache_path, std::ios::binary | std::ios::in | std::ios::out);
+
+	if (file.is_open())
+		file.write((const char*)&header, sizeof(header));
+
+	return true;
+}
+
+// Maps whole entry, image keeps the view and its pixels are uploaded straight from it. Entry file can still have its
+// header updated by validate_texture_cache.
+bool read_texture_cache(const std::wstring& cache_path, const std::wstring& path, int downscale, bool trim, TextureImage_t& image)
+{
+	TraceScope_t trace_scope("read_texture_cache");
+
+	MappedFileView_t view;
+
+	if (!view.open(cache_path) || view.size < sizeof(TextureCacheHeader_t))
+		return false;
+
+	TextureCacheHeader_t header;
+	memcpy(&header, view.data, sizeof(header));
+
+	uint64_t pixels_size = uint64_t(header.width) * header.height * 4;
+
+	bool valid = memcmp(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC)) == 0 && header.version == TEXTURE_CACHE_VERSION;
+
+	valid = valid && header.downscale == uint32_t(downscale) && header.trimmed == uint32_t(trim);
+	valid = valid && sizeof(TextureCacheHeader_t) + pixels_size == view.size;
+
+	if (!valid || !validate_texture_cache(cache_path, path, header))
+		return false;
+
+	image.width = header.width;
+	image.height = header.height;
+
+	image.source_width = header.source_width;
+	image.source_height = header.source_height;
+
+	image.trim_x = header.trim_x;
+	image.trim_y = header.trim_y;
+
+	image.full_width = header.full_width;
+	image.full_height = header.full_height;
+
+	image.pixels.clear();
+
+	image.mapped_pixels = view.data + sizeof(TextureCacheHeader_t);
+	image.mapped_file = std::move(view);
+
+	return true;
+}
+
+bool write_texture_cache(const std::wstring& cache_path, const std::wstring& path, int downscale, bool trim, TextureImage_t& image, uint64_t source_hash)
+{
+	TraceScope_t trace_scope("write_texture_cache");
+
+	TextureCacheHeader_t header;
+	memset(&header, 0, sizeof(header));
+
+	memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+	header.version = TEXTURE_CACHE_VERSION;
+
+	header.width = image.width;
+	header.height = image.height;
+
+	header.source_width = image.source_width;
+	header.source_height = image.source_height;
+
+	header.downscale = downscale;
+	header.trimmed = trim;
+
+	header.trim_x = image.trim_x;
+	header.trim_y = image.trim_y;
+
+	header.full_width = image.full_width;
+	header.full_height = image.full_height;
+
+	header.source_hash = source_hash;
+
+	if (!get_file_stamp(path, header.source_write_time, header.source_size))
+		return false;
+
+	std::ofstream file(cache_path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)image.data(), image.memory_size());
+
+	bool written = file.good();
+	file.close();
+
+	if (!written)
+		DeleteFileW(cache_path.c_str());
+
+	return written;
+}
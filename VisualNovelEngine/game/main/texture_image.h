@@ -0,0 +1,331 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <emmintrin.h>
+
+#include <SFML/Graphics.hpp>
+
+#include "../file_features.h"
+#include "trace.h"
+
+// decoded RGBA8 pixels, ready for upload
+struct TextureImage_t
+{
+	unsigned width = 0;
+	unsigned height = 0;
+
+	// size of source image, bigger than width and height for downscaled textures
+	unsigned source_width = 0;
+	unsigned source_height = 0;
+
+	// trimmed images keep only rectangle at trim_x, trim_y of full_width x full_height image
+	unsigned trim_x = 0;
+	unsigned trim_y = 0;
+
+	unsigned full_width = 0;
+	unsigned full_height = 0;
+
+	// pixels are either owned, or in view of decoded texture cache entry, which is uploaded without copying
+	std::vector<uint8_t> pixels;
+
+	MappedFileView_t mapped_file;
+	const uint8_t* mapped_pixels = nullptr;
+
+	const uint8_t* data() const
+	{
+		return mapped_pixels ? mapped_pixels : pixels.data();
+	}
+
+	size_t memory_size() const
+	{
+		return size_t(width) * height * 4;
+	}
+
+	// copies mapped pixels before image is changed
+	void own_pixels()
+	{
+		if (!mapped_pixels)
+			return;
+
+		pixels.assign(mapped_pixels, mapped_pixels + memory_size());
+
+		mapped_pixels = nullptr;
+		mapped_file.close();
+	}
+};
+
+bool decode_texture_memory(const void* data, size_t size, TextureImage_t& image)
+{
+	TraceScope_t trace_scope("decode_texture_memory");
+
+	sf::Image decoded;
+
+	if (!decoded.loadFromMemory(data, size))
+		return false;
+
+	image.width = decoded.getSize().x;
+	image.height = decoded.getSize().y;
+
+	image.source_width = image.width;
+	image.source_height = image.height;
+
+	image.trim_x = 0;
+	image.trim_y = 0;
+
+	image.full_width = image.width;
+	image.full_height = image.height;
+
+	const uint8_t* pixels = decoded.getPixelsPtr();
+	image.pixels.assign(pixels, pixels + size_t(image.width) * image.height * 4);
+
+	return true;
+}
+
+// 1 for high texture quality, 2 (half resolution, quarter of memory) for low
+int get_texture_downscale(int texture_quality)
+{
+	return texture_quality == 0 ? 2 : 1;
+}
+
+// box filter weighted by alpha, so transparent pixels dont darken edges of characters
+void downscale_texture(TextureImage_t& image, int factor)
+{
+	if (factor <= 1 || image.width == 0 || image.height == 0)
+		return;
+
+	image.own_pixels();
+
+	unsigned width = (image.width + factor - 1) / factor;
+	unsigned height = (image.height + factor - 1) / factor;
+
+	std::vector<uint8_t> pixels(size_t(width) * height * 4);
+
+	for (unsigned y = 0; y < height; y++)
+	{
+		unsigned source_y_end = (y + 1) * factor < image.height ? (y + 1) * factor : image.height;
+
+		for (unsigned x = 0; x < width; x++)
+		{
+			unsigned source_x_end = (x + 1) * factor < image.width ? (x + 1) * factor : image.width;
+
+			uint32_t r = 0;
+			uint32_t g = 0;
+			uint32_t b = 0;
+			uint32_t a = 0;
+
+			uint32_t count = 0;
+
+			for (unsigned source_y = y * factor; source_y < source_y_end; source_y++)
+			{
+				const uint8_t* source = image.pixels.data() + (size_t(source_y) * image.width + x * factor) * 4;
+
+				for (unsigned source_x = x * factor; source_x < source_x_end; source_x++, source += 4)
+				{
+					r += source[0] * source[3];
+					g += source[1] * source[3];
+					b += source[2] * source[3];
+					a += source[3];
+
+					count++;
+				}
+			}
+
+			uint8_t* pixel = pixels.data() + (size_t(y) * width + x) * 4;
+
+			if (a > 0)
+			{
+				pixel[0] = uint8_t((r + a / 2) / a);
+				pixel[1] = uint8_t((g + a / 2) / a);
+				pixel[2] = uint8_t((b + a / 2) / a);
+			}
+			else
+			{
+				pixel[0] = 0;
+				pixel[1] = 0;
+				pixel[2] = 0;
+			}
+
+			pixel[3] = uint8_t((a + count / 2) / count);
+		}
+	}
+
+	image.width = width;
+	image.height = height;
+
+	image.full_width = width;
+	image.full_height = height;
+
+	image.pixels.swap(pixels);
+}
+
+// blends layer over image, both in straight alpha. False if sizes dont match.
+bool blend_texture_layer(TextureImage_t& image, const TextureImage_t& layer)
+{
+	if (image.width != layer.width || image.height != layer.height)
+		return false;
+
+	image.own_pixels();
+
+	uint8_t* destination = image.pixels.data();
+	const uint8_t* source = layer.data();
+
+	for (size_t i = 0; i < image.pixels.size(); i += 4)
+	{
+		uint32_t source_alpha = source[i + 3];
+
+		if (source_alpha == 0)
+			continue;
+
+		if (source_alpha == 255)
+		{
+			memcpy(destination + i, source + i, 4);
+			continue;
+		}
+
+		// all values are scaled by 255
+		uint32_t destination_alpha = destination[i + 3] * (255 - source_alpha);
+		uint32_t alpha = source_alpha * 255 + destination_alpha;
+
+		for (int c = 0; c < 3; c++)
+			destination[i + c] = uint8_t((source[i + c] * source_alpha * 255 + destination[i + c] * destination_alpha + alpha / 2) / alpha);
+
+		destination[i + 3] = uint8_t((alpha + 127) / 255);
+	}
+
+	return true;
+}
+
+// first pixel with non zero alpha in [begin, end) of row, end if there is none. Checks 4 pixels at once.
+unsigned find_opaque_pixel(const uint8_t* row, unsigned begin, unsigned end)
+{
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+	const __m128i zero = _mm_setzero_si128();
+
+	unsigned x = begin;
+
+	for (; x + 4 <= end; x += 4)
+	{
+		__m128i alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)(row + x * 4)), alpha_mask);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) != 0xFFFF)
+			break;
+	}
+
+	for (; x < end; x++)
+	{
+		if (row[x * 4 + 3])
+			return x;
+	}
+
+	return end;
+}
+
+// last pixel with non zero alpha in [begin, end) of row, begin if there is none
+unsigned find_last_opaque_pixel(const uint8_t* row, unsigned begin, unsigned end)
+{
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+	const __m128i zero = _mm_setzero_si128();
+
+	unsigned x = end;
+
+	for (; x >= begin + 4; x -= 4)
+	{
+		__m128i alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)(row + (x - 4) * 4)), alpha_mask);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) != 0xFFFF)
+			break;
+	}
+
+	for (; x > begin; x--)
+	{
+		if (row[(x - 1) * 4 + 3])
+			return x - 1;
+	}
+
+	return begin;
+}
+
+// crops fully transparent borders, character textures are mostly transparent full size canvases
+void trim_texture(TextureImage_t& image)
+{
+	image.own_pixels();
+
+	size_t pitch = size_t(image.width) * 4;
+
+	unsigned top = 0;
+
+	while (top < image.height && find_opaque_pixel(image.pixels.data() + top * pitch, 0, image.width) == image.width)
+		top++;
+
+	// keep single transparent pixel of empty image
+	if (top == image.height)
+	{
+		image.trim_x = 0;
+		image.trim_y = 0;
+
+		image.width = 1;
+		image.height = 1;
+
+		image.pixels.assign(4, 0);
+		return;
+	}
+
+	unsigned bottom = image.height - 1;
+
+	while (bottom > top && find_opaque_pixel(image.pixels.data() + bottom * pitch, 0, image.width) == image.width)
+		bottom--;
+
+	unsigned left = image.width;
+	unsigned right = 0;
+
+	// every row only has to be checked outside of bounds found so far
+	for (unsigned y = top; y <= bottom; y++)
+	{
+		const uint8_t* row = image.pixels.data() + y * pitch;
+
+		left = find_opaque_pixel(row, 0, left);
+
+		unsigned last = find_last_opaque_pixel(row, right, image.width);
+
+		if (last > right)
+			right = last;
+	}
+
+	if (left > right)
+		right = left;
+
+	unsigned width = right - left + 1;
+	unsigned height = bottom - top + 1;
+
+	if (width == image.width && height == image.height)
+		return;
+
+	std::vector<uint8_t> pixels(size_t(width) * height * 4);
+
+	for (unsigned y = 0; y < height; y++)
+		memcpy(pixels.data() + size_t(y) * width * 4, image.pixels.data() + (top + y) * pitch + size_t(left) * 4, size_t(width) * 4);
+
+	image.trim_x += left;
+	image.trim_y += top;
+
+	image.width = width;
+	image.height = height;
+
+	image.pixels.swap(pixels);
+}
+
+// FNV-1a, stable between launches unlike std::hash
+uint64_t hash_bytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
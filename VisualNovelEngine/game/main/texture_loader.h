@@ -0,0 +1,283 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "texture_image.h"
+#include "texture_cache.h"
+#include "trace.h"
+
+// loads texture from decoded texture cache, decodes and caches it on cache miss
+bool load_texture_file(const std::wstring& path, int downscale, bool trim, TextureImage_t& image)
+{
+	TraceScope_t trace_scope("load_texture_file");
+
+	std::wstring cache_path = get_texture_cache_path(path, downscale, trim);
+
+	if (read_texture_cache(cache_path, path, downscale, trim, image))
+		return true;
+
+	std::vector<uint8_t> file_data;
+
+	if (!read_file(path, file_data) || !decode_texture_memory(file_data.data(), file_data.size(), image))
+		return false;
+
+	downscale_texture(image, downscale);
+
+	if (trim)
+		trim_texture(image);
+
+	// if cache cant be written texture is just decoded again next time
+	write_texture_cache(cache_path, path, downscale, trim, image, hash_bytes(file_data.data(), file_data.size()));
+
+	return true;
+}
+
+// blends layers in order, layers are cached untrimmed and composite is trimmed as whole
+bool load_composite_texture(const std::vector<std::wstring>& layers, int downscale, bool trim, TextureImage_t& image)
+{
+	TraceScope_t trace_scope("load_composite_texture");
+
+	if (layers.empty() || !load_texture_file(layers.at(0), downscale, false, image))
+		return false;
+
+	for (int i = 1; i < layers.size(); i++)
+	{
+		TextureImage_t layer;
+
+		if (!load_texture_file(layers.at(i), downscale, false, layer) || !blend_texture_layer(image, layer))
+			return false;
+	}
+
+	if (trim)
+		trim_texture(image);
+
+	return true;
+}
+
+struct TextureLoadJob_t
+{
+	int scenario_idx;
+	int texture_idx;
+
+	// Scenario_t::texture_generation at queue time, results for older generations are dropped
+	int generation;
+
+	std::wstring path;
+
+	// see get_texture_downscale
+	int downscale = 1;
+
+	// crop transparent borders, see trim_texture
+	bool trim = false;
+
+	// paths of composite texture layers, path is empty then
+	std::vector<std::wstring> layers;
+};
+
+struct DecodedTexture_t
+{
+	TextureLoadJob_t job;
+
+	bool decoded;
+	TextureImage_t image;
+};
+
+// Decodes textures on worker threads. Decoded images wait in a bounded queue until render thread uploads them.
+struct TextureLoader_t
+{
+	typedef void (*ReadyFunction_t)();
+
+	~TextureLoader_t()
+	{
+		shutdown();
+	}
+
+	void start(int worker_count, int max_decoded_textures)
+	{
+		if (workers.size() > 0)
+			return;
+
+		stopping = false;
+		max_decoded = max_decoded_textures > 0 ? max_decoded_textures : 1;
+
+		for (int i = 0; i < worker_count; i++)
+			workers.emplace_back(&TextureLoader_t::worker_thread, this);
+	}
+
+	void shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			stopping = true;
+
+			pending.clear();
+			decoded.clear();
+		}
+
+		jobs_changed.notify_all();
+		decoded_changed.notify_all();
+
+		for (int i = 0; i < workers.size(); i++)
+		{
+			if (workers.at(i).joinable())
+				workers.at(i).join();
+		}
+
+		workers.clear();
+	}
+
+	void queue(const TextureLoadJob_t& job, bool urgent)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (urgent)
+				pending.push_front(job);
+			else
+				pending.push_back(job);
+		}
+
+		jobs_changed.notify_one();
+	}
+
+	// moves pending jobs of scenario to front of queue
+	void prioritize(int scenario_idx)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::deque<TextureLoadJob_t> prioritized;
+		std::deque<TextureLoadJob_t> other;
+
+		for (int i = 0; i < pending.size(); i++)
+		{
+			if (pending.at(i).scenario_idx == scenario_idx)
+				prioritized.push_back(pending.at(i));
+			else
+				other.push_back(pending.at(i));
+		}
+
+		prioritized.insert(prioritized.end(), other.begin(), other.end());
+		pending.swap(prioritized);
+	}
+
+	// drops pending jobs of scenario, -1 drops all jobs. Jobs in progress are dropped by generation check on upload.
+	void cancel(int scenario_idx)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			for (int i = 0; i < pending.size();)
+			{
+				if (scenario_idx == -1 || pending.at(i).scenario_idx == scenario_idx)
+					pending.erase(pending.begin() + i);
+				else
+					i++;
+			}
+
+			for (int i = 0; i < decoded.size();)
+			{
+				if (scenario_idx == -1 || decoded.at(i).job.scenario_idx == scenario_idx)
+					decoded.erase(decoded.begin() + i);
+				else
+					i++;
+			}
+		}
+
+		decoded_changed.notify_all();
+	}
+
+	bool pop_decoded(DecodedTexture_t& texture)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (decoded.empty())
+				return false;
+
+			texture = std::move(decoded.front());
+			decoded.pop_front();
+		}
+
+		decoded_changed.notify_one();
+		return true;
+	}
+
+	// decoded textures wait for upload
+	bool has_decoded()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return decoded.size() > 0;
+	}
+
+	bool is_busy()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return pending.size() > 0 || decoded.size() > 0 || decoding > 0;
+	}
+
+	void worker_thread()
+	{
+		tracer.set_thread_name("Texture worker");
+
+		while (true)
+		{
+			DecodedTexture_t texture;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				jobs_changed.wait(lock, [this] { return stopping || !pending.empty(); });
+
+				if (stopping)
+					return;
+
+				texture.job = pending.front();
+				pending.pop_front();
+
+				decoding++;
+			}
+
+			if (texture.job.layers.empty())
+				texture.decoded = load_texture_file(texture.job.path, texture.job.downscale, texture.job.trim, texture.image);
+			else
+				texture.decoded = load_composite_texture(texture.job.layers, texture.job.downscale, texture.job.trim, texture.image);
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				decoded_changed.wait(lock, [this] { return stopping || decoded.size() < max_decoded; });
+
+				decoding--;
+
+				if (stopping)
+					return;
+
+				decoded.push_back(std::move(texture));
+			}
+
+			if (ready)
+				ready();
+		}
+	}
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable jobs_changed;
+	std::condition_variable decoded_changed;
+
+	std::deque<TextureLoadJob_t> pending;
+	std::deque<DecodedTexture_t> decoded;
+
+	// called by workers after texture was decoded, render thread may be waiting for it
+	ReadyFunction_t ready = nullptr;
+
+	int decoding = 0;
+	int max_decoded = 1;
+
+	bool stopping = false;
+};
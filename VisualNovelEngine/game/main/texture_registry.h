@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <unordered_map>
+
+#include "scenario_names.h"
+
+typedef int TextureHandle_t;
+
+const TextureHandle_t INVALID_TEXTURE_HANDLE = -1;
+
+// handles of left, right and head parts of composite character texture, missing parts are invalid
+typedef std::array<TextureHandle_t, 3> TextureCompositeKey_t;
+
+// Maps texture names of one scenario to handles (indices in Scenario_t::textures).
+// Scenes resolve their texture names to handles once, frames only index textures by handle.
+struct TextureRegistry_t
+{
+	template <class T>
+	void build(const std::vector<T>& textures)
+	{
+		handles.clear();
+		handles.reserve(textures.size());
+
+		composites.clear();
+
+		for (int i = 0; i < textures.size(); i++)
+			handles.emplace(scenario_name_table.intern(textures.at(i).texture_name), i);
+	}
+
+	void clear()
+	{
+		handles.clear();
+		composites.clear();
+	}
+
+	TextureHandle_t find(std::wstring_view texture_name) const
+	{
+		if (texture_name == L"NONE")
+			return INVALID_TEXTURE_HANDLE;
+
+		auto it = handles.find(texture_name);
+
+		if (it == handles.end())
+			return INVALID_TEXTURE_HANDLE;
+
+		return it->second;
+	}
+
+	TextureHandle_t find_composite(const TextureCompositeKey_t& key) const
+	{
+		auto it = composites.find(key);
+
+		if (it == composites.end())
+			return INVALID_TEXTURE_HANDLE;
+
+		return it->second;
+	}
+
+	// keys are interned names
+	std::unordered_map<std::wstring_view, TextureHandle_t> handles;
+
+	// composites arent texture files, they are found by their parts instead of names
+	std::map<TextureCompositeKey_t, TextureHandle_t> composites;
+};
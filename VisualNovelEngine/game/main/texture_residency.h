@@ -0,0 +1,172 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+#include "scenario.h"
+
+// separate texture, or atlas page which is evicted with all of its sprites
+struct TextureEvictionCandidate_t
+{
+	Scenario_t* scenario;
+	ScenarioTexture_t* texture;
+	TextureAtlasPage_t* page;
+
+	uint64_t last_used_frame;
+};
+
+// Keeps textures of upcoming scenes resident and evicts least recently used ones when memory budget is exceeded.
+struct TextureResidency_t
+{
+	void begin_frame()
+	{
+		frame++;
+
+		previous_kept_textures = kept_textures;
+		kept_textures = 0;
+
+		kept_textures_added = false;
+	}
+
+	// texture was drawn this frame
+	void touch(ScenarioTexture_t& texture)
+	{
+		texture.last_used_frame = frame;
+
+		if (texture.ready)
+			hits++;
+		else
+			misses++;
+	}
+
+	// texture is used by one of upcoming scenes, it cant be evicted this frame
+	void keep(ScenarioTexture_t& texture)
+	{
+		if (texture.prefetch_frame == frame)
+			return;
+
+		if (texture.prefetch_frame + 1 != frame)
+			kept_textures_added = true;
+
+		texture.prefetch_frame = frame;
+		kept_textures++;
+	}
+
+	// Textures of frame are kept before eviction and drawn after it, so only kept textures are needed while candidates
+	// are collected. If nothing could be evicted, scan is repeated only after resident textures or kept ones change.
+	// Without added textures kept set is same if it has same size.
+	bool can_evict()
+	{
+		return !eviction_blocked || resident_bytes != blocked_resident_bytes || kept_textures_added || kept_textures != previous_kept_textures;
+	}
+
+	void block_eviction()
+	{
+		eviction_blocked = true;
+		blocked_resident_bytes = resident_bytes;
+	}
+
+	void unblock_eviction()
+	{
+		eviction_blocked = false;
+	}
+
+	bool is_over_budget()
+	{
+		return budget_bytes > 0 && resident_bytes > budget_bytes;
+	}
+
+	float hit_rate()
+	{
+		if (hits + misses == 0)
+			return 1.0f;
+
+		return float(double(hits) / double(hits + misses));
+	}
+
+	// Least recently used resident textures which are not needed by current or upcoming scenes. Space of single
+	// atlas sprite cant be reused, so atlas pages are candidates as whole, used as recently as their newest sprite and
+	// only when none of their sprites is needed.
+	// Containers are kept between calls.
+	std::vector<TextureEvictionCandidate_t>& collect_eviction_candidates(std::vector<Scenario_t>& scenarios)
+	{
+		candidates.clear();
+		pages.clear();
+
+		for (int i = 0; i < scenarios.size(); i++)
+		{
+			for (int c = 0; c < scenarios.at(i).textures.size(); c++)
+			{
+				ScenarioTexture_t& texture = scenarios.at(i).textures.at(c);
+
+				if (!texture.ready)
+					continue;
+
+				bool needed = texture.last_used_frame == frame || texture.prefetch_frame == frame;
+
+				if (!texture.atlas_page)
+				{
+					if (!needed)
+						candidates.push_back({ &scenarios.at(i), &texture, nullptr, texture.last_used_frame });
+
+					continue;
+				}
+
+				auto it = pages.find(texture.atlas_page);
+
+				if (it == pages.end())
+				{
+					it = pages.emplace(texture.atlas_page, int(candidates.size())).first;
+					candidates.push_back({ &scenarios.at(i), nullptr, texture.atlas_page, 0 });
+				}
+
+				if (it->second == -1)
+					continue;
+
+				if (needed)
+				{
+					candidates.at(it->second).page = nullptr;
+					it->second = -1;
+				}
+				else
+					candidates.at(it->second).last_used_frame = std::max(candidates.at(it->second).last_used_frame, texture.last_used_frame);
+			}
+		}
+
+		// pages with needed sprites were left with neither texture nor page
+		candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [](const TextureEvictionCandidate_t& candidate) { return !candidate.texture && !candidate.page; }), candidates.end());
+
+		std::sort(candidates.begin(), candidates.end(), [](const TextureEvictionCandidate_t& a, const TextureEvictionCandidate_t& b) { return a.last_used_frame < b.last_used_frame; });
+
+		return candidates;
+	}
+
+	uint64_t frame = 0;
+
+	size_t budget_bytes = 0; // 0 - unlimited
+	int prefetch_scenes = 5;
+
+	size_t resident_bytes = 0;
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+
+	uint64_t prefetches = 0;
+	uint64_t evictions = 0;
+
+	std::vector<TextureEvictionCandidate_t> candidates;
+
+	// index in candidates, -1 for pages with needed sprites
+	std::unordered_map<TextureAtlasPage_t*, int> pages;
+
+	int kept_textures = 0;
+	int previous_kept_textures = 0;
+
+	// some texture kept this frame wasnt kept in previous one
+	bool kept_textures_added = false;
+
+	// last scan left textures over budget, all of them were needed
+	bool eviction_blocked = false;
+	size_t blocked_resident_bytes = 0;
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+#include <Windows.h>
+
+// events reserved per thread up front, so appending rarely reallocates
+const size_t TRACE_THREAD_EVENTS_RESERVE = 1 << 16;
+
+// about 24 MB per thread, later scopes of thread are dropped
+const size_t TRACE_THREAD_MAX_EVENTS = 1 << 20;
+
+struct TraceEvent_t
+{
+	const char* name; // string literal, not copied
+	char phase; // 'B' begin, 'E' end
+	int64_t timestamp_ns;
+};
+
+struct TraceThreadBuffer_t
+{
+	DWORD thread_id = 0;
+	std::string thread_name;
+
+	std::vector<TraceEvent_t> events;
+
+	// scopes begun after buffer was full, their end events are dropped too so recorded scopes stay balanced
+	int dropped_depth = 0;
+
+	uint64_t dropped_scopes = 0;
+	int64_t full_timestamp_ns = 0;
+};
+
+// Records begin and end events into per thread buffers and writes them as Chrome trace JSON (about://tracing, Perfetto).
+// Every thread appends only to its own buffer, mutex is taken once per thread when its buffer is created.
+// Buffers are read only by write, after all traced threads stopped.
+struct Tracer_t
+{
+	void start()
+	{
+		start_time = std::chrono::steady_clock::now();
+		enabled = true;
+	}
+
+	TraceThreadBuffer_t& thread_buffer()
+	{
+		thread_local TraceThreadBuffer_t* buffer = nullptr;
+
+		if (!buffer)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			buffers.push_back(std::make_unique<TraceThreadBuffer_t>());
+
+			buffer = buffers.back().get();
+			buffer->thread_id = GetCurrentThreadId();
+			buffer->events.reserve(TRACE_THREAD_EVENTS_RESERVE);
+		}
+
+		return *buffer;
+	}
+
+	void set_thread_name(const char* name)
+	{
+		if (enabled)
+			thread_buffer().thread_name = name;
+	}
+
+	void begin(const char* name)
+	{
+		if (!enabled)
+			return;
+
+		TraceThreadBuffer_t& buffer = thread_buffer();
+
+		if (buffer.dropped_depth > 0 || buffer.events.size() >= TRACE_THREAD_MAX_EVENTS)
+		{
+			if (buffer.dropped_scopes++ == 0)
+				buffer.full_timestamp_ns = timestamp();
+
+			buffer.dropped_depth++;
+			return;
+		}
+
+		buffer.events.push_back({ name, 'B', timestamp() });
+	}
+
+	// ends of recorded scopes are kept past TRACE_THREAD_MAX_EVENTS, there are at most as many as scopes are nested
+	void end(const char* name)
+	{
+		if (!enabled)
+			return;
+
+		TraceThreadBuffer_t& buffer = thread_buffer();
+
+		if (buffer.dropped_depth > 0)
+		{
+			buffer.dropped_depth--;
+			return;
+		}
+
+		buffer.events.push_back({ name, 'E', timestamp() });
+	}
+
+	int64_t timestamp()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+	}
+
+	bool write(const std::wstring& path)
+	{
+		std::ofstream file(path, std::ios::trunc);
+
+		if (!file.is_open())
+			return false;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		bool first = true;
+
+		for (int i = 0; i < buffers.size(); i++)
+		{
+			TraceThreadBuffer_t& buffer = *buffers.at(i);
+
+			if (!buffer.thread_name.empty())
+			{
+				file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.thread_id << ",\"args\":{\"name\":\"" << buffer.thread_name << "\"}}";
+				first = false;
+			}
+
+			for (int c = 0; c < buffer.events.size(); c++)
+			{
+				TraceEvent_t& event = buffer.events.at(c);
+
+				// microseconds with nanosecond fraction
+				file << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << buffer.thread_id << ",\"ts\":" << event.timestamp_ns / 1000 << "." << std::to_string(1000 + event.timestamp_ns % 1000).substr(1) << "}";
+				first = false;
+			}
+
+			// instant event marks where thread stopped being traced
+			if (buffer.dropped_scopes > 0)
+			{
+				file << (first ? "" : ",\n") << "{\"name\":\"Trace buffer full\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer.thread_id << ",\"ts\":" << buffer.full_timestamp_ns / 1000 << ",\"args\":{\"dropped_scopes\":" << buffer.dropped_scopes << "}}";
+				first = false;
+			}
+		}
+
+		file << "\n]}\n";
+
+		return file.good();
+	}
+
+	bool enabled = false;
+
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+	std::mutex mutex;
+	std::vector<std::unique_ptr<TraceThreadBuffer_t>> buffers;
+};
+
+// enabled with -trace launch parameter
+Tracer_t tracer;
+
+// traces until end of scope
+struct TraceScope_t
+{
+	TraceScope_t(const char* name) : name(name)
+	{
+		tracer.begin(name);
+	}
+
+	~TraceScope_t()
+	{
+		tracer.end(name);
+	}
+
+	const char* name;
+};
@@ -3,17 +3,87 @@
 #include <Windows.h>
 #include <D3DX11.h>
 #include <vector>
+#include <cstdint>
+#include <cwchar>
+
+// FNV-1a of wide string, constexpr so literal keys can be hashed by compiler
+constexpr uint64_t get_translation_hash(const wchar_t* text)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (; *text; text++)
+	{
+		hash ^= uint64_t(*text);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
 
 struct TranslatedText_t
 {
 	std::wstring original_text;
 	std::wstring translation_text;
+
+	// encoded once when language is loaded, imgui takes UTF-8
+	std::string translation_utf8;
+
+	uint64_t original_hash = 0;
 };
 
 struct GameLanguage_t
 {
+	// open addressing table of string indices by hash of original text, at most half full
+	void build_catalog()
+	{
+		size_t size = 16;
+
+		while (size < strings.size() * 2)
+			size *= 2;
+
+		catalog.assign(size, -1);
+
+		for (int i = 0; i < strings.size(); i++)
+		{
+			TranslatedText_t& string = strings.at(i);
+
+			string.original_hash = get_translation_hash(string.original_text.c_str());
+
+			size_t slot = size_t(string.original_hash) & (size - 1);
+
+			// first translation of original text is used, as with linear search before
+			while (catalog.at(slot) != -1 && strings.at(catalog.at(slot)).original_text != string.original_text)
+				slot = (slot + 1) & (size - 1);
+
+			if (catalog.at(slot) == -1)
+				catalog.at(slot) = i;
+		}
+	}
+
+	// nullptr if original text has no translation, doesnt allocate
+	const TranslatedText_t* find(const wchar_t* original, uint64_t hash) const
+	{
+		if (catalog.empty())
+			return nullptr;
+
+		size_t mask = catalog.size() - 1;
+
+		for (size_t slot = size_t(hash) & mask; catalog[slot] != -1; slot = (slot + 1) & mask)
+		{
+			const TranslatedText_t& string = strings[catalog[slot]];
+
+			if (string.original_hash == hash && wcscmp(string.original_text.c_str(), original) == 0)
+				return &string;
+		}
+
+		return nullptr;
+	}
+
 	std::wstring name;
 	std::wstring codepage;
 
+	std::string name_utf8;
+
 	std::vector<TranslatedText_t> strings;
-};
\ No newline at end of file
+	std::vector<int> catalog;
+};
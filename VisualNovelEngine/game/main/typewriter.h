@@ -0,0 +1,178 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "../../imgui/imgui.h"
+#include "../../imgui/imgui_internal.h"
+
+#include "text_run_cache.h"
+
+// longest frame time typewriter advances by, so frame after idle wait doesnt reveal text at once. Idle loop waits for
+// next character, so one character is always revealed after its wait.
+const float TYPEWRITER_MAX_DELTA_TIME = 0.1f;
+
+struct TextLayoutLine_t
+{
+	// bytes of layout text
+	int begin = 0;
+	int end = 0;
+
+	// of line text, key of its cached run
+	uint64_t hash = 0;
+};
+
+// Text wrapped to width once, as imgui wraps it: lines break at words, blanks at start of wrapped line are skipped.
+// Lines keep their place while text is revealed, so words dont jump to next line when they grow past width.
+struct TextLayout_t
+{
+	void build(ImFont* font, const std::string& utf8_text, float wrap_width)
+	{
+		text = utf8_text;
+		lines.clear();
+		character_offsets.clear();
+
+		line_height = font->FontSize;
+		size = ImVec2(0.0f, 0.0f);
+
+		const char* text_begin = text.c_str();
+		const char* text_end = text_begin + text.size();
+
+		const char* s = text_begin;
+
+		while (s < text_end)
+		{
+			const char* hard_end = (const char*)memchr(s, '\n', size_t(text_end - s));
+
+			if (!hard_end)
+				hard_end = text_end;
+
+			const char* line_end = hard_end;
+
+			if (wrap_width > 0.0f && s < hard_end)
+				line_end = font->CalcWordWrapPositionA(1.0f, s, hard_end, wrap_width);
+
+			// word wider than line still takes one character
+			if (line_end == s && s < hard_end)
+				line_end = s + ImTextCountUtf8BytesFromChar(s, hard_end);
+
+			add_line(font, int(s - text_begin), int(line_end - text_begin));
+
+			s = line_end;
+
+			while (s < hard_end && (*s == ' ' || *s == '\t'))
+				s++;
+
+			// new line ends line, it isnt drawn
+			if (s == hard_end && s < text_end)
+				s++;
+		}
+
+		// byte offset of every character, revealed count maps to text end without scanning
+		for (int i = 0; i < text.size();)
+		{
+			character_offsets.push_back(i);
+			i += ImTextCountUtf8BytesFromChar(text_begin + i, text_end);
+		}
+
+		characters = int(character_offsets.size());
+		character_offsets.push_back(int(text.size()));
+	}
+
+	void add_line(ImFont* font, int begin, int end)
+	{
+		TextLayoutLine_t line;
+
+		line.begin = begin;
+		line.end = end;
+		line.hash = get_text_run_hash(text.c_str() + begin, text.c_str() + end);
+
+		lines.push_back(line);
+
+		float width = font->CalcTextSizeA(font->FontSize, FLT_MAX, 0.0f, text.c_str() + begin, text.c_str() + end).x;
+
+		size.x = std::max(size.x, width);
+		size.y += line_height;
+	}
+
+	// draws characters before revealed at cursor of current window, item takes size of whole text. Revealed lines are
+	// drawn from cache, line being revealed changes every few frames and is drawn directly.
+	void draw(int revealed, TextRunCache_t& text_run_cache) const
+	{
+		ImVec2 position = ImGui::GetCursorScreenPos();
+
+		ImDrawList* draw_list = ImGui::GetWindowDrawList();
+		ImU32 color = ImGui::GetColorU32(ImGuiCol_Text);
+
+		int revealed_end = character_offsets.empty() ? 0 : character_offsets.at(std::clamp(revealed, 0, characters));
+
+		for (int i = 0; i < lines.size(); i++)
+		{
+			const TextLayoutLine_t& line = lines.at(i);
+
+			if (line.begin >= revealed_end)
+				break;
+
+			ImVec2 line_position(position.x, position.y + line_height * i);
+
+			if (line.end <= revealed_end)
+				text_run_cache.add_text(draw_list, ImGui::GetFont(), ImGui::GetFontSize(), line_position, color, text.c_str() + line.begin, text.c_str() + line.end, 0.0f, line.hash);
+			else
+				draw_list->AddText(ImGui::GetFont(), ImGui::GetFontSize(), line_position, color, text.c_str() + line.begin, text.c_str() + revealed_end);
+		}
+
+		ImGui::Dummy(size);
+	}
+
+	std::string text;
+
+	std::vector<TextLayoutLine_t> lines;
+	std::vector<int> character_offsets;
+
+	int characters = 0;
+
+	float line_height = 0.0f;
+	ImVec2 size;
+};
+
+// Reveals text by time, text_animation_speed is characters per second. Frame only moves reveal position.
+struct Typewriter_t
+{
+	void restart()
+	{
+		revealed = 0.0f;
+	}
+
+	void advance(float delta_time, float characters_per_second, int characters)
+	{
+		if (characters_per_second <= 0.0f)
+			return;
+
+		float max_delta_time = std::max(TYPEWRITER_MAX_DELTA_TIME, 1.0f / characters_per_second);
+
+		revealed = std::min(revealed + std::min(delta_time, max_delta_time) * characters_per_second, float(characters));
+	}
+
+	// seconds until next character is revealed
+	float get_time_to_next_character(float characters_per_second) const
+	{
+		if (characters_per_second <= 0.0f)
+			return 0.0f;
+
+		return (std::floor(revealed) + 1.0f - revealed) / characters_per_second;
+	}
+
+	void reveal_all(int characters)
+	{
+		revealed = float(characters);
+	}
+
+	int get_revealed() const
+	{
+		return int(revealed);
+	}
+
+	float revealed = 0.0f;
+};
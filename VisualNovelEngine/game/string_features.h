@@ -1,32 +1,46 @@
 #pragma once
 #include <string>
-#include <codecvt>
 #include <vector>
 #include <sstream>
+#include <cwchar>
 
 #include <Windows.h>
 
+#include "main/text_encoding.h"
+
 std::wstring s2ws(const std::string& str)
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
+	std::wstring result;
+	decode_utf8(str.data(), str.size(), result);
 
-	return converterX.from_bytes(str);
+	return result;
 }
 
 std::string ws2s(const std::wstring& wstr)
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
+	std::string result;
+	encode_utf8(wstr.data(), wstr.size(), result);
+
+	return result;
+}
 
-	return converterX.to_bytes(wstr);
+// into string of caller, so buffer kept between frames doesnt reallocate
+void ws2s(const std::wstring& wstr, std::string& out)
+{
+	encode_utf8(wstr.data(), wstr.size(), out);
 }
 
+// result stays valid for next 3 calls on same thread, so few can be used in one expression
 const char* utf8(const wchar_t* pStr)
 {
-	static char szBuf[1024];
-	WideCharToMultiByte(CP_UTF8, 0, pStr, -1, szBuf, sizeof(szBuf), NULL, NULL);
-	return szBuf;
+	thread_local std::string buffers[4];
+	thread_local int next_buffer = 0;
+
+	std::string& buffer = buffers[next_buffer];
+	next_buffer = (next_buffer + 1) % 4;
+
+	encode_utf8(pStr, wcslen(pStr), buffer);
+	return buffer.c_str();
 }
 
 bool VectorOfStringGetter(void* data, int n, const char** out_text)
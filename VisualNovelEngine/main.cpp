@@ -46,11 +46,36 @@
 #include <fstream>
 #include <ostream>
 #include <codecvt>
+#include <chrono>
 
 // game includes
 #include "game/main/assets.h"
 #include "game/main/settings.h"
 #include "game/main/scenario.h"
+#include "game/main/scenario_parser.h"
+#include "game/main/scenario_binary.h"
+#include "game/main/texture_loader.h"
+#include "game/main/scenario_loader.h"
+#include "game/main/texture_residency.h"
+#include "game/main/texture_atlas.h"
+#include "game/main/render_stats.h"
+#include "game/main/scene_render_plan.h"
+#include "game/main/sprite_batcher.h"
+#include "game/main/text_run_cache.h"
+#include "game/main/typewriter.h"
+#include "game/main/idle_rendering.h"
+#include "game/main/frame_profiler.h"
+#include "game/main/trace.h"
+#include "game/main/allocation_counter.h"
+#include "game/main/frame_arena.h"
+#include "game/main/headless.h"
+#include "game/main/benchmarks.h"
+#include "game/main/self_tests.h"
+#include "game/main/software_rasterizer.h"
+#include "game/main/image_writer.h"
+#ifdef DCS_OPENGL
+#include "game/main/gl_renderer.h"
+#endif
 
 #include "game/main/combobox_data.h"
 #include "game/main/translation.h"
@@ -74,6 +99,11 @@ std::wstring game_renderer = L"OpenGL";
 std::wstring game_renderer = L"Direct3D 11";
 #endif
 
+#ifdef DCS_OPENGL
+// used when render mode is OpenGL 3.3, imgui-sfml draws otherwise
+GlRenderer_t gl_renderer;
+#endif
+
 #ifndef DCS_OPENGL
 static ID3D11Device* g_pd3dDevice = NULL;
 static ID3D11DeviceContext* g_pd3dDeviceContext = NULL;
@@ -133,6 +163,48 @@ GameMenuData_t game_menu_data;
 GameInfo_t game_info;
 
 std::vector<Scenario_t> scenarios;
+
+// returned for missing and not yet loaded textures, 1x1 transparent
+ScenarioTexture_t placeholder_texture;
+
+TextureLoader_t texture_loader;
+int texture_generation_counter = 0;
+
+ScenarioLoader_t scenario_loader;
+
+TextureResidency_t texture_residency;
+
+// disabled with -noatlas launch parameter, to compare draw calls with and without atlases
+bool texture_atlases_enabled = true;
+
+// -headless launch parameter, frames are built without window and GPU, see run_headless
+bool headless = false;
+
+// draws headless frames for screenshot command of headless script
+SoftwareRasterizer_t software_rasterizer;
+
+RenderStats_t render_stats;
+
+SceneRenderPlan_t scene_render_plan;
+
+// background, overlay and characters of scene, drawn to background draw list grouped by texture
+SceneSpriteBatcher_t scene_sprite_batcher;
+
+IdleRendering_t idle_rendering;
+
+// loader workers wake idle main loop when their results are ready
+void wake_idle_rendering()
+{
+	idle_rendering.wake();
+}
+
+FrameProfiler_t frame_profiler;
+
+// temporary strings and imgui labels, reset before imgui frame starts
+FrameArena_t frame_arena;
+
+TextRunCache_t text_run_cache;
+
 std::vector<std::wstring> saves;
 
 std::vector<std::string> save_names;
@@ -166,6 +238,11 @@ bool game_started = false;
 bool disable_input_on_scene = false;
 
 int current_scenario_scene = -1;
+
+// scenarios targeted by buttons of current scene, loaded in background while button menu is open
+std::vector<int> branch_scenarios;
+int branch_scenarios_owner = -1;
+int branch_scenarios_scene = -1;
 std::wstring main_character_name = L"";
 
 #ifdef DCS_STORY_GAME
@@ -194,10 +271,8 @@ bool recorded_dialogue = false;
 bool switched_scenario = false;
 std::wstring original_scenario_name = L"";
 
-std::wstring dialogue_text_to_render = L"";
-int dialogue_added_text_symbols = 0;
-
-float dialogue_text_animation_lerp = 0.0f;
+// reveal of dialogue text, its layout is in scene render plan
+Typewriter_t dialogue_typewriter;
 
 ImVec2 settings_render_position = ImVec2(FLT_MAX, FLT_MAX);
 
@@ -208,15 +283,18 @@ bool first_init = false;
 bool should_recreate_d3d_device_and_window = false;
 bool should_ignore_quit_message_after_window_recreation = false;
 
+// set by request_quit, main loop closes window once frame is presented
+bool quit_requested = false;
+
 std::string std_locale = "default";
 
-const char* LANG(const wchar_t* original = L"", const wchar_t* unused = L"")
+// translation of menu language, pointers stay valid until languages are reloaded
+const char* get_translation_utf8(const wchar_t* original, uint64_t hash)
 {
-	for (int i = 0; i < languages.at(game_settings.menu_language).strings.size(); i++)
-	{
-		if (languages.at(game_settings.menu_language).strings.at(i).original_text == original)
-			return utf8(languages.at(game_settings.menu_language).strings.at(i).translation_text.c_str());
-	}
+	const TranslatedText_t* string = languages.at(game_settings.menu_language).find(original, hash);
+
+	if (string)
+		return string->translation_utf8.c_str();
 
 	/*if (game_settings.menu_language == 0)
 		return utf8(english);
@@ -228,17 +306,20 @@ const char* LANG(const wchar_t* original = L"", const wchar_t* unused = L"")
 	return "";
 }
 
-const wchar_t* LANG_W(const wchar_t* original = L"", const wchar_t* unused = L"")
+const wchar_t* get_translation_text(const wchar_t* original, uint64_t hash)
 {
-	for (int i = 0; i < languages.at(game_settings.menu_language).strings.size(); i++)
-	{
-		if (languages.at(game_settings.menu_language).strings.at(i).original_text == original)
-			return languages.at(game_settings.menu_language).strings.at(i).translation_text.c_str();
-	}
+	const TranslatedText_t* string = languages.at(game_settings.menu_language).find(original, hash);
+
+	if (string)
+		return string->translation_text.c_str();
 
 	return L"";
 }
 
+// original text has to be literal, its hash is template argument so it is computed by compiler and not on every call
+#define LANG(original, unused) get_translation_utf8(original, std::integral_constant<uint64_t, get_translation_hash(original)>::value)
+#define LANG_W(original, unused) get_translation_text(original, std::integral_constant<uint64_t, get_translation_hash(original)>::value)
+
 float CalcHeightFromItemCount(int items_count)
 {
 	ImGuiContext& g = *GImGui;
@@ -247,14 +328,14 @@ float CalcHeightFromItemCount(int items_count)
 	return (g.FontSize + g.Style.ItemSpacing.y) * items_count - g.Style.ItemSpacing.y + (g.Style.WindowPadding.y * 2);
 }
 
-bool LanguageCombo(const char* label, int* current_item, std::vector<GameLanguage_t> items, int popup_max_height_in_items)
+bool LanguageCombo(const char* label, int* current_item, const std::vector<GameLanguage_t>& items, int popup_max_height_in_items)
 {
 	ImGuiContext& g = *GImGui;
 
 	// Call the getter to obtain the preview string which is a parameter to BeginCombo()
 	const char* preview_value = NULL;
 	if (*current_item >= 0 && *current_item < items.size())
-		preview_value = utf8(items.at(*current_item).name.c_str());
+		preview_value = items.at(*current_item).name_utf8.c_str();
 
 	// The old Combo() API exposed "popup_max_height_in_items". The new more general BeginCombo() API doesn't have/need it, but we emulate it here.
 	if (popup_max_height_in_items != -1 && !(g.NextWindowData.Flags & ImGuiNextWindowDataFlags_HasSizeConstraint))
@@ -272,7 +353,7 @@ bool LanguageCombo(const char* label, int* current_item, std::vector<GameLanguag
 
 		const bool item_selected = (i == *current_item);
 
-		if (ImGui::Selectable(utf8(items.at(i).name.c_str()), item_selected))
+		if (ImGui::Selectable(items.at(i).name_utf8.c_str(), item_selected))
 		{
 			value_changed = true;
 			*current_item = i;
@@ -316,6 +397,24 @@ std::wstring get_screenshot_name()
 	return game + L" " + current_date() + L" " + current_time() + L".png";
 }
 
+std::wstring get_profile_name()
+{
+	std::wstring game = game_info.game_name;
+	return game + L" " + current_date() + L" " + current_time() + L".csv";
+}
+
+std::wstring get_trace_name()
+{
+	std::wstring game = game_info.game_name;
+	return game + L" " + current_date() + L" " + current_time() + L".json";
+}
+
+std::wstring get_report_name()
+{
+	std::wstring game = game_info.game_name;
+	return game + L" " + current_date() + L" " + current_time() + L".txt";
+}
+
 DWORD WINAPI rpc_update_thread(PVOID r)
 {
 	int last_scenario = 0;
@@ -371,6 +470,8 @@ DWORD WINAPI rpc_update_thread(PVOID r)
 
 void read_game_fonts_from_file()
 {
+	TraceScope_t trace_scope("read_game_fonts_from_file");
+
 	wchar_t intro_font[260];
 	wchar_t intro_font_size[4];
 
@@ -457,6 +558,8 @@ void write_game_fonts_to_file(GameFonts_t i)
 
 void read_game_info_from_file()
 {
+	TraceScope_t trace_scope("read_game_info_from_file");
+
 	wchar_t game_name[260];
 	wchar_t game_developer[260];
 	wchar_t game_rpc_app_id[260];
@@ -500,6 +603,8 @@ void write_game_info_to_file(GameInfo_t i)
 
 void read_audio_settings_from_file()
 {
+	TraceScope_t trace_scope("read_audio_settings_from_file");
+
 	wchar_t music_volume[4];
 	wchar_t sound_volume[4];
 
@@ -526,11 +631,19 @@ void write_audio_settings_to_file(AudioSettings_t i)
 
 void write_video_settings_to_file(VideoSettings_t s)
 {
+	std::wstringstream version_;
 	std::wstringstream window_mode_;
 	std::wstringstream vsync_;
 	std::wstringstream render_mode_;
 	std::wstringstream texture_quality_;
 
+	std::wstringstream texture_memory_budget_;
+	std::wstringstream texture_prefetch_scenes_;
+
+	version_ << VIDEO_SETTINGS_VERSION;
+	WritePrivateProfileStringW(L"VideoSettings", L"version", version_.str().c_str(), L".\\game\\config\\video_settings.ini");
+	version_.clear();
+
 	window_mode_ << (int)s.screen_mode;
 	WritePrivateProfileStringW(L"VideoSettings", L"window_mode", window_mode_.str().c_str(), L".\\game\\config\\video_settings.ini");
 	window_mode_.clear();
@@ -546,19 +659,37 @@ void write_video_settings_to_file(VideoSettings_t s)
 	texture_quality_ << (int)s.texture_quality;
 	WritePrivateProfileStringW(L"VideoSettings", L"texture_quality", texture_quality_.str().c_str(), L".\\game\\config\\video_settings.ini");
 	texture_quality_.clear();
+
+	texture_memory_budget_ << (int)s.texture_memory_budget;
+	WritePrivateProfileStringW(L"VideoSettings", L"texture_memory_budget", texture_memory_budget_.str().c_str(), L".\\game\\config\\video_settings.ini");
+	texture_memory_budget_.clear();
+
+	texture_prefetch_scenes_ << (int)s.texture_prefetch_scenes;
+	WritePrivateProfileStringW(L"VideoSettings", L"texture_prefetch_scenes", texture_prefetch_scenes_.str().c_str(), L".\\game\\config\\video_settings.ini");
+	texture_prefetch_scenes_.clear();
 }
 
 void read_video_settings_from_file()
 {
+	TraceScope_t trace_scope("read_video_settings_from_file");
+
+	wchar_t version[4];
 	wchar_t window_mode[4];
 	wchar_t vsync[4];
 	wchar_t render_mode[4];
 	wchar_t texture_quality[4];
 
+	wchar_t texture_memory_budget[8];
+	wchar_t texture_prefetch_scenes[4];
+
+	GetPrivateProfileStringW(L"VideoSettings", L"version", L"0", version, 4, L".\\game\\config\\video_settings.ini");
 	GetPrivateProfileStringW(L"VideoSettings", L"window_mode", L"0", window_mode, 4, L".\\game\\config\\video_settings.ini");
 	GetPrivateProfileStringW(L"VideoSettings", L"vsync", L"1", vsync, 4, L".\\game\\config\\video_settings.ini");
 	GetPrivateProfileStringW(L"VideoSettings", L"render_mode", L"0", render_mode, 4, L".\\game\\config\\video_settings.ini");
-	GetPrivateProfileStringW(L"VideoSettings", L"texture_quality", L"0", texture_quality, 4, L".\\game\\config\\video_settings.ini");
+	GetPrivateProfileStringW(L"VideoSettings", L"texture_quality", L"1", texture_quality, 4, L".\\game\\config\\video_settings.ini");
+
+	GetPrivateProfileStringW(L"VideoSettings", L"texture_memory_budget", L"1024", texture_memory_budget, 8, L".\\game\\config\\video_settings.ini");
+	GetPrivateProfileStringW(L"VideoSettings", L"texture_prefetch_scenes", L"5", texture_prefetch_scenes, 4, L".\\game\\config\\video_settings.ini");
 
 	video_settings.screen_mode = _wtoi(window_mode);
 
@@ -566,6 +697,13 @@ void read_video_settings_from_file()
 
 	video_settings.render_mode = _wtoi(render_mode);
 	video_settings.texture_quality = _wtoi(texture_quality);
+
+	// files without version always had texture_quality=0 written, textures were loaded in full resolution then
+	if (_wtoi(version) < 1)
+		video_settings.texture_quality = 1;
+
+	video_settings.texture_memory_budget = _wtoi(texture_memory_budget);
+	video_settings.texture_prefetch_scenes = _wtoi(texture_prefetch_scenes);
 }
 
 void write_game_settings_to_file(GameSettings_t s)
@@ -578,6 +716,8 @@ void write_game_settings_to_file(GameSettings_t s)
 
 	std::wstringstream menu_language_;
 
+	std::wstringstream idle_rendering_;
+
 	autosave_ << (int)s.auto_save;
 	WritePrivateProfileStringW(L"GameSettings", L"autosave", autosave_.str().c_str(), L".\\game\\config\\game_settings.ini");
 	autosave_.clear();
@@ -597,10 +737,16 @@ void write_game_settings_to_file(GameSettings_t s)
 	menu_language_ << (int)s.menu_language;
 	WritePrivateProfileStringW(L"GameSettings", L"menu_language", menu_language_.str().c_str(), L".\\game\\config\\game_settings.ini");
 	menu_language_.clear();
+
+	idle_rendering_ << (int)s.idle_rendering;
+	WritePrivateProfileStringW(L"GameSettings", L"idle_rendering", idle_rendering_.str().c_str(), L".\\game\\config\\game_settings.ini");
+	idle_rendering_.clear();
 }
 
 void read_game_settings_from_file()
 {
+	TraceScope_t trace_scope("read_game_settings_from_file");
+
 	wchar_t autosave[4];
 	wchar_t menu_language[4];
 
@@ -609,6 +755,8 @@ void read_game_settings_from_file()
 
 	wchar_t show_fps_counter[4];
 
+	wchar_t idle_rendering[4];
+
 	GetPrivateProfileStringW(L"GameSettings", L"autosave", L"1", autosave, 4, L".\\game\\config\\game_settings.ini");
 	GetPrivateProfileStringW(L"GameSettings", L"show_fps_counter", L"1", show_fps_counter, 4, L".\\game\\config\\game_settings.ini");
 
@@ -617,6 +765,8 @@ void read_game_settings_from_file()
 
 	GetPrivateProfileStringW(L"GameSettings", L"menu_language", L"0", menu_language, 4, L".\\game\\config\\game_settings.ini");
 
+	GetPrivateProfileStringW(L"GameSettings", L"idle_rendering", L"1", idle_rendering, 4, L".\\game\\config\\game_settings.ini");
+
 	game_settings.auto_save = (bool)_wtoi(autosave);
 	game_settings.show_fps_counter = (bool)_wtoi(show_fps_counter);
 
@@ -624,6 +774,8 @@ void read_game_settings_from_file()
 	game_settings.text_animation_speed = _wtoi(text_animation_speed);
 
 	game_settings.menu_language = _wtoi(menu_language);
+
+	game_settings.idle_rendering = (bool)_wtoi(idle_rendering);
 }
 
 void save_game(std::wstring save_name, GameSave_t save)
@@ -743,17 +895,27 @@ void load_translation(std::wstring filename)
 
 			string.original_text = splitted_str.at(0);
 			string.translation_text = splitted_str.at(1);
+			string.translation_utf8 = ws2s(string.translation_text);
 
 			language.strings.push_back(string);
 		}
 	}
 
 	if (language.name != L"INVALIDLANG" && language.codepage != L"INVALIDCODEPAGE" && language.strings.size() > 0)
+	{
+		language.name_utf8 = ws2s(language.name);
+		language.build_catalog();
+
 		languages.push_back(language);
+	}
 }
 
 void load_menu_fonts(ImGuiIO& io)
 {
+	TraceScope_t trace_scope("load_menu_fonts");
+
+	text_run_cache.clear();
+
 #ifdef DCS_OPENGL
 	//io.Fonts->ClearFonts();
 #endif
@@ -765,12 +927,19 @@ void load_menu_fonts(ImGuiIO& io)
 	game_fonts.dialogue_text_font.font_data = io.Fonts->AddFontFromFileTTF(utf8(std::wstring(L".\\game\\fonts\\" + game_fonts.dialogue_text_font.font_name).c_str()), game_fonts.dialogue_text_font.font_size, NULL, io.Fonts->GetGlyphRangesCyrillic());
 
 #ifdef DCS_OPENGL
-	ImGui::SFML::UpdateFontTexture();
+	// headless font atlas is built on CPU only, in run_headless
+	if (!headless)
+		ImGui::SFML::UpdateFontTexture();
 #endif
 }
 
 void load_menu_images(ImGuiIO& io)
 {
+	TraceScope_t trace_scope("load_menu_images");
+
+	if (headless)
+		return;
+
 #ifndef DCS_OPENGL
 	D3DX11CreateShaderResourceViewFromFileW(g_pd3dDevice, L".\\game\\images\\menu\\logo.png", nullptr, nullptr, &game_menu_data.game_logo.image_data, 0);
 	D3DX11CreateShaderResourceViewFromFileW(g_pd3dDevice, L".\\game\\images\\menu\\intro_logo.png", nullptr, nullptr, &game_menu_data.intro_logo.image_data, 0);
@@ -784,6 +953,8 @@ void load_menu_images(ImGuiIO& io)
 
 void load_language_files()
 {
+	TraceScope_t trace_scope("load_language_files");
+
 	WIN32_FIND_DATAW findData;
 	HANDLE hFind = INVALID_HANDLE_VALUE;
 
@@ -800,6 +971,8 @@ void load_language_files()
 
 void load_music_files()
 {
+	TraceScope_t trace_scope("load_music_files");
+
 	WIN32_FIND_DATAW findData;
 	HANDLE hFind = INVALID_HANDLE_VALUE;
 
@@ -814,7 +987,7 @@ void load_music_files()
 	FindClose(hFind);
 }
 
-int find_scenario_index(std::wstring scenario_name)
+int find_scenario_index(std::wstring_view scenario_name)
 {
 	for (int i = 0; i < scenarios.size(); i++)
 	{
@@ -825,63 +998,186 @@ int find_scenario_index(std::wstring scenario_name)
 	return -1;
 }
 
-#ifndef DCS_OPENGL
-ID3D11ShaderResourceView* find_texture(std::wstring texture_name, Scenario_t& scenario)
-#else
-void* find_texture(std::wstring texture_name, Scenario_t& scenario)
-#endif
+// scenario that owns textures used by given scenario
+Scenario_t& get_texture_scenario(Scenario_t& scenario)
 {
 #ifdef DCS_STORY_GAME
-	for (int i = 0; i < scenarios.at(find_scenario_index(L"main.sc")).textures.size(); i++)
-	{
-		if (scenarios.at(find_scenario_index(L"main.sc")).textures.at(i).texture_name == texture_name)
-		{
-#ifndef DCS_OPENGL
-			return scenarios.at(find_scenario_index(L"main.sc")).textures.at(i).texture_data;
-#else
-			return convertGLtoImTexture(scenarios.at(find_scenario_index(L"main.sc")).textures.at(i).texture_data.getNativeHandle());
+	static int main_scenario_idx = -1;
+
+	if (main_scenario_idx < 0 || main_scenario_idx >= scenarios.size() || scenarios.at(main_scenario_idx).file_name != L"main.sc")
+		main_scenario_idx = find_scenario_index(L"main.sc");
+
+	if (main_scenario_idx != -1)
+		return scenarios.at(main_scenario_idx);
 #endif
-		}
-	}
-#else
+
+	return scenario;
+}
+
+int get_scenario_index(Scenario_t& scenario)
+{
+	return int(&scenario - scenarios.data());
+}
+
+int get_texture_scenario_index(int scenario_idx)
+{
+	if (scenario_idx < 0 || scenario_idx >= scenarios.size())
+		return scenario_idx;
+
+	return get_scenario_index(get_texture_scenario(scenarios.at(scenario_idx)));
+}
+
+void request_texture(int scenario_idx, TextureHandle_t handle, bool urgent)
+{
+	Scenario_t& scenario = scenarios.at(scenario_idx);
+
+	if (handle < 0 || handle >= scenario.textures.size())
+		return;
+
+	ScenarioTexture_t& texture = scenario.textures.at(handle);
+
+	if (texture.ready || texture.loading || texture.failed)
+		return;
+
+	TextureLoadJob_t job;
+
+	job.scenario_idx = scenario_idx;
+	job.texture_idx = handle;
+	job.generation = scenario.texture_generation;
+	job.path = texture.texture_path;
+	job.downscale = get_texture_downscale(video_settings.texture_quality);
+	job.trim = texture.character_texture;
+
+	for (int i = 0; i < texture.layers.size(); i++)
+		job.layers.push_back(scenario.textures.at(texture.layers.at(i)).texture_path);
+
+	texture_loader.queue(job, urgent);
+	texture.loading = true;
+
+	if (!urgent)
+		texture_residency.prefetches++;
+}
+
+// drops queued loads of scenario textures, they can be requested again later
+void cancel_texture_loads(int scenario_idx)
+{
+	texture_loader.cancel(scenario_idx);
+
+	Scenario_t& scenario = scenarios.at(scenario_idx);
+
 	for (int i = 0; i < scenario.textures.size(); i++)
+		scenario.textures.at(i).loading = false;
+}
+
+// drops loads of branches which were not chosen, chosen_scenario_idx is -1 if no branch was chosen
+void cancel_branch_prefetch(int chosen_scenario_idx)
+{
+	for (int i = 0; i < branch_scenarios.size(); i++)
 	{
-		if (scenario.textures.at(i).texture_name == texture_name)
-		{
-#ifndef DCS_OPENGL
-			return scenario.textures.at(i).texture_data;
-#else
-			return convertGLtoImTexture(scenario.textures.at(i).texture_data.getNativeHandle());
-#endif
-		}
+		int texture_scenario_idx = get_texture_scenario_index(branch_scenarios.at(i));
+
+		if (texture_scenario_idx == get_texture_scenario_index(selected_scenario))
+			continue;
+
+		if (chosen_scenario_idx != -1 && texture_scenario_idx == get_texture_scenario_index(chosen_scenario_idx))
+			continue;
+
+		cancel_texture_loads(texture_scenario_idx);
 	}
-#endif
 
-	return NULL;
+	branch_scenarios.clear();
+
+	branch_scenarios_owner = -1;
+	branch_scenarios_scene = -1;
 }
 
-#ifdef DCS_OPENGL
-sf::Texture& find_texture_sf(std::wstring texture_name, Scenario_t& scenario)
+ScenarioTexture_t& get_texture(TextureHandle_t handle, Scenario_t& scenario)
 {
-#ifdef DCS_STORY_GAME
-	for (int i = 0; i < scenarios.at(find_scenario_index(L"main.sc")).textures.size(); i++)
+	Scenario_t& texture_scenario = get_texture_scenario(scenario);
+
+	if (handle < 0 || handle >= texture_scenario.textures.size())
+		return placeholder_texture;
+
+	ScenarioTexture_t& texture = texture_scenario.textures.at(handle);
+	texture_residency.touch(texture);
+
+	if (!texture.ready)
 	{
-		if (scenarios.at(find_scenario_index(L"main.sc")).textures.at(i).texture_name == texture_name)
-			return scenarios.at(find_scenario_index(L"main.sc")).textures.at(i).texture_data;
+		request_texture(get_scenario_index(texture_scenario), handle, true);
+		return placeholder_texture;
 	}
+
+	return texture;
+}
+
+bool is_texture_ready(TextureHandle_t handle, Scenario_t& scenario)
+{
+	Scenario_t& texture_scenario = get_texture_scenario(scenario);
+
+	if (handle < 0 || handle >= texture_scenario.textures.size())
+		return false;
+
+	return texture_scenario.textures.at(handle).ready;
+}
+
+bool is_texture_failed(TextureHandle_t handle, Scenario_t& scenario)
+{
+	Scenario_t& texture_scenario = get_texture_scenario(scenario);
+
+	if (handle < 0 || handle >= texture_scenario.textures.size())
+		return false;
+
+	return texture_scenario.textures.at(handle).failed;
+}
+
+// texture of atlas page for atlas sprites
+ImTextureID get_texture_id(ScenarioTexture_t& texture)
+{
+	// there are no GPU textures, addresses keep textures apart so draw commands are merged as with real ones
+	if (headless)
+		return texture.atlas_page ? (ImTextureID)texture.atlas_page : (ImTextureID)&texture;
+
+#ifndef DCS_OPENGL
+	if (texture.atlas_page)
+		return texture.atlas_page->texture_data;
+
+	return texture.texture_data;
 #else
-	for (int i = 0; i < scenario.textures.size(); i++)
+	if (texture.atlas_page)
+		return convertGLtoImTexture(texture.atlas_page->texture_data.getNativeHandle());
+
+	return convertGLtoImTexture(texture.texture_data.getNativeHandle());
+#endif
+}
+
+void add_scene_image(TextureHandle_t handle, Scenario_t& scenario, const ImVec2& p_min, const ImVec2& p_max)
+{
+	FrameProfilerScope_t profiler_scope(frame_profiler, FRAME_PHASE_TEXTURE_LOOKUP);
+
+	ScenarioTexture_t& texture = get_texture(handle, scenario);
+
+	// trimmed textures are drawn smaller, in place of their transparent full image
+	ImVec2 size = ImVec2(p_max.x - p_min.x, p_max.y - p_min.y);
+
+	ImVec2 trim_min = ImVec2(p_min.x + size.x * texture.trim_min[0], p_min.y + size.y * texture.trim_min[1]);
+	ImVec2 trim_max = ImVec2(p_min.x + size.x * texture.trim_max[0], p_min.y + size.y * texture.trim_max[1]);
+
+	scene_sprite_batcher.add(get_texture_id(texture), trim_min, trim_max, ImVec2(texture.uv_min[0], texture.uv_min[1]), ImVec2(texture.uv_max[0], texture.uv_max[1]));
+}
+
+void add_scene_quad(const SceneRenderQuad_t& quad, Scenario_t& scenario)
+{
+	if (quad.parts_count == 0 || (quad.handle != INVALID_TEXTURE_HANDLE && !is_texture_failed(quad.handle, scenario)))
 	{
-		if (scenario.textures.at(i).texture_name == texture_name)
-			return scenario.textures.at(i).texture_data;
+		add_scene_image(quad.handle, scenario, quad.p_min, quad.p_max);
+		return;
 	}
-#endif
 
-	return sf::Texture();
+	for (int i = 0; i < quad.parts_count; i++)
+		add_scene_image(quad.parts[i], scenario, quad.p_min, quad.p_max);
 }
-#endif
 
-MusicData_t find_music(std::wstring music_name)
+MusicData_t find_music(std::wstring_view music_name)
 {
 	for (int i = 0; i < music.size(); i++)
 	{
@@ -892,8 +1188,10 @@ MusicData_t find_music(std::wstring music_name)
 	return MusicData_t();
 }
 
-void stream_music(std::wstring name, HSTREAM& stream)
+void stream_music(std::wstring_view name, HSTREAM& stream)
 {
+	FrameProfilerScope_t profiler_scope(frame_profiler, FRAME_PHASE_AUDIO);
+
 	MusicData_t music = find_music(name);
 
 	if (music.is_valid_music())
@@ -933,14 +1231,12 @@ void exit_to_main_menu(bool scenario_switch)
 		dialogue_history.clear();
 	}
 
-	dialogue_text_to_render = L"";
-	dialogue_added_text_symbols = 0;
-
-	dialogue_text_animation_lerp = 0.0f;
+	dialogue_typewriter.restart();
 
 	recorded_dialogue = false;
 }
 
+// only texture names and paths are known after this returns, textures are decoded in background once some scene needs them
 std::vector<ScenarioTexture_t> load_textures(std::wstring directory)
 {
 	WIN32_FIND_DATAW findData;
@@ -960,13 +1256,7 @@ std::vector<ScenarioTexture_t> load_textures(std::wstring directory)
 			ScenarioTexture_t texture;
 
 			texture.texture_name = get_filename_without_ext(std::wstring(findData.cFileName));
-			
-#ifndef DCS_OPENGL
-			D3DX11CreateShaderResourceViewFromFileW(g_pd3dDevice, std::wstring(full_path + std::wstring(findData.cFileName)).c_str(), nullptr, nullptr, &texture.texture_data, 0);
-#else
-			texture.texture_data.loadFromFile(ws2s(std::wstring(full_path + std::wstring(findData.cFileName))));
-			//texture.texture_data.setSmooth(true);
-#endif
+			texture.texture_path = full_path + std::wstring(findData.cFileName);
 
 			texture_list.push_back(texture);
 		}
@@ -977,494 +1267,1019 @@ std::vector<ScenarioTexture_t> load_textures(std::wstring directory)
 	return texture_list;
 }
 
-std::vector<ScenarioDialogueScene_t> load_scenes(std::wstring path)
+void set_texture_image_size(ScenarioTexture_t& texture, TextureImage_t& image)
 {
-	std::wifstream scene_file(path.c_str());
-	scene_file.imbue(std::locale(std_locale));
+	texture.width = image.source_width;
+	texture.height = image.source_height;
 
-	std::vector<std::wstring> lines;
+	texture.trim_min[0] = float(image.trim_x) / image.full_width;
+	texture.trim_min[1] = float(image.trim_y) / image.full_height;
+	texture.trim_max[0] = float(image.trim_x + image.width) / image.full_width;
+	texture.trim_max[1] = float(image.trim_y + image.height) / image.full_height;
+}
+
+void upload_texture(ScenarioTexture_t& texture, TextureImage_t& image)
+{
+	set_texture_image_size(texture, image);
 
-	if (scene_file.is_open())
+	if (headless)
 	{
-		std::wstring line;
+		if (software_rasterizer.enabled)
+			software_rasterizer.set_texture(get_texture_id(texture), image.width, image.height, image.data());
 
-		while (std::getline(scene_file, line))
-			lines.push_back(line);
+		texture.ready = true;
+		texture.memory_size = image.memory_size();
+		texture_residency.resident_bytes += texture.memory_size;
 
-		scene_file.close();
+		return;
 	}
 
-	std::vector<ScenarioDialogueScene_t> scenes;
+#ifndef DCS_OPENGL
+	D3D11_TEXTURE2D_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Width = image.width;
+	desc.Height = image.height;
+	desc.MipLevels = 0;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	ID3D11Texture2D* texture_2d = nullptr;
+
+	if (FAILED(g_pd3dDevice->CreateTexture2D(&desc, nullptr, &texture_2d)))
+		return;
 
-	bool found_scene_start = false;
-	bool found_scene_end = false;
+	g_pd3dDeviceContext->UpdateSubresource(texture_2d, 0, nullptr, image.data(), image.width * 4, 0);
 
-	int line_number = -1;
-	int line_param_read_stage = -1;
+	if (SUCCEEDED(g_pd3dDevice->CreateShaderResourceView(texture_2d, nullptr, &texture.texture_data)))
+		g_pd3dDeviceContext->GenerateMips(texture.texture_data);
 
-	ScenarioDialogueScene_t scene;
+	texture_2d->Release();
 
-	if (wcsstr(GetCommandLineW(), L"-skid1337"))
-	{
-		scene.button1.button_name = L"NONE";
-		scene.button2.button_name = L"NONE";
-		scene.button3.button_name = L"NONE";
-		scene.button4.button_name = L"NONE";
+	texture.ready = texture.texture_data != nullptr;
 
-		scene.background_overlay_texture = L"NONE";
-		scene.overlay_texture = L"NONE";
+	// with full mip chain
+	texture.memory_size = image.memory_size() * 4 / 3;
+#else
+	if (!texture.texture_data.create(image.width, image.height))
+		return;
 
-		scene.person1.talking = false;
-		scene.person1.person_name = L"NONE";
-		scene.person1.person_texture = L"NONE";
-		scene.person1.person_texture_left = L"NONE";
-		scene.person1.person_texture_right = L"NONE";
-		scene.person1.person_texture_head = L"NONE";
+	texture.texture_data.update(image.data());
+	//texture.texture_data.setSmooth(true);
 
-		scene.person2.talking = false;
-		scene.person2.person_name = L"NONE";
-		scene.person2.person_texture = L"NONE";
-		scene.person2.person_texture_left = L"NONE";
-		scene.person2.person_texture_right = L"NONE";
-		scene.person2.person_texture_head = L"NONE";
+	texture.ready = true;
+	texture.memory_size = image.memory_size();
+#endif
 
-		scene.person3.talking = false;
-		scene.person3.person_name = L"NONE";
-		scene.person3.person_texture = L"NONE";
-		scene.person3.person_texture_left = L"NONE";
-		scene.person3.person_texture_right = L"NONE";
-		scene.person3.person_texture_head = L"NONE";
+	if (texture.ready)
+		texture_residency.resident_bytes += texture.memory_size;
+}
 
-		scene.person4.talking = false;
-		scene.person4.person_name = L"NONE";
-		scene.person4.person_texture = L"NONE";
-		scene.person4.person_texture_left = L"NONE";
-		scene.person4.person_texture_right = L"NONE";
-		scene.person4.person_texture_head = L"NONE";
+size_t get_atlas_page_memory_size()
+{
+	return size_t(TEXTURE_ATLAS_SIZE) * TEXTURE_ATLAS_SIZE * 4;
+}
 
-		scene.person1.person_name = L"Komok050505";
+bool create_atlas_page(TextureAtlasPage_t& page)
+{
+	if (headless)
+	{
+		if (software_rasterizer.enabled)
+			software_rasterizer.set_texture((ImTextureID)&page, TEXTURE_ATLAS_SIZE, TEXTURE_ATLAS_SIZE, nullptr);
 
-		scene.person1.talking = true;
-		scene.person1.talking_text = L"Hello skid1337!";
+		page.created = true;
+		texture_residency.resident_bytes += get_atlas_page_memory_size();
 
-		scenes.push_back(scene);
+		return true;
+	}
 
-		scene = ScenarioDialogueScene_t();
+#ifndef DCS_OPENGL
+	D3D11_TEXTURE2D_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Width = TEXTURE_ATLAS_SIZE;
+	desc.Height = TEXTURE_ATLAS_SIZE;
+	// sampler of imgui_impl_dx11 reads only first level, padding of sprites wouldnt stop smaller levels from bleeding
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	// render target only to be cleared
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+
+	if (FAILED(g_pd3dDevice->CreateTexture2D(&desc, nullptr, &page.texture)))
+		return false;
 
-		scene.button1.button_name = L"NONE";
-		scene.button2.button_name = L"NONE";
-		scene.button3.button_name = L"NONE";
-		scene.button4.button_name = L"NONE";
+	if (FAILED(g_pd3dDevice->CreateShaderResourceView(page.texture, nullptr, &page.texture_data)))
+	{
+		page.texture->Release();
+		page.texture = nullptr;
 
-		scene.background_overlay_texture = L"NONE";
-		scene.overlay_texture = L"NONE";
+		return false;
+	}
 
-		scene.person1.talking = false;
-		scene.person1.person_name = L"NONE";
-		scene.person1.person_texture = L"NONE";
-		scene.person1.person_texture_left = L"NONE";
-		scene.person1.person_texture_right = L"NONE";
-		scene.person1.person_texture_head = L"NONE";
+	// contents of new texture are undefined
+	ID3D11RenderTargetView* target = nullptr;
 
-		scene.person2.talking = false;
-		scene.person2.person_name = L"NONE";
-		scene.person2.person_texture = L"NONE";
-		scene.person2.person_texture_left = L"NONE";
-		scene.person2.person_texture_right = L"NONE";
-		scene.person2.person_texture_head = L"NONE";
-
-		scene.person3.talking = false;
-		scene.person3.person_name = L"NONE";
-		scene.person3.person_texture = L"NONE";
-		scene.person3.person_texture_left = L"NONE";
-		scene.person3.person_texture_right = L"NONE";
-		scene.person3.person_texture_head = L"NONE";
-
-		scene.person4.talking = false;
-		scene.person4.person_name = L"NONE";
-		scene.person4.person_texture = L"NONE";
-		scene.person4.person_texture_left = L"NONE";
-		scene.person4.person_texture_right = L"NONE";
-		scene.person4.person_texture_head = L"NONE";
+	if (SUCCEEDED(g_pd3dDevice->CreateRenderTargetView(page.texture, nullptr, &target)))
+	{
+		const float transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
-		scene.person1.person_name = L"Komok050505";
+		g_pd3dDeviceContext->ClearRenderTargetView(target, transparent);
+		target->Release();
+	}
+#else
+	if (!page.texture_data.create(TEXTURE_ATLAS_SIZE, TEXTURE_ATLAS_SIZE))
+		return false;
 
-		scene.person1.talking = true;
-		scene.person1.talking_text = L"Welcome to " + game_info.game_name + L"!";
+	std::vector<uint8_t> transparent(size_t(TEXTURE_ATLAS_SIZE) * TEXTURE_ATLAS_SIZE * 4, 0);
+	page.texture_data.update(transparent.data());
+#endif
 
-		scenes.push_back(scene);
+	page.created = true;
+	texture_residency.resident_bytes += get_atlas_page_memory_size();
 
-		scene = ScenarioDialogueScene_t();
-	}
+	return true;
+}
 
-	for (int i = 0; i < lines.size(); i++)
+void release_atlas_page(TextureAtlas_t& atlas, TextureAtlasPage_t& page)
+{
+	if (page.created)
 	{
-		std::wstring line = lines.at(i);
-
-		if (line == L"[scene_start]")
+		if (!headless)
 		{
-			found_scene_start = true;
-			continue;
-		}
+#ifndef DCS_OPENGL
+			page.texture_data->Release();
+			page.texture_data = nullptr;
 
-		if (line == L"[scene_end]")
+			page.texture->Release();
+			page.texture = nullptr;
+#else
+			page.texture_data = sf::Texture();
+#endif
+		}
+		else
 		{
-			found_scene_end = true;
-			scenes.push_back(scene);
-
-			int erased_lines = 0;
-			int remaining_lines = i;
-
-			while (erased_lines != i && remaining_lines != 0)
-			{
-				lines.erase(lines.begin());
-
-				erased_lines++;
-				remaining_lines--;
-			}
-
-			i = 0;
-
-			found_scene_start = false;
-			found_scene_end = false;
-
-			line_number = -1;
-			line_param_read_stage = -1;
+			software_rasterizer.remove_texture((ImTextureID)&page);
+		}
 
-			scene = ScenarioDialogueScene_t();
+		texture_residency.resident_bytes -= get_atlas_page_memory_size();
+	}
 
-			continue;
-		}
+	page.created = false;
 
-		if (!found_scene_end && found_scene_start)
-		{
-			line_param_read_stage++;
+	atlas.reset(page);
+}
 
-			std::vector<std::wstring> splitted_str = split_string(line, L':');
+// false if sprite doesnt fit into atlas page, it has to be uploaded as separate texture then
+bool upload_atlas_sprite(TextureAtlas_t& atlas, ScenarioTexture_t& texture, TextureImage_t& image)
+{
+	int page_idx;
+	int x;
+	int y;
 
-			if (splitted_str.size() >= 3 && line_param_read_stage == 0)
-			{
-				scene.button1.button_name = L"NONE";
-				scene.button2.button_name = L"NONE";
-				scene.button3.button_name = L"NONE";
-				scene.button4.button_name = L"NONE";
+	if (!atlas.allocate(image.width, image.height, page_idx, x, y))
+		return false;
 
-				scene.background_overlay_texture = L"NONE";
-				scene.overlay_texture = L"NONE";
+	TextureAtlasPage_t& page = atlas.pages.at(page_idx);
 
-				scene.person1.person_texture_left = L"NONE";
-				scene.person1.person_texture_right = L"NONE";
-				scene.person1.person_texture_head = L"NONE";
+	if (!page.created && !create_atlas_page(page))
+	{
+		release_atlas_page(atlas, page);
+		return false;
+	}
 
-				scene.person2.person_texture_left = L"NONE";
-				scene.person2.person_texture_right = L"NONE";
-				scene.person2.person_texture_head = L"NONE";
+	// there is no page texture without GPU, only place of sprite matters unless frames are rasterized
+	if (!headless || software_rasterizer.enabled)
+	{
+		int padded_width = image.width + TEXTURE_ATLAS_PADDING * 2;
+		int padded_height = image.height + TEXTURE_ATLAS_PADDING * 2;
 
-				scene.person3.person_texture_left = L"NONE";
-				scene.person3.person_texture_right = L"NONE";
-				scene.person3.person_texture_head = L"NONE";
+		std::vector<uint8_t> padded(size_t(padded_width) * padded_height * 4, 0);
 
-				scene.person4.person_texture_left = L"NONE";
-				scene.person4.person_texture_right = L"NONE";
-				scene.person4.person_texture_head = L"NONE";
+		for (unsigned row = 0; row < image.height; row++)
+			memcpy(padded.data() + ((size_t(row) + TEXTURE_ATLAS_PADDING) * padded_width + TEXTURE_ATLAS_PADDING) * 4, image.data() + size_t(row) * image.width * 4, size_t(image.width) * 4);
 
-				if (advanced_scenes && splitted_str.size() > 3)
-				{
-					scene.background_texture = splitted_str.at(0);
-					scene.background_overlay_texture = splitted_str.at(1);
+		if (headless)
+		{
+			software_rasterizer.update_texture((ImTextureID)&page, x, y, padded_width, padded_height, padded.data());
+		}
+		else
+		{
+#ifndef DCS_OPENGL
+			D3D11_BOX box;
+			box.left = x;
+			box.top = y;
+			box.front = 0;
+			box.right = x + padded_width;
+			box.bottom = y + padded_height;
+			box.back = 1;
+
+			g_pd3dDeviceContext->UpdateSubresource(page.texture, 0, &box, padded.data(), padded_width * 4, 0);
+#else
+			page.texture_data.update(padded.data(), padded_width, padded_height, x, y);
+#endif
+		}
+	}
 
-					scene.background_music = splitted_str.at(2);
-					scene.additional_scene_sound = splitted_str.at(3);
-				}
-				else
-				{
-					scene.background_texture = splitted_str.at(0);
-					scene.background_music = splitted_str.at(1);
-					scene.additional_scene_sound = splitted_str.at(2);
-				}
-			}
-			else if (splitted_str.size() >= 3 && line_param_read_stage == 1)
-			{
-				scene.person1.person_name = splitted_str.at(0);
-				scene.person1.person_texture = splitted_str.at(1);
+	texture.atlas_page = &page;
 
-				scene.person1.talking_text = splitted_str.at(2);
+	texture.uv_min[0] = float(x + TEXTURE_ATLAS_PADDING) / TEXTURE_ATLAS_SIZE;
+	texture.uv_min[1] = float(y + TEXTURE_ATLAS_PADDING) / TEXTURE_ATLAS_SIZE;
+	texture.uv_max[0] = float(x + TEXTURE_ATLAS_PADDING + image.width) / TEXTURE_ATLAS_SIZE;
+	texture.uv_max[1] = float(y + TEXTURE_ATLAS_PADDING + image.height) / TEXTURE_ATLAS_SIZE;
 
-				if (advanced_scenes && splitted_str.size() > 5)
-				{
-					scene.person1.person_texture_left = splitted_str.at(3);
-					scene.person1.person_texture_right = splitted_str.at(4);
-					scene.person1.person_texture_head = splitted_str.at(5);
-				}
+	set_texture_image_size(texture, image);
 
-				if (scene.person1.talking_text == L"NONE")
-					scene.person1.talking = false;
-				else
-					scene.person1.talking = true;
-			}
-			else if (splitted_str.size() >= 3 && line_param_read_stage == 2)
-			{
-				scene.person2.person_name = splitted_str.at(0);
-				scene.person2.person_texture = splitted_str.at(1);
+	// memory is accounted for whole page
+	texture.memory_size = 0;
+	texture.ready = true;
 
-				scene.person2.talking_text = splitted_str.at(2);
+	return true;
+}
 
-				if (advanced_scenes && splitted_str.size() > 5)
-				{
-					scene.person2.person_texture_left = splitted_str.at(3);
-					scene.person2.person_texture_right = splitted_str.at(4);
-					scene.person2.person_texture_head = splitted_str.at(5);
-				}
+void unload_atlas_sprite(TextureAtlas_t& atlas, ScenarioTexture_t& texture)
+{
+	TextureAtlasPage_t& page = *texture.atlas_page;
 
-				if (scene.person2.talking_text == L"NONE")
-					scene.person2.talking = false;
-				else
-					scene.person2.talking = true;
-			}
-			else if (splitted_str.size() >= 3 && line_param_read_stage == 3)
-			{
-				scene.person3.person_name = splitted_str.at(0);
-				scene.person3.person_texture = splitted_str.at(1);
+	page.sprites--;
 
-				scene.person3.talking_text = splitted_str.at(2);
+	// space of single sprite cant be reused, page is packed again once all of its sprites are gone
+	if (page.sprites <= 0)
+		release_atlas_page(atlas, page);
 
-				if (advanced_scenes && splitted_str.size() > 5)
-				{
-					scene.person3.person_texture_left = splitted_str.at(3);
-					scene.person3.person_texture_right = splitted_str.at(4);
-					scene.person3.person_texture_head = splitted_str.at(5);
-				}
+	texture.atlas_page = nullptr;
 
-				if (scene.person3.talking_text == L"NONE")
-					scene.person3.talking = false;
-				else
-					scene.person3.talking = true;
-			}
-			else if (splitted_str.size() >= 3 && line_param_read_stage == 4)
-			{
-				scene.person4.person_name = splitted_str.at(0);
-				scene.person4.person_texture = splitted_str.at(1);
+	texture.uv_min[0] = 0.0f;
+	texture.uv_min[1] = 0.0f;
+	texture.uv_max[0] = 1.0f;
+	texture.uv_max[1] = 1.0f;
 
-				scene.person4.talking_text = splitted_str.at(2);
+	texture.ready = false;
+}
 
-				if (advanced_scenes && splitted_str.size() > 5)
-				{
-					scene.person4.person_texture_left = splitted_str.at(3);
-					scene.person4.person_texture_right = splitted_str.at(4);
-					scene.person4.person_texture_head = splitted_str.at(5);
-				}
+void unload_texture(Scenario_t& scenario, ScenarioTexture_t& texture)
+{
+	if (!texture.ready)
+		return;
 
-				if (scene.person4.talking_text == L"NONE")
-					scene.person4.talking = false;
-				else
-					scene.person4.talking = true;
-			}
-			else if (splitted_str.size() == 1 && line_param_read_stage == 5)
-			{
-				scene.main_character.talking_text = splitted_str.at(0);
+	if (texture.atlas_page)
+	{
+		unload_atlas_sprite(scenario.texture_atlas, texture);
+		return;
+	}
 
-				if (scene.main_character.talking_text == L"NONE")
-					scene.main_character.talking = false;
-				else
-					scene.main_character.talking = true;
-			}
-			else if (splitted_str.size() == 2 && line_param_read_stage == 6)
-			{
-				scene.button1.button_name = splitted_str.at(0);
-				scene.button1.button_scenario_to_load = splitted_str.at(1);
-			}
-			else if (splitted_str.size() == 2 && line_param_read_stage == 7)
-			{
-				scene.button2.button_name = splitted_str.at(0);
-				scene.button2.button_scenario_to_load = splitted_str.at(1);
-			}
-			else if (splitted_str.size() == 2 && line_param_read_stage == 8)
-			{
-				scene.button3.button_name = splitted_str.at(0);
-				scene.button3.button_scenario_to_load = splitted_str.at(1);
-			}
-			else if (splitted_str.size() == 2 && line_param_read_stage == 9)
-			{
-				scene.button4.button_name = splitted_str.at(0);
-				scene.button4.button_scenario_to_load = splitted_str.at(1);
-			}
-			else if (splitted_str.size() == 1 && line_param_read_stage == 10 && advanced_scenes)
-			{
-				scene.overlay_texture = splitted_str.at(0);
-			}
-		}
+	if (!headless)
+	{
+#ifndef DCS_OPENGL
+		texture.texture_data->Release();
+		texture.texture_data = nullptr;
+#else
+		texture.texture_data = sf::Texture();
+#endif
+	}
+	else
+	{
+		software_rasterizer.remove_texture(get_texture_id(texture));
 	}
 
-	return scenes;
+	texture_residency.resident_bytes -= texture.memory_size;
+
+	texture.memory_size = 0;
+	texture.ready = false;
 }
 
-void create_new_scenario(std::wstring name)
+void evict_textures()
 {
-	if (exists(L".\\game\\scenarios\\" + name + L".sc"))
+	if (!texture_residency.is_over_budget())
+	{
+		texture_residency.unblock_eviction();
 		return;
+	}
 
-	std::wofstream new_scenario(L".\\game\\scenarios\\" + name + L".sc");
-	new_scenario.imbue(std::locale(std_locale));
-
-	new_scenario << L"[scene_start]" << std::endl;
+	// budget is below textures of upcoming scenes, they stay over it until resident or kept textures change
+	if (!texture_residency.can_evict())
+		return;
 
-	if (advanced_scenes)
-		new_scenario << L"NONE:NONE:NONE:NONE" << std::endl;
-	else
-		new_scenario << L"NONE:NONE:NONE" << std::endl;
+	std::vector<TextureEvictionCandidate_t>& candidates = texture_residency.collect_eviction_candidates(scenarios);
 
-	if (advanced_scenes)
-	{
-		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
-		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
-		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
-		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
-	}
-	else
+	for (int i = 0; i < candidates.size() && texture_residency.is_over_budget(); i++)
 	{
-		new_scenario << L"NONE:NONE:NONE" << std::endl;
-		new_scenario << L"NONE:NONE:NONE" << std::endl;
-		new_scenario << L"NONE:NONE:NONE" << std::endl;
-		new_scenario << L"NONE:NONE:NONE" << std::endl;
-	}
+		TextureEvictionCandidate_t& candidate = candidates.at(i);
 
-	new_scenario << L"NONE" << std::endl;
+		if (candidate.texture)
+		{
+			unload_texture(*candidate.scenario, *candidate.texture);
+			texture_residency.evictions++;
 
-	new_scenario << L"NONE:NONE" << std::endl;
-	new_scenario << L"NONE:NONE" << std::endl;
-	new_scenario << L"NONE:NONE" << std::endl;
-	new_scenario << L"NONE:NONE" << std::endl;
+			continue;
+		}
 
-	if (advanced_scenes)
-		new_scenario << L"NONE" << std::endl;
+		// last sprite releases page
+		for (int c = 0; c < candidate.scenario->textures.size(); c++)
+		{
+			ScenarioTexture_t& texture = candidate.scenario->textures.at(c);
 
-	new_scenario << L"[scene_end]" << std::endl;
+			if (texture.ready && texture.atlas_page == candidate.page)
+			{
+				unload_texture(*candidate.scenario, texture);
+				texture_residency.evictions++;
+			}
+		}
+	}
 
-	new_scenario.close();
+	if (texture_residency.is_over_budget())
+		texture_residency.block_eviction();
+	else
+		texture_residency.unblock_eviction();
 }
 
-void save_scenario_data(Scenario_t& scenario)
+// requests textures of current and next scenes, then evicts unused textures if memory budget is exceeded
+void update_texture_residency()
 {
-	std::wofstream scenario_file(scenario.file_path);
-	scenario_file.imbue(std::locale(std_locale));
+	texture_residency.begin_frame();
 
-	for (int i = 0; i < scenario.scenes.size(); i++)
+	if (game_started && selected_scenario != -1 && scenarios.at(selected_scenario).loaded)
 	{
-		ScenarioDialogueScene_t& scene = scenario.scenes.at(i);
+		Scenario_t& scenario = scenarios.at(selected_scenario);
 
-		scenario_file << L"[scene_start]" << std::endl;
+		int texture_scenario_idx = get_texture_scenario_index(selected_scenario);
+		Scenario_t& texture_scenario = scenarios.at(texture_scenario_idx);
 
-		scenario_file << scene.background_texture << (advanced_scenes ? L":" + scene.background_overlay_texture : L"") << L":" << scene.background_music << L":" << scene.additional_scene_sound << std::endl;
+		int first_scene = current_scenario_scene > 0 ? current_scenario_scene : 0;
+		int last_scene = first_scene + texture_residency.prefetch_scenes;
 
-		if (advanced_scenes)
+		for (int i = first_scene; i < scenario.scenes.size() && i <= last_scene; i++)
 		{
-			scenario_file << scene.person1.person_name << L":" << scene.person1.person_texture << L":" << scene.person1.talking_text << L":" << scene.person1.person_texture_left << L":" << scene.person1.person_texture_right << L":" << scene.person1.person_texture_head << std::endl;
-			scenario_file << scene.person2.person_name << L":" << scene.person2.person_texture << L":" << scene.person2.talking_text << L":" << scene.person2.person_texture_left << L":" << scene.person2.person_texture_right << L":" << scene.person2.person_texture_head << std::endl;
-			scenario_file << scene.person3.person_name << L":" << scene.person3.person_texture << L":" << scene.person3.talking_text << L":" << scene.person3.person_texture_left << L":" << scene.person3.person_texture_right << L":" << scene.person3.person_texture_head << std::endl;
-			scenario_file << scene.person4.person_name << L":" << scene.person4.person_texture << L":" << scene.person4.talking_text << L":" << scene.person4.person_texture_left << L":" << scene.person4.person_texture_right << L":" << scene.person4.person_texture_head << std::endl;
+			scenario.scenes.at(i).for_each_texture([&](TextureHandle_t handle)
+			{
+				if (handle < 0 || handle >= texture_scenario.textures.size())
+					return;
+
+				texture_residency.keep(texture_scenario.textures.at(handle));
+				request_texture(texture_scenario_idx, handle, i == first_scene);
+			});
 		}
-		else
+
+		// first scenes of branches player can choose
+		if (branch_scenarios_owner == selected_scenario && branch_scenarios_scene == current_scenario_scene)
 		{
-			scenario_file << scene.person1.person_name << L":" << scene.person1.person_texture << L":" << scene.person1.talking_text << std::endl;
-			scenario_file << scene.person2.person_name << L":" << scene.person2.person_texture << L":" << scene.person2.talking_text << std::endl;
-			scenario_file << scene.person3.person_name << L":" << scene.person3.person_texture << L":" << scene.person3.talking_text << std::endl;
-			scenario_file << scene.person4.person_name << L":" << scene.person4.person_texture << L":" << scene.person4.talking_text << std::endl;
-		}
+			for (int i = 0; i < branch_scenarios.size(); i++)
+			{
+				Scenario_t& branch_scenario = scenarios.at(branch_scenarios.at(i));
 
-		scenario_file << scene.main_character.talking_text << std::endl;
+				int branch_texture_scenario_idx = get_texture_scenario_index(branch_scenarios.at(i));
+				Scenario_t& branch_texture_scenario = scenarios.at(branch_texture_scenario_idx);
 
-		scenario_file << scene.button1.button_name << L":" << scene.button1.button_scenario_to_load << std::endl;
-		scenario_file << scene.button2.button_name << L":" << scene.button2.button_scenario_to_load << std::endl;
-		scenario_file << scene.button3.button_name << L":" << scene.button3.button_scenario_to_load << std::endl;
-		scenario_file << scene.button4.button_name << L":" << scene.button4.button_scenario_to_load << std::endl;
+				if (branch_scenario.scenes.empty())
+					continue;
 
-		scenario_file << scene.overlay_texture << std::endl;
+				branch_scenario.scenes.at(0).for_each_texture([&](TextureHandle_t handle)
+				{
+					if (handle < 0 || handle >= branch_texture_scenario.textures.size())
+						return;
 
-		scenario_file << L"[scene_end]" << std::endl;
+					texture_residency.keep(branch_texture_scenario.textures.at(handle));
+					request_texture(branch_texture_scenario_idx, handle, false);
+				});
+			}
+		}
+		else if (!branch_scenarios.empty())
+			cancel_branch_prefetch(-1);
 	}
 
-	scenario_file.close();
+	evict_textures();
 }
 
-void load_scenario_data(int scenario_idx)
+// uploads decoded textures until time budget is spent, at least one texture per call
+void process_texture_uploads(float budget_ms)
 {
-	if (scenario_idx < 0 || scenario_idx >= scenarios.size())
-		return;
-
-	Scenario_t& scenario = scenarios.at(scenario_idx);
-
-	if (scenario.loaded)
-		return;
-
-	scenario.textures = load_textures(scenario.textures_dir);
-	scenario.scenes = load_scenes(scenario.file_path);
-
-	scenario.loaded = true;
-}
+	auto start = std::chrono::steady_clock::now();
 
-std::vector<Scenario_t> load_scenarios(std::wstring directory, std::wstring texture_folder, std::wstring music_folder)
-{
-	WIN32_FIND_DATAW findData;
-	HANDLE hFind = INVALID_HANDLE_VALUE;
+	DecodedTexture_t decoded;
 
-	std::wstring full_path = directory + L"\\";
-	std::wstring full_path_with_filter = full_path + L"*";
+	while (texture_loader.pop_decoded(decoded))
+	{
+		TextureLoadJob_t& job = decoded.job;
 
-	std::vector<Scenario_t> scenario_list;
+		if (job.scenario_idx >= 0 && job.scenario_idx < scenarios.size())
+		{
+			Scenario_t& scenario = scenarios.at(job.scenario_idx);
 
-	hFind = FindFirstFileW(full_path_with_filter.c_str(), &findData);
+			if (scenario.texture_generation == job.generation && job.texture_idx < scenario.textures.size())
+			{
+				ScenarioTexture_t& texture = scenario.textures.at(job.texture_idx);
 
-	while (FindNextFileW(hFind, &findData) != 0)
-	{
-		Scenario_t scenario;
+				// texture could be requested again after its load was cancelled
+				if (decoded.decoded && !texture.ready)
+				{
+					bool uploaded = texture.character_texture && texture_atlases_enabled && upload_atlas_sprite(scenario.texture_atlas, texture, decoded.image);
 
-		scenario.file_name = std::wstring(findData.cFileName);
-		scenario.file_path = std::wstring(full_path + findData.cFileName);
-		scenario.textures_dir = texture_folder + L"\\" + std::wstring(get_filename_without_ext(scenario.file_name)) + L"\\";
-		scenario.music_dir = music_folder + L"\\" + std::wstring(get_filename_without_ext(scenario.file_name)) + L"\\";
+					if (!uploaded)
+						upload_texture(texture, decoded.image);
+				}
 
-		scenario.loaded = false;
+				texture.loading = false;
+				texture.failed = !texture.ready;
+			}
+		}
 
-		if (get_file_ext(scenario.file_name) == L".sc")
-			scenario_list.push_back(scenario);
+		if (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= budget_ms)
+			break;
 	}
-
-	FindClose(hFind);
-
-	return scenario_list;
 }
 
-void load_game_assets(ImGuiIO& io)
+std::vector<ScenarioDialogueScene_t> load_scenes(std::wstring path)
 {
-	load_menu_fonts(io);
-	load_menu_images(io);
-
-	load_music_files();
+	std::vector<ScenarioDialogueScene_t> scenes;
 
-	for (int i = 0; i < scenarios.size(); i++)
-		load_scenario_data(i);
-}
+	ScenarioDialogueScene_t scene;
 
-void reload_game_assets(ImGuiIO& io)
+	if (wcsstr(GetCommandLineW(), L"-skid1337"))
+	{
+		scene.button1.button_name = L"NONE";
+		scene.button2.button_name = L"NONE";
+		scene.button3.button_name = L"NONE";
+		scene.button4.button_name = L"NONE";
+
+		scene.background_overlay_texture = L"NONE";
+		scene.overlay_texture = L"NONE";
+
+		scene.person1.talking = false;
+		scene.person1.person_name = L"NONE";
+		scene.person1.person_texture = L"NONE";
+		scene.person1.person_texture_left = L"NONE";
+		scene.person1.person_texture_right = L"NONE";
+		scene.person1.person_texture_head = L"NONE";
+
+		scene.person2.talking = false;
+		scene.person2.person_name = L"NONE";
+		scene.person2.person_texture = L"NONE";
+		scene.person2.person_texture_left = L"NONE";
+		scene.person2.person_texture_right = L"NONE";
+		scene.person2.person_texture_head = L"NONE";
+
+		scene.person3.talking = false;
+		scene.person3.person_name = L"NONE";
+		scene.person3.person_texture = L"NONE";
+		scene.person3.person_texture_left = L"NONE";
+		scene.person3.person_texture_right = L"NONE";
+		scene.person3.person_texture_head = L"NONE";
+
+		scene.person4.talking = false;
+		scene.person4.person_name = L"NONE";
+		scene.person4.person_texture = L"NONE";
+		scene.person4.person_texture_left = L"NONE";
+		scene.person4.person_texture_right = L"NONE";
+		scene.person4.person_texture_head = L"NONE";
+
+		scene.person1.person_name = L"Komok050505";
+
+		scene.person1.talking = true;
+		scene.person1.talking_text = L"Hello skid1337!";
+
+		scenes.push_back(scene);
+
+		scene = ScenarioDialogueScene_t();
+
+		scene.button1.button_name = L"NONE";
+		scene.button2.button_name = L"NONE";
+		scene.button3.button_name = L"NONE";
+		scene.button4.button_name = L"NONE";
+
+		scene.background_overlay_texture = L"NONE";
+		scene.overlay_texture = L"NONE";
+
+		scene.person1.talking = false;
+		scene.person1.person_name = L"NONE";
+		scene.person1.person_texture = L"NONE";
+		scene.person1.person_texture_left = L"NONE";
+		scene.person1.person_texture_right = L"NONE";
+		scene.person1.person_texture_head = L"NONE";
+
+		scene.person2.talking = false;
+		scene.person2.person_name = L"NONE";
+		scene.person2.person_texture = L"NONE";
+		scene.person2.person_texture_left = L"NONE";
+		scene.person2.person_texture_right = L"NONE";
+		scene.person2.person_texture_head = L"NONE";
+
+		scene.person3.talking = false;
+		scene.person3.person_name = L"NONE";
+		scene.person3.person_texture = L"NONE";
+		scene.person3.person_texture_left = L"NONE";
+		scene.person3.person_texture_right = L"NONE";
+		scene.person3.person_texture_head = L"NONE";
+
+		scene.person4.talking = false;
+		scene.person4.person_name = L"NONE";
+		scene.person4.person_texture = L"NONE";
+		scene.person4.person_texture_left = L"NONE";
+		scene.person4.person_texture_right = L"NONE";
+		scene.person4.person_texture_head = L"NONE";
+
+		scene.person1.person_name = L"Komok050505";
+
+		scene.person1.talking = true;
+		scene.person1.talking_text = L"Welcome to " + game_info.game_name + L"!";
+
+		scenes.push_back(scene);
+
+		scene = ScenarioDialogueScene_t();
+	}
+
+	// compiled scenario is used only while it was compiled from this text one, otherwise text scenario is parsed and compiled again
+	if (!load_compiled_scenario(path, advanced_scenes, scenes))
+	{
+		std::vector<ScenarioDialogueScene_t> parsed_scenes;
+		parse_scenario_file(path, std_locale, advanced_scenes, parsed_scenes);
+
+		if (parsed_scenes.size() > 0)
+			compile_scenario(path, parsed_scenes, advanced_scenes);
+
+		scenes.insert(scenes.end(), std::make_move_iterator(parsed_scenes.begin()), std::make_move_iterator(parsed_scenes.end()));
+	}
+
+	return scenes;
+}
+
+void create_new_scenario(std::wstring name)
+{
+	if (exists(L".\\game\\scenarios\\" + name + L".sc"))
+		return;
+
+	std::wofstream new_scenario(L".\\game\\scenarios\\" + name + L".sc");
+	new_scenario.imbue(std::locale(std_locale));
+
+	new_scenario << L"[scene_start]" << std::endl;
+
+	if (advanced_scenes)
+		new_scenario << L"NONE:NONE:NONE:NONE" << std::endl;
+	else
+		new_scenario << L"NONE:NONE:NONE" << std::endl;
+
+	if (advanced_scenes)
+	{
+		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
+		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
+		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
+		new_scenario << L"NONE:NONE:NONE:NONE:NONE:NONE" << std::endl;
+	}
+	else
+	{
+		new_scenario << L"NONE:NONE:NONE" << std::endl;
+		new_scenario << L"NONE:NONE:NONE" << std::endl;
+		new_scenario << L"NONE:NONE:NONE" << std::endl;
+		new_scenario << L"NONE:NONE:NONE" << std::endl;
+	}
+
+	new_scenario << L"NONE" << std::endl;
+
+	new_scenario << L"NONE:NONE" << std::endl;
+	new_scenario << L"NONE:NONE" << std::endl;
+	new_scenario << L"NONE:NONE" << std::endl;
+	new_scenario << L"NONE:NONE" << std::endl;
+
+	if (advanced_scenes)
+		new_scenario << L"NONE" << std::endl;
+
+	new_scenario << L"[scene_end]" << std::endl;
+
+	new_scenario.close();
+}
+
+void save_scenario_data(Scenario_t& scenario)
+{
+	std::wofstream scenario_file(scenario.file_path);
+	scenario_file.imbue(std::locale(std_locale));
+
+	for (int i = 0; i < scenario.scenes.size(); i++)
+	{
+		ScenarioDialogueScene_t& scene = scenario.scenes.at(i);
+
+		scenario_file << L"[scene_start]" << std::endl;
+
+		scenario_file << scene.background_texture;
+
+		if (advanced_scenes)
+			scenario_file << L":" << scene.background_overlay_texture;
+
+		scenario_file << L":" << scene.background_music << L":" << scene.additional_scene_sound << std::endl;
+
+		if (advanced_scenes)
+		{
+			scenario_file << scene.person1.person_name << L":" << scene.person1.person_texture << L":" << scene.person1.talking_text << L":" << scene.person1.person_texture_left << L":" << scene.person1.person_texture_right << L":" << scene.person1.person_texture_head << std::endl;
+			scenario_file << scene.person2.person_name << L":" << scene.person2.person_texture << L":" << scene.person2.talking_text << L":" << scene.person2.person_texture_left << L":" << scene.person2.person_texture_right << L":" << scene.person2.person_texture_head << std::endl;
+			scenario_file << scene.person3.person_name << L":" << scene.person3.person_texture << L":" << scene.person3.talking_text << L":" << scene.person3.person_texture_left << L":" << scene.person3.person_texture_right << L":" << scene.person3.person_texture_head << std::endl;
+			scenario_file << scene.person4.person_name << L":" << scene.person4.person_texture << L":" << scene.person4.talking_text << L":" << scene.person4.person_texture_left << L":" << scene.person4.person_texture_right << L":" << scene.person4.person_texture_head << std::endl;
+		}
+		else
+		{
+			scenario_file << scene.person1.person_name << L":" << scene.person1.person_texture << L":" << scene.person1.talking_text << std::endl;
+			scenario_file << scene.person2.person_name << L":" << scene.person2.person_texture << L":" << scene.person2.talking_text << std::endl;
+			scenario_file << scene.person3.person_name << L":" << scene.person3.person_texture << L":" << scene.person3.talking_text << std::endl;
+			scenario_file << scene.person4.person_name << L":" << scene.person4.person_texture << L":" << scene.person4.talking_text << std::endl;
+		}
+
+		scenario_file << scene.main_character.talking_text << std::endl;
+
+		scenario_file << scene.button1.button_name << L":" << scene.button1.button_scenario_to_load << std::endl;
+		scenario_file << scene.button2.button_name << L":" << scene.button2.button_scenario_to_load << std::endl;
+		scenario_file << scene.button3.button_name << L":" << scene.button3.button_scenario_to_load << std::endl;
+		scenario_file << scene.button4.button_name << L":" << scene.button4.button_scenario_to_load << std::endl;
+
+		scenario_file << scene.overlay_texture << std::endl;
+
+		scenario_file << L"[scene_end]" << std::endl;
+	}
+
+	scenario_file.close();
+}
+
+// same combination of parts is shared by all scenes, composite is made on first use and evicted like any texture
+TextureHandle_t find_character_composite(Scenario_t& texture_scenario, ScenarioDialogueScenePersonData_t& person)
+{
+	if (person.person_texture_left_handle == INVALID_TEXTURE_HANDLE)
+		return INVALID_TEXTURE_HANDLE;
+
+	TextureCompositeKey_t key = { person.person_texture_left_handle, INVALID_TEXTURE_HANDLE, INVALID_TEXTURE_HANDLE };
+
+	if (person.is_valid_texture_right())
+		key.at(1) = person.person_texture_right_handle;
+
+	if (person.is_valid_texture_head())
+		key.at(2) = person.person_texture_head_handle;
+
+	if (key.at(1) == INVALID_TEXTURE_HANDLE && key.at(2) == INVALID_TEXTURE_HANDLE)
+		return INVALID_TEXTURE_HANDLE;
+
+	TextureHandle_t handle = texture_scenario.texture_registry.find_composite(key);
+
+	if (handle != INVALID_TEXTURE_HANDLE)
+		return handle;
+
+	ScenarioTexture_t composite;
+
+	for (int i = 0; i < key.size(); i++)
+	{
+		if (key.at(i) == INVALID_TEXTURE_HANDLE)
+			continue;
+
+		// '|' cant be part of file name, so composite names dont clash with texture names
+		composite.texture_name += (composite.layers.empty() ? L"" : L"|") + texture_scenario.textures.at(key.at(i)).texture_name;
+		composite.layers.push_back(key.at(i));
+	}
+
+	// composites are character textures, trimmed and atlased like their parts
+	composite.character_texture = true;
+
+	texture_scenario.textures.push_back(composite);
+
+	handle = texture_scenario.textures.size() - 1;
+	texture_scenario.texture_registry.composites.emplace(key, handle);
+
+	return handle;
+}
+
+void resolve_character_composites(Scenario_t& texture_scenario, ScenarioDialogueScene_t& scene)
+{
+	scene.for_each_person([&](ScenarioDialogueScenePersonData_t& person)
+	{
+		person.person_composite_handle = find_character_composite(texture_scenario, person);
+	});
+}
+
+// characters are trimmed and packed into atlases, backgrounds and overlays are mostly opaque anyway
+void mark_character_textures(Scenario_t& texture_scenario, ScenarioDialogueScene_t& scene)
+{
+	scene.for_each_character_texture([&](TextureHandle_t handle)
+	{
+		if (handle >= 0 && handle < texture_scenario.textures.size())
+			texture_scenario.textures.at(handle).character_texture = true;
+	});
+}
+
+void resolve_scenario_textures(Scenario_t& scenario)
+{
+	const TextureRegistry_t& registry = get_texture_scenario(scenario).texture_registry;
+
+	for (int i = 0; i < scenario.scenes.size(); i++)
+		scenario.scenes.at(i).resolve_textures(registry);
+
+	Scenario_t& texture_scenario = get_texture_scenario(scenario);
+
+	if (advanced_scenes)
+	{
+		for (int i = 0; i < scenario.scenes.size(); i++)
+			resolve_character_composites(texture_scenario, scenario.scenes.at(i));
+	}
+
+	for (int i = 0; i < scenario.scenes.size(); i++)
+		mark_character_textures(texture_scenario, scenario.scenes.at(i));
+}
+
+void resolve_button_scenario(ScenarioDialogueSceneButton_t& button)
+{
+	button.scenario_to_load_idx = button.has_scenario_action() ? find_scenario_index(button.button_scenario_to_load) : -1;
+}
+
+void resolve_scenario_buttons(Scenario_t& scenario)
+{
+	for (int i = 0; i < scenario.scenes.size(); i++)
+		scenario.scenes.at(i).for_each_button(resolve_button_scenario);
+}
+
+// runs on scenario_loader worker, Scenario_t isnt touched there
+void load_scenario_files(ScenarioLoadJob_t& job)
+{
+	TraceScope_t trace_scope("load_scenario_files");
+
+	job.textures = load_textures(job.textures_dir);
+	job.texture_registry.build(job.textures);
+
+	job.scenes = load_scenes(job.file_path);
+}
+
+void apply_scenario_data(ScenarioLoadJob_t& job)
+{
+	TraceScope_t trace_scope("apply_scenario_data");
+
+	Scenario_t& scenario = scenarios.at(job.scenario_idx);
+
+	scenario.loading = false;
+
+	if (scenario.loaded)
+		return;
+
+	scene_render_plan.invalidate();
+
+	scenario.texture_generation = ++texture_generation_counter;
+
+	scenario.textures = std::move(job.textures);
+	scenario.texture_registry = std::move(job.texture_registry);
+
+	scenario.scenes = std::move(job.scenes);
+
+	resolve_scenario_textures(scenario);
+	resolve_scenario_buttons(scenario);
+
+	scenario.loaded = true;
+}
+
+// queues scenario to scenario_loader, process_scenario_loads applies it once it is loaded
+void request_scenario_data(int scenario_idx)
+{
+	if (scenario_idx < 0 || scenario_idx >= scenarios.size())
+		return;
+
+	Scenario_t& scenario = scenarios.at(scenario_idx);
+
+	if (scenario.loaded || scenario.loading)
+		return;
+
+#ifdef DCS_STORY_GAME
+	// all story scenarios use textures of main scenario, loads are applied in order so it is there first
+	int main_scenario_idx = find_scenario_index(L"main.sc");
+
+	if (main_scenario_idx != -1 && main_scenario_idx != scenario_idx)
+		request_scenario_data(main_scenario_idx);
+#endif
+
+	ScenarioLoadJob_t job;
+
+	job.scenario_idx = scenario_idx;
+	job.textures_dir = scenario.textures_dir;
+	job.file_path = scenario.file_path;
+
+	scenario_loader.queue(job);
+	scenario.loading = true;
+}
+
+void process_scenario_loads()
+{
+	ScenarioLoadJob_t job;
+
+	while (scenario_loader.pop_loaded(job))
+		apply_scenario_data(job);
+}
+
+// blocks until scenario is loaded, for startup and headless runs
+void load_scenario_data(int scenario_idx)
+{
+	TraceScope_t trace_scope("load_scenario_data");
+
+	if (scenario_idx < 0 || scenario_idx >= scenarios.size())
+		return;
+
+	Scenario_t& scenario = scenarios.at(scenario_idx);
+
+	if (scenario.loaded)
+		return;
+
+#ifdef DCS_STORY_GAME
+	// all story scenarios use textures of main scenario
+	int main_scenario_idx = find_scenario_index(L"main.sc");
+
+	if (main_scenario_idx != -1 && main_scenario_idx != scenario_idx)
+		load_scenario_data(main_scenario_idx);
+#endif
+
+	ScenarioLoadJob_t job;
+
+	// queued scenario is finished by worker, loads queued before it are applied on the way
+	while (scenario.loading && scenario_loader.wait_loaded(job))
+		apply_scenario_data(job);
+
+	if (scenario.loaded)
+		return;
+
+	job = ScenarioLoadJob_t();
+
+	job.scenario_idx = scenario_idx;
+	job.textures_dir = scenario.textures_dir;
+	job.file_path = scenario.file_path;
+
+	load_scenario_files(job);
+	apply_scenario_data(job);
+}
+
+// loads scenarios targeted by scene buttons, their first scene textures are requested by update_texture_residency
+void prefetch_branch_scenarios(ScenarioDialogueScene_t& scene)
+{
+	if (branch_scenarios_owner == selected_scenario && branch_scenarios_scene == current_scenario_scene)
+		return;
+
+	cancel_branch_prefetch(-1);
+
+	branch_scenarios_owner = selected_scenario;
+	branch_scenarios_scene = current_scenario_scene;
+
+	scene.for_each_button([](ScenarioDialogueSceneButton_t& button)
+	{
+		if (button.scenario_to_load_idx == -1)
+			return;
+
+		request_scenario_data(button.scenario_to_load_idx);
+		branch_scenarios.push_back(button.scenario_to_load_idx);
+	});
+}
+
+std::vector<Scenario_t> load_scenarios(std::wstring directory, std::wstring texture_folder, std::wstring music_folder)
+{
+	TraceScope_t trace_scope("load_scenarios");
+
+	WIN32_FIND_DATAW findData;
+	HANDLE hFind = INVALID_HANDLE_VALUE;
+
+	std::wstring full_path = directory + L"\\";
+	std::wstring full_path_with_filter = full_path + L"*";
+
+	std::vector<Scenario_t> scenario_list;
+
+	hFind = FindFirstFileW(full_path_with_filter.c_str(), &findData);
+
+	while (FindNextFileW(hFind, &findData) != 0)
+	{
+		Scenario_t scenario;
+
+		scenario.file_name = std::wstring(findData.cFileName);
+		scenario.file_path = std::wstring(full_path + findData.cFileName);
+		scenario.textures_dir = texture_folder + L"\\" + std::wstring(get_filename_without_ext(scenario.file_name)) + L"\\";
+		scenario.music_dir = music_folder + L"\\" + std::wstring(get_filename_without_ext(scenario.file_name)) + L"\\";
+
+		scenario.loaded = false;
+
+		if (get_file_ext(scenario.file_name) == L".sc")
+			scenario_list.push_back(scenario);
+	}
+
+	FindClose(hFind);
+
+	return scenario_list;
+}
+
+void create_placeholder_texture()
+{
+	placeholder_texture.texture_name = L"NONE";
+
+	placeholder_texture.width = 1;
+	placeholder_texture.height = 1;
+
+	if (headless)
+		return;
+
+#ifndef DCS_OPENGL
+	if (placeholder_texture.texture_data)
+		return;
+
+	const uint32_t pixel = 0;
+
+	D3D11_TEXTURE2D_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA data;
+	ZeroMemory(&data, sizeof(data));
+	data.pSysMem = &pixel;
+	data.SysMemPitch = sizeof(pixel);
+
+	ID3D11Texture2D* texture = nullptr;
+
+	if (SUCCEEDED(g_pd3dDevice->CreateTexture2D(&desc, &data, &texture)))
+	{
+		g_pd3dDevice->CreateShaderResourceView(texture, nullptr, &placeholder_texture.texture_data);
+		texture->Release();
+	}
+#else
+	sf::Image image;
+	image.create(1, 1, sf::Color(0, 0, 0, 0));
+
+	placeholder_texture.texture_data.loadFromImage(image);
+#endif
+}
+
+void load_game_assets(ImGuiIO& io)
+{
+	TraceScope_t trace_scope("load_game_assets");
+
+	load_menu_fonts(io);
+	load_menu_images(io);
+
+	create_placeholder_texture();
+
+	load_music_files();
+
+	for (int i = 0; i < scenarios.size(); i++)
+		load_scenario_data(i);
+}
+
+void reload_game_assets(ImGuiIO& io)
 {
+	TraceScope_t trace_scope("reload_game_assets");
+
 	load_menu_fonts(io);
 	load_menu_images(io);
+
+	create_placeholder_texture();
+
+	// text sizes of plan depend on fonts
+	scene_render_plan.invalidate();
 }
 
 void unload_game_images_and_textures()
 {
+	texture_loader.cancel(-1);
+	scenario_loader.cancel();
+
 	for (int i = 0; i < scenarios.size(); i++)
 	{
 #ifndef DCS_OPENGL
 		for (int c = 0; c < scenarios.at(i).textures.size(); c++)
-			scenarios.at(i).textures.at(c).texture_data->Release();
+		{
+			if (scenarios.at(i).textures.at(c).texture_data)
+				scenarios.at(i).textures.at(c).texture_data->Release();
+		}
 #endif
 
+		for (int c = 0; c < scenarios.at(i).texture_atlas.pages.size(); c++)
+			release_atlas_page(scenarios.at(i).texture_atlas, scenarios.at(i).texture_atlas.pages.at(c));
+
+		scenarios.at(i).texture_atlas.pages.clear();
+
+		scenarios.at(i).texture_generation = 0;
+
 		scenarios.at(i).scenes.clear();
 		scenarios.at(i).textures.clear();
+		scenarios.at(i).texture_registry.clear();
 
 		scenarios.at(i).loaded = false;
+		scenarios.at(i).loading = false;
+	}
+
+	texture_residency.resident_bytes = 0;
+
+	branch_scenarios.clear();
+
+	branch_scenarios_owner = -1;
+	branch_scenarios_scene = -1;
+
+#ifndef DCS_OPENGL
+	if (placeholder_texture.texture_data)
+	{
+		placeholder_texture.texture_data->Release();
+		placeholder_texture.texture_data = nullptr;
 	}
+#endif
 }
 
 void unload_music_data()
@@ -1533,7 +2348,7 @@ void game_settings_menu()
 {
 	static GameSettings_t new_settings = game_settings;
 
-	ImVec2 size = ImVec2(250, 217);
+	ImVec2 size = ImVec2(250, 240);
 	ImVec2 position = settings_render_position;
 
 	ImGuiWindowFlags flags = ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse;
@@ -1550,6 +2365,7 @@ void game_settings_menu()
 
 	ImGui::Checkbox(LANG(L"Auto save", L"Àâòîñîõðàíåíèå"), &new_settings.auto_save);
 	ImGui::Checkbox(LANG(L"Show FPS counter", L"Ïîêàçûâàòü ñ÷åò÷èê FPS"), &new_settings.show_fps_counter);
+	ImGui::Checkbox(LANG(L"Pause rendering when idle", L"Íå ïåðåðèñîâûâàòü â ïðîñòîå"), &new_settings.idle_rendering);
 
 	ImGui::Checkbox(LANG(L"Animated dialogue text", L"Àíèìèðîâàííûé òåêñò äèàëîãîâ"), &new_settings.animated_dialogue_text);
 
@@ -1671,6 +2487,16 @@ void save_menu(Scenario_t& scenario)
 	ImGui::End();
 }
 
+// main loop ends and cleans up as when window is closed, exit() would skip trace writing and loader shutdown
+void request_quit()
+{
+	quit_requested = true;
+
+#ifndef DCS_OPENGL
+	PostQuitMessage(0);
+#endif
+}
+
 void main_game_menu(Scenario_t& scenario)
 {
 	ImGui::GetBackgroundDrawList()->AddRectFilled(ImVec2(0, 0), ImGui::GetIO().DisplaySize, ImColor(20, 20, 20, 135));
@@ -1729,7 +2555,7 @@ void main_game_menu(Scenario_t& scenario)
 		exit_to_main_menu(false);
 
 	if (ImGui::Button(LANG(L"Quit game", L"Âûõîä èç èãðû"), ImVec2(230, 20)))
-		exit(0);
+		request_quit();
 
 	ImGui::End();
 
@@ -1742,7 +2568,7 @@ void main_game_menu(Scenario_t& scenario)
 		ImGui::Text(LANG(L"History", L"Èñòîðèÿ"));
 
 		for (int i = 0; i < dialogue_history.size(); i++)
-			ImGui::TextWrapped(utf8(dialogue_history.at(i).c_str()));
+			text_run_cache.text_wrapped(frame_arena.utf8(dialogue_history.at(i)));
 
 		ImGui::End();
 	}
@@ -1751,47 +2577,67 @@ void main_game_menu(Scenario_t& scenario)
 		save_menu(scenario);
 }
 
-void texture_selector(const wchar_t* name, Scenario_t& scenario, std::wstring& texture)
+// true if other texture was selected
+bool texture_selector(const wchar_t* name, Scenario_t& scenario, std::wstring_view& texture)
 {
+	bool changed = false;
+
 	static std::string search_buf = "";
 
-	ImGui::Text(utf8(name));
+	// items are converted into it, its capacity is kept between items and frames
+	static std::string item_name = "";
+
+	ImGui::Text(frame_arena.utf8(name));
 
 	ImGui::SetNextItemWidth(200);
-	ImGui::InputTextWithHint(std::string(std::string("##SEARCH") + ws2s(name)).c_str(), LANG(L"Search", L"Ïîèñê"), &search_buf);
+	ImGui::InputTextWithHint(frame_arena.format("##SEARCH%s", frame_arena.utf8(name)), LANG(L"Search", L"Ïîèñê"), &search_buf);
 
 	ImGui::SetNextItemWidth(200);
-	if (ImGui::BeginListBox(std::string(std::string("##") + ws2s(name)).c_str()))
+	if (ImGui::BeginListBox(frame_arena.format("##%s", frame_arena.utf8(name))))
 	{
 		for (int i = 0; i < scenario.textures.size() + 1; i++)
 		{
 			if (i == 0)
 			{
 				if (ImGui::Selectable("None", texture == L"NONE"))
+				{
+					changed = texture != L"NONE";
 					texture = L"NONE";
+				}
 			}
-			else
+			else if (scenario.textures.at(i - 1).layers.empty()) // composites arent texture files
 			{
-				if ((search_buf == "" || strstr(ws2s(scenario.textures.at(i - 1).texture_name).c_str(), search_buf.c_str())) && ImGui::Selectable(ws2s(scenario.textures.at(i - 1).texture_name).c_str(), texture == scenario.textures.at(i - 1).texture_name))
-					texture = scenario.textures.at(i - 1).texture_name;
+				const std::wstring& texture_name = scenario.textures.at(i - 1).texture_name;
+
+				encode_utf8(texture_name.data(), texture_name.size(), item_name);
+
+				if ((search_buf == "" || strstr(item_name.c_str(), search_buf.c_str())) && ImGui::Selectable(item_name.c_str(), texture == texture_name))
+				{
+					changed = texture != texture_name;
+					texture = scenario_name_table.intern(texture_name);
+				}
 			}
 		}
 
 		ImGui::EndListBox();
 	}
+
+	return changed;
 }
 
-void scenario_selector(const wchar_t* name, std::wstring& scenario, int idx = 0)
+void scenario_selector(const wchar_t* name, std::wstring_view& scenario, int idx = 0)
 {
 	static std::string search_buf = "";
 
-	ImGui::Text(utf8(name));
+	static std::wstring item_name = L"";
+
+	ImGui::Text(frame_arena.utf8(name));
 
 	ImGui::SetNextItemWidth(200);
-	ImGui::InputTextWithHint(std::string(std::string("##SEARCH") + ws2s(name) + std::to_string(idx)).c_str(), LANG(L"Search", L"Ïîèñê"), &search_buf);
+	ImGui::InputTextWithHint(frame_arena.format("##SEARCH%s%d", frame_arena.utf8(name), idx), LANG(L"Search", L"Ïîèñê"), &search_buf);
 
 	ImGui::SetNextItemWidth(200);
-	if (ImGui::BeginListBox(std::string(std::string("##") + ws2s(name) + std::to_string(idx)).c_str()))
+	if (ImGui::BeginListBox(frame_arena.format("##%s%d", frame_arena.utf8(name), idx)))
 	{
 		for (int i = 0; i < scenario_names.size() + 1; i++)
 		{
@@ -1802,43 +2648,272 @@ void scenario_selector(const wchar_t* name, std::wstring& scenario, int idx = 0)
 			}
 			else
 			{
-				if ((search_buf == "" || strstr(scenario_names.at(i - 1).c_str(), search_buf.c_str())) && ImGui::Selectable(scenario_names.at(i - 1).c_str(), scenario == s2ws(scenario_names.at(i - 1))))
-					scenario = s2ws(scenario_names.at(i - 1));
+				const std::string& scenario_name = scenario_names.at(i - 1);
+
+				if (search_buf == "" || strstr(scenario_name.c_str(), search_buf.c_str()))
+				{
+					decode_utf8(scenario_name.data(), scenario_name.size(), item_name);
+
+					if (ImGui::Selectable(scenario_name.c_str(), scenario == item_name))
+						scenario = scenario_name_table.intern(item_name);
+				}
+			}
+		}
+
+		ImGui::EndListBox();
+	}
+}
+
+void sound_selector(const wchar_t* name, Scenario_t& scenario, std::wstring_view& sound)
+{
+	static std::string search_buf = "";
+
+	static std::string item_name = "";
+
+	ImGui::Text(frame_arena.utf8(name));
+
+	ImGui::SetNextItemWidth(200);
+	ImGui::InputTextWithHint(frame_arena.format("##SEARCH%s", frame_arena.utf8(name)), LANG(L"Search", L"Ïîèñê"), &search_buf);
+
+	ImGui::SetNextItemWidth(200);
+	if (ImGui::BeginListBox(frame_arena.format("##%s", frame_arena.utf8(name))))
+	{
+		for (int i = 0; i < music.size() + 1; i++)
+		{
+			if (i == 0)
+			{
+				if (ImGui::Selectable("None", sound == L"NONE"))
+					sound = L"NONE";
+			}
+			else
+			{
+				const std::wstring& music_name = music.at(i - 1).music_name;
+
+				encode_utf8(music_name.data(), music_name.size(), item_name);
+
+				if ((search_buf == "" || strstr(item_name.c_str(), search_buf.c_str())) && ImGui::Selectable(item_name.c_str(), sound == music_name))
+					sound = scenario_name_table.intern(music_name);
 			}
 		}
 
-		ImGui::EndListBox();
-	}
-}
+		ImGui::EndListBox();
+	}
+}
+
+void update_scene_audio(ScenarioDialogueScene_t& scene)
+{
+	FrameProfilerScope_t profiler_scope(frame_profiler, FRAME_PHASE_AUDIO);
+
+	if (scene.background_music != L"NONE")
+	{
+		if (current_playing_music != scene.background_music)
+		{
+			stream_music(scene.background_music, music_stream);
+			current_playing_music = scene.background_music;
+		}
+	}
+	else
+	{
+		if (current_playing_music != L"")
+		{
+			BASS_ChannelStop(music_stream);
+			BASS_StreamFree(music_stream);
+
+			current_playing_music = L"";
+			paused_music = false;
+		}
+	}
+
+	if (scene.additional_scene_sound != L"NONE")
+	{
+		if (!additional_channel_playing)
+		{
+			stream_music(scene.additional_scene_sound, additional_stream);
+			additional_channel_playing = true;
+		}
+	}
+	else
+	{
+		if (additional_channel_playing)
+		{
+			BASS_ChannelStop(additional_stream);
+			BASS_StreamFree(additional_stream);
+
+			additional_channel_playing = false;
+		}
+	}
+}
+
+// see SceneRenderPlan_t, has to be called inside frame with main menu font pushed
+void build_scene_render_plan(SceneRenderPlan_t& plan, int scenario_idx, int scene_idx, ScenarioDialogueScene_t& scene)
+{
+	TraceScope_t trace_scope("build_scene_render_plan");
+
+	ImVec2 display_size = ImGui::GetIO().DisplaySize;
+
+	plan.valid = true;
+	plan.scenario_idx = scenario_idx;
+	plan.scene_idx = scene_idx;
+	plan.display_size = display_size;
+	plan.advanced_scenes = advanced_scenes;
+	plan.builds++;
+
+	plan.quads.clear();
+
+	SceneRenderQuad_t background;
+	background.handle = scene.background_texture_handle;
+	background.p_min = ImVec2(0, 0);
+	background.p_max = display_size;
+
+	plan.quads.push_back(background);
+
+	if (advanced_scenes && scene.background_overlay_texture != L"NONE")
+	{
+		background.handle = scene.background_overlay_texture_handle;
+		plan.quads.push_back(background);
+	}
+
+	plan.characters_count = 0;
+	plan.focused_character = -1;
+
+	scene.for_each_person([&](ScenarioDialogueScenePersonData_t& person)
+	{
+		if (person.is_valid_texture() || (advanced_scenes && person.is_valid_texture_left()))
+			plan.characters_count++;
+	});
+
+	int characters_count = plan.characters_count;
+
+	int character_texture_resolution_x = 400 * float(display_size.x / 1920.0f);
+	int character_texture_resolution_x_adv = 960 * float(display_size.x / 1920.0f);
+
+	plan.talking_text = L"";
+	plan.talking_name = L"";
+
+	int person_idx = 0;
+
+	scene.for_each_person([&](ScenarioDialogueScenePersonData_t& person)
+	{
+		person_idx++;
+
+		if (!person.talking)
+			return;
+
+		if (plan.talking_name != L"")
+			plan.talking_name += L"&";
+
+		plan.talking_name += person.person_name;
+
+		if (plan.talking_text == L"")
+			plan.talking_text = person.talking_text;
+
+		if (plan.focused_character == -1)
+			plan.focused_character = person_idx;
+	});
+
+	if (scene.main_character.talking)
+	{
+		if (plan.talking_name != L"")
+			plan.talking_name += L"&";
+
+		plan.talking_name += scene.main_character.person_name;
+
+		if (plan.talking_text == L"")
+			plan.talking_text = scene.main_character.talking_text;
+
+		plan.focused_character = -1;
+	}
+
+	int drawn_characters = 0;
+	ImVec2 next_position = ImVec2(((display_size.x - ((character_texture_resolution_x_adv - (character_texture_resolution_x_adv / (characters_count < 4 ? 3 : 2.4f))) * characters_count))) / 2 - (character_texture_resolution_x_adv / (characters_count < 4 ? 5 : 8)), 120 * float(display_size.y / 1080.0f));
+
+	// characters
+	scene.for_each_person([&](ScenarioDialogueScenePersonData_t& person)
+	{
+		if (!person.is_valid_texture() && !(advanced_scenes && person.is_valid_texture_left()))
+			return;
+
+		SceneRenderQuad_t quad;
+
+		if (advanced_scenes && person.is_valid_texture_left())
+		{
+			ImVec2 position = next_position;
+			ImVec2 size = ImVec2(character_texture_resolution_x_adv, display_size.y - (120 * float(display_size.y / 1080.0f)));
+
+			quad.handle = person.person_composite_handle;
+			quad.add_part(person.person_texture_left_handle);
+
+			if (person.is_valid_texture_right())
+				quad.add_part(person.person_texture_right_handle);
+
+			if (person.is_valid_texture_head())
+				quad.add_part(person.person_texture_head_handle);
+
+			quad.p_min = position;
+			quad.p_max = ImVec2(position.x + size.x, position.y + size.y);
+
+			next_position = ImVec2(position.x + (character_texture_resolution_x_adv - (character_texture_resolution_x_adv / (characters_count < 4 ? 3 : 2))), position.y);
+		}
+		else
+		{
+			ImVec2 position = ImVec2((display_size.x / 2 - character_texture_resolution_x / 2), 170 * float(display_size.y / 1080.0f));
+
+			if (characters_count == 2)
+				position.x = (display_size.x / 2 - character_texture_resolution_x + (character_texture_resolution_x * drawn_characters));
+			else if (characters_count == 3)
+				position.x = ((display_size.x / 2) - (character_texture_resolution_x + (character_texture_resolution_x / 2)) + (drawn_characters * character_texture_resolution_x));
+			else if (characters_count == 4)
+				position.x = (((display_size.x / 2) - (character_texture_resolution_x + character_texture_resolution_x)) + (drawn_characters * character_texture_resolution_x));
+
+			ImVec2 size = ImVec2(character_texture_resolution_x + 50, display_size.y - (170 * float(display_size.y / 1080.0f)));
+
+			quad.handle = person.person_texture_handle;
+
+			quad.p_min = position;
+			quad.p_max = ImVec2(position.x + size.x, position.y + size.y);
+		}
 
-void sound_selector(const wchar_t* name, Scenario_t& scenario, std::wstring& sound)
-{
-	static std::string search_buf = "";
+		plan.quads.push_back(quad);
+		drawn_characters++;
+	});
 
-	ImGui::Text(utf8(name));
+	// dialogue box
+	plan.box_position = ImVec2(200, (display_size.y - display_size.y / 4.0f));
+	plan.box_size = ImVec2(display_size.x - 400, display_size.y / 4.0f - 50);
 
-	ImGui::SetNextItemWidth(200);
-	ImGui::InputTextWithHint(std::string(std::string("##SEARCH") + ws2s(name)).c_str(), LANG(L"Search", L"Ïîèñê"), &search_buf);
+	plan.box_size.y = ImGui::CalcTextSize(utf8(plan.talking_name.c_str())).y * 6 + 55;
+	plan.box_position.y = display_size.y - 20 - plan.box_size.y;
 
-	ImGui::SetNextItemWidth(200);
-	if (ImGui::BeginListBox(std::string(std::string("##") + ws2s(name)).c_str()))
+	if (plan.talking_name == scene.main_character.person_name && plan.talking_text.at(scene.main_character.talking_text.length() - 1) == L'@')
 	{
-		for (int i = 0; i < music.size() + 1; i++)
-		{
-			if (i == 0)
-			{
-				if (ImGui::Selectable("None", sound == L"NONE"))
-					sound = L"NONE";
-			}
-			else
-			{
-				if ((search_buf == "" || strstr(ws2s(music.at(i - 1).music_name).c_str(), search_buf.c_str())) && ImGui::Selectable(ws2s(music.at(i - 1).music_name).c_str(), sound == music.at(i - 1).music_name))
-					sound = music.at(i - 1).music_name;
-			}
-		}
+		plan.talking_text.erase(scene.main_character.talking_text.length() - 1);
+		plan.talking_name = L"";
+	}
 
-		ImGui::EndListBox();
+	if (plan.talking_text.find(L"@MAINCHARACTERNAME") != std::wstring::npos)
+	{
+		std::vector<std::wstring> splitted_str = split_string(plan.talking_text, L'@');
+		plan.talking_text = splitted_str.at(0) + main_character_name + splitted_str.at(1).substr(17);
 	}
+
+	plan.talking_name_utf8 = utf8(plan.talking_name.c_str());
+
+	// wrapped once to content width of dialogue box
+	ImFont* text_font = game_fonts.dialogue_text_font.font_data ? game_fonts.dialogue_text_font.font_data : ImGui::GetFont();
+	plan.talking_text_layout.build(text_font, ws2s(plan.talking_text), plan.box_size.x - ImGui::GetStyle().WindowPadding.x * 2);
+
+	// name window above dialogue box
+	ImGui::PushFont(game_fonts.dialogue_name_font.font_data);
+	ImVec2 name_text_size = ImGui::CalcTextSize(plan.talking_name_utf8.c_str());
+	ImGui::PopFont();
+
+	plan.name_position = ImVec2(plan.box_position.x + 30, plan.box_position.y - name_text_size.y - 20);
+	plan.name_size = ImVec2(name_text_size.x + 20, name_text_size.y + 22);
+}
+
+bool is_game_window_focused()
+{
+	return headless || GetForegroundWindow() == hWnd;
 }
 
 void main_game()
@@ -1852,6 +2927,9 @@ void main_game()
 
 	ScenarioDialogueScene_t& scene = scenario.scenes.at(current_scenario_scene);
 
+	// set by texture selectors of scene editor, scene textures are resolved again only then
+	bool scene_textures_changed = false;
+
 	if (scenario_editor)
 	{
 		ImGui::SetNextWindowSize(ImVec2(250, 495));
@@ -1864,7 +2942,7 @@ void main_game()
 		{
 			for (int i = 0; i < scenario.scenes.size(); i++)
 			{
-				if (ImGui::Selectable(std::string("scene" + std::to_string(i)).c_str(), current_scenario_scene == i))
+				if (ImGui::Selectable(frame_arena.format("scene%d", i), current_scenario_scene == i))
 				{
 					scenario.scenes.at(i).main_character.talking = scenario.scenes.at(i).main_character.talking_text != L"NONE";
 
@@ -1879,10 +2957,7 @@ void main_game()
 					additional_channel_playing = false;
 					recorded_dialogue = false;
 
-					dialogue_text_to_render = L"";
-					dialogue_added_text_symbols = 0;
-
-					dialogue_text_animation_lerp = 0.0f;
+					dialogue_typewriter.restart();
 
 					current_scenario_scene = i;
 				}
@@ -1976,10 +3051,7 @@ void main_game()
 				{
 					scenario.scenes.erase(scenario.scenes.begin() + current_scenario_scene);
 
-					dialogue_text_to_render = L"";
-					dialogue_added_text_symbols = 0;
-
-					dialogue_text_animation_lerp = 0.0f;
+					dialogue_typewriter.restart();
 				}
 			}
 		}
@@ -2007,7 +3079,8 @@ void main_game()
 					else
 						ImGui::Columns(4);
 
-					std::string dialogue_text = ws2s(scene.main_character.talking_text);
+					static std::string dialogue_text = "";
+					ws2s(scene.main_character.talking_text, dialogue_text);
 
 					if (dialogue_text == "NONE")
 						dialogue_text = "";
@@ -2025,12 +3098,12 @@ void main_game()
 						scene.main_character.talking = true;
 
 					ImGui::NextColumn();
-					texture_selector(LANG_W(L"Background texture", L"Ôîíîâàÿ òåêñòóðà"), scenario, scene.background_texture);
+					scene_textures_changed |= texture_selector(LANG_W(L"Background texture", L"Ôîíîâàÿ òåêñòóðà"), scenario, scene.background_texture);
 
 					if (advanced_scenes)
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Background overlay texture", L"Íàëîæåííàÿ ôîíîâàÿ òåêñòóðà"), scenario, scene.background_overlay_texture);
+						scene_textures_changed |= texture_selector(LANG_W(L"Background overlay texture", L"Íàëîæåííàÿ ôîíîâàÿ òåêñòóðà"), scenario, scene.background_overlay_texture);
 					}
 
 					ImGui::NextColumn();
@@ -2042,7 +3115,7 @@ void main_game()
 					if (advanced_scenes)
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Screen overlay texture", L"Íàëîæåííàÿ òåêñòóðà"), scenario, scene.overlay_texture);
+						scene_textures_changed |= texture_selector(LANG_W(L"Screen overlay texture", L"Íàëîæåííàÿ òåêñòóðà"), scenario, scene.overlay_texture);
 					}
 
 					ImGui::Columns(1);
@@ -2059,7 +3132,8 @@ void main_game()
 					else
 						ImGui::Columns(2);
 
-					std::string dialogue_name = ws2s(person.person_name);
+					static std::string dialogue_name = "";
+					ws2s(person.person_name, dialogue_name);
 
 					if (dialogue_name == "NONE")
 						dialogue_name = "";
@@ -2070,7 +3144,8 @@ void main_game()
 					if (ImGui::InputText("##CHARACTER1DIALOGUENAME", &dialogue_name))
 						person.person_name = s2ws(dialogue_name);
 
-					std::string dialogue_text = ws2s(person.talking_text);
+					static std::string dialogue_text = "";
+					ws2s(person.talking_text, dialogue_text);
 
 					if (dialogue_text == "NONE")
 						dialogue_text = "";
@@ -2093,18 +3168,18 @@ void main_game()
 					if (advanced_scenes)
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
+						scene_textures_changed |= texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
+						scene_textures_changed |= texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
+						scene_textures_changed |= texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
 					}
 					else
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
+						scene_textures_changed |= texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
 					}
 
 					ImGui::Columns(1);
@@ -2121,7 +3196,8 @@ void main_game()
 					else
 						ImGui::Columns(2);
 
-					std::string dialogue_name = ws2s(person.person_name);
+					static std::string dialogue_name = "";
+					ws2s(person.person_name, dialogue_name);
 
 					if (dialogue_name == "NONE")
 						dialogue_name = "";
@@ -2132,7 +3208,8 @@ void main_game()
 					if (ImGui::InputText("##CHARACTER2DIALOGUENAME", &dialogue_name))
 						person.person_name = s2ws(dialogue_name);
 
-					std::string dialogue_text = ws2s(person.talking_text);
+					static std::string dialogue_text = "";
+					ws2s(person.talking_text, dialogue_text);
 
 					if (dialogue_text == "NONE")
 						dialogue_text = "";
@@ -2155,18 +3232,18 @@ void main_game()
 					if (advanced_scenes)
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
+						scene_textures_changed |= texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
+						scene_textures_changed |= texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
+						scene_textures_changed |= texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
 					}
 					else
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
+						scene_textures_changed |= texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
 					}
 
 					ImGui::Columns(1);
@@ -2183,7 +3260,8 @@ void main_game()
 					else
 						ImGui::Columns(2);
 
-					std::string dialogue_name = ws2s(person.person_name);
+					static std::string dialogue_name = "";
+					ws2s(person.person_name, dialogue_name);
 
 					if (dialogue_name == "NONE")
 						dialogue_name = "";
@@ -2194,7 +3272,8 @@ void main_game()
 					if (ImGui::InputText("##CHARACTER3DIALOGUENAME", &dialogue_name))
 						person.person_name = s2ws(dialogue_name);
 
-					std::string dialogue_text = ws2s(person.talking_text);
+					static std::string dialogue_text = "";
+					ws2s(person.talking_text, dialogue_text);
 
 					if (dialogue_text == "NONE")
 						dialogue_text = "";
@@ -2217,18 +3296,18 @@ void main_game()
 					if (advanced_scenes)
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
+						scene_textures_changed |= texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
+						scene_textures_changed |= texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
+						scene_textures_changed |= texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
 					}
 					else
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
+						scene_textures_changed |= texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
 					}
 
 					ImGui::Columns(1);
@@ -2245,7 +3324,8 @@ void main_game()
 					else
 						ImGui::Columns(2);
 
-					std::string dialogue_name = ws2s(person.person_name);
+					static std::string dialogue_name = "";
+					ws2s(person.person_name, dialogue_name);
 
 					if (dialogue_name == "NONE")
 						dialogue_name = "";
@@ -2256,7 +3336,8 @@ void main_game()
 					if (ImGui::InputText("##CHARACTER4DIALOGUENAME", &dialogue_name))
 						person.person_name = s2ws(dialogue_name);
 
-					std::string dialogue_text = ws2s(person.talking_text);
+					static std::string dialogue_text = "";
+					ws2s(person.talking_text, dialogue_text);
 
 					if (dialogue_text == "NONE")
 						dialogue_text = "";
@@ -2279,18 +3360,18 @@ void main_game()
 					if (advanced_scenes)
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
+						scene_textures_changed |= texture_selector(LANG_W(L"Left body texture", L"Òåêñòóðà ëåâîé ÷àñòè òåëà"), scenario, person.person_texture_left);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
+						scene_textures_changed |= texture_selector(LANG_W(L"Right body texture", L"Òåêñòóðà ïðàâîé ÷àñòè òåëà"), scenario, person.person_texture_right);
 
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
+						scene_textures_changed |= texture_selector(LANG_W(L"Head texture", L"Òåêñòóðà ãîëîâû"), scenario, person.person_texture_head);
 					}
 					else
 					{
 						ImGui::NextColumn();
-						texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
+						scene_textures_changed |= texture_selector(LANG_W(L"Body texture", L"Òåêñòóðà òåëà"), scenario, person.person_texture);
 					}
 
 					ImGui::Columns(1);
@@ -2305,7 +3386,8 @@ void main_game()
 					{
 						ScenarioDialogueSceneButton_t& button = scene.button1;
 
-						std::string button_name = ws2s(button.button_name);
+						static std::string button_name = "";
+						ws2s(button.button_name, button_name);
 
 						if (button_name == "NONE")
 							button_name = "";
@@ -2327,7 +3409,8 @@ void main_game()
 					{
 						ScenarioDialogueSceneButton_t& button = scene.button2;
 
-						std::string button_name = ws2s(button.button_name);
+						static std::string button_name = "";
+						ws2s(button.button_name, button_name);
 
 						if (button_name == "NONE")
 							button_name = "";
@@ -2349,7 +3432,8 @@ void main_game()
 					{
 						ScenarioDialogueSceneButton_t& button = scene.button3;
 
-						std::string button_name = ws2s(button.button_name);
+						static std::string button_name = "";
+						ws2s(button.button_name, button_name);
 
 						if (button_name == "NONE")
 							button_name = "";
@@ -2371,7 +3455,8 @@ void main_game()
 					{
 						ScenarioDialogueSceneButton_t& button = scene.button4;
 
-						std::string button_name = ws2s(button.button_name);
+						static std::string button_name = "";
+						ws2s(button.button_name, button_name);
 
 						if (button_name == "NONE")
 							button_name = "";
@@ -2403,861 +3488,1053 @@ void main_game()
 
 	scene.main_character.person_name = main_character_name;
 
-	ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.background_texture, scenario), ImVec2(0, 0), ImGui::GetIO().DisplaySize);
-
-	if (advanced_scenes && scene.background_overlay_texture != L"NONE")
-		ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.background_overlay_texture, scenario), ImVec2(0, 0), ImGui::GetIO().DisplaySize);
-
-	if (scene.background_music != L"NONE")
+	if (scenario_editor)
 	{
-		if (current_playing_music != scene.background_music)
+		scene.for_each_button(resolve_button_scenario);
+
+		if (scene_textures_changed)
 		{
-			stream_music(scene.background_music, music_stream);
-			current_playing_music = scene.background_music;
+			Scenario_t& texture_scenario = get_texture_scenario(scenario);
+
+			scene.resolve_textures(texture_scenario.texture_registry);
+
+			if (advanced_scenes)
+				resolve_character_composites(texture_scenario, scene);
+
+			mark_character_textures(texture_scenario, scene);
 		}
 	}
+
+	if (scenario_editor || !scene_render_plan.is_valid_for(selected_scenario, current_scenario_scene, ImGui::GetIO().DisplaySize, advanced_scenes))
+		build_scene_render_plan(scene_render_plan, selected_scenario, current_scenario_scene, scene);
+
+	update_scene_audio(scene);
+
+	for (int i = 0; i < scene_render_plan.quads.size(); i++)
+		add_scene_quad(scene_render_plan.quads.at(i), scenario);
+
+	if (advanced_scenes && scene.overlay_texture != L"NONE")
+	{
+		// overlay is drawn in size of source image, even if texture was downscaled
+		ScenarioTexture_t& texture = get_texture(scene.overlay_texture_handle, scenario);
+
+		add_scene_image(scene.overlay_texture_handle, scenario, ImVec2(ImGui::GetIO().DisplaySize.x / 2 - texture.width / 2, ImGui::GetIO().DisplaySize.y / 2 - texture.height / 2), ImVec2(ImGui::GetIO().DisplaySize.x / 2 + texture.width / 2, ImGui::GetIO().DisplaySize.y / 2 + texture.height / 2));
+	}
+
+	// scene buttons return early when scene changes, sprites of frame are drawn before them
+	scene_sprite_batcher.flush(ImGui::GetBackgroundDrawList());
+
+	const std::wstring& talking_text = scene_render_plan.talking_text;
+	const std::wstring& talking_name = scene_render_plan.talking_name;
+
+	ImVec2 position = scene_render_plan.box_position;
+	ImVec2 size = scene_render_plan.box_size;
+
+	if (talking_name != L"")
+	{
+		ImGui::PushFont(game_fonts.dialogue_name_font.font_data);
+
+		ImGui::SetNextWindowPos(scene_render_plan.name_position);
+		ImGui::SetNextWindowSize(scene_render_plan.name_size);
+
+		ImGui::Begin("##DIALOGUENAMEWINDOW", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_::ImGuiWindowFlags_NoBackground);
+		ImGui::GetWindowDrawList()->AddRectFilled(scene_render_plan.name_position, ImVec2(scene_render_plan.name_position.x + scene_render_plan.name_size.x, position.y + 2), ImColor(20, 20, 20, 135));
+
+		text_run_cache.text_unformatted(scene_render_plan.talking_name_utf8.c_str());
+
+		ImGui::End();
+
+		ImGui::PopFont();
+	}
+
+	ImGui::SetNextWindowPos(position);
+	ImGui::SetNextWindowSize(size);
+
+	ImGui::Begin("##DIALOGUETEXTWINDOW", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_::ImGuiWindowFlags_NoBackground);
+	ImGui::GetWindowDrawList()->AddRectFilled(position, ImVec2(position.x + size.x, position.y + size.y), ImColor(20, 20, 20, 135));
+
+	const TextLayout_t& text_layout = scene_render_plan.talking_text_layout;
+
+	// text animation, speed is characters per second at any frame rate
+	if (game_settings.animated_dialogue_text)
+	{
+		if (!game_menu_open)
+			dialogue_typewriter.advance(ImGui::GetIO().DeltaTime, float(game_settings.text_animation_speed), text_layout.characters);
+
+		// idle loop draws frame when next character is revealed, not on every display refresh
+		if (!game_menu_open && dialogue_typewriter.get_revealed() < text_layout.characters)
+			idle_rendering.wake_after(dialogue_typewriter.get_time_to_next_character(float(game_settings.text_animation_speed)));
+	}
 	else
+		dialogue_typewriter.reveal_all(text_layout.characters);
+
+	ImGui::PushFont(game_fonts.dialogue_text_font.font_data);
+
 	{
-		if (current_playing_music != L"")
+		FrameProfilerScope_t profiler_scope(frame_profiler, FRAME_PHASE_TEXT);
+		text_layout.draw(dialogue_typewriter.get_revealed(), text_run_cache);
+	}
+
+	ImGui::PopFont();
+
+	ImGui::End();
+
+	if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Escape)))
+	{
+		game_menu_open = !game_menu_open;
+
+		if (!game_menu_open)
+			save_menu_open = false;
+	}
+
+	if (scene.button1.is_present() || scene.button2.is_present() || scene.button3.is_present() || scene.button4.is_present())
+		button_menu_open = true;
+	else
+		button_menu_open = false;
+
+	bool clicked_button = false;
+
+	if (button_menu_open)
+	{
+		disable_input_on_scene = true;
+
+		prefetch_branch_scenarios(scene);
+
+		ImVec2 size = ImVec2(250, 120);
+		ImVec2 position = ImVec2(ImGui::GetIO().DisplaySize.x / 2 - size.x / 2, ImGui::GetIO().DisplaySize.y / 2 - size.y / 2);
+
+		ImGui::SetNextWindowSize(size);
+		ImGui::SetNextWindowPos(position);
+		ImGui::Begin("##GAMEBUTTONMENU", &save_menu_open, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar);
+
+		if (scene.button1.is_present())
 		{
-			BASS_ChannelStop(music_stream);
-			BASS_StreamFree(music_stream);
+			if (ImGui::Button(frame_arena.utf8(scene.button1.button_name), ImVec2(230, 20)))
+			{
+				button_menu_open = false;
+				clicked_button = true;
 
-			current_playing_music = L"";
-			paused_music = false;
+				if (scene.button1.has_scenario_action())
+				{
+					int scenario_idx = scene.button1.scenario_to_load_idx;
+
+					if (scenario_idx != -1)
+					{
+						cancel_branch_prefetch(scenario_idx);
+						exit_to_main_menu(true);
+
+						game_started = true;
+
+						selected_scenario = scenario_idx;
+						request_scenario_data(selected_scenario);
+
+						return;
+					}
+				}
+			}
+		}
+
+		if (scene.button2.is_present())
+		{
+			if (ImGui::Button(frame_arena.utf8(scene.button2.button_name), ImVec2(230, 20)))
+			{
+				button_menu_open = false;
+				clicked_button = true;
+
+				if (scene.button2.has_scenario_action())
+				{
+					int scenario_idx = scene.button2.scenario_to_load_idx;
+
+					if (scenario_idx != -1)
+					{
+						cancel_branch_prefetch(scenario_idx);
+						exit_to_main_menu(true);
+
+						game_started = true;
+
+						selected_scenario = scenario_idx;
+						request_scenario_data(selected_scenario);
+
+						return;
+					}
+				}
+			}
+		}
+
+		if (scene.button3.is_present())
+		{
+			if (ImGui::Button(frame_arena.utf8(scene.button3.button_name), ImVec2(230, 20)))
+			{
+				button_menu_open = false;
+				clicked_button = true;
+
+				if (scene.button3.has_scenario_action())
+				{
+					int scenario_idx = scene.button3.scenario_to_load_idx;
+
+					if (scenario_idx != -1)
+					{
+						cancel_branch_prefetch(scenario_idx);
+						exit_to_main_menu(true);
+
+						game_started = true;
+
+						selected_scenario = scenario_idx;
+						request_scenario_data(selected_scenario);
+
+						return;
+					}
+				}
+			}
+		}
+
+		if (scene.button4.is_present())
+		{
+			if (ImGui::Button(frame_arena.utf8(scene.button4.button_name), ImVec2(230, 20)))
+			{
+				if (scene.button4.has_scenario_action())
+				{
+					button_menu_open = false;
+					clicked_button = true;
+
+					if (scene.button4.has_scenario_action())
+					{
+						int scenario_idx = scene.button4.scenario_to_load_idx;
+
+						if (scenario_idx != -1)
+						{
+							cancel_branch_prefetch(scenario_idx);
+							exit_to_main_menu(true);
+
+							game_started = true;
+
+							selected_scenario = scenario_idx;
+							request_scenario_data(selected_scenario);
+
+							return;
+						}
+					}
+				}
+			}
 		}
+
+		ImGui::End();
 	}
 
-	if (scene.additional_scene_sound != L"NONE")
+	if (talking_name != L"" && talking_text != L"" && !recorded_dialogue)
 	{
-		if (!additional_channel_playing)
+		dialogue_history.push_back(std::wstring(talking_name + L": " + talking_text));
+		recorded_dialogue = true;
+	}
+
+	if (game_menu_open)
+	{
+		disable_input_on_scene = true;
+		button_menu_open = false;
+
+		if (!paused_music && current_playing_music != L"")
 		{
-			stream_music(scene.additional_scene_sound, additional_stream);
-			additional_channel_playing = true;
+			BASS_ChannelPause(music_stream);
+			paused_music = true;
 		}
+
+		main_game_menu(scenario);
 	}
 	else
 	{
-		if (additional_channel_playing)
+		video_settings_open = false;
+		audio_settings_open = false;
+		game_settings_open = false;
+
+		if (paused_music && current_playing_music != L"")
+		{
+			BASS_ChannelPlay(music_stream, FALSE);
+			paused_music = false;
+		}
+
+		if (!button_menu_open)
+			disable_input_on_scene = false;
+	}
+
+	if (!scenario_editor)
+	{
+		if (((!disable_input_on_scene && is_game_window_focused()) || clicked_button) && (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space), false) || ImGui::IsMouseClicked(0) || clicked_button) && (current_scenario_scene + 1) < scenario.scenes.size())
 		{
 			BASS_ChannelStop(additional_stream);
 			BASS_StreamFree(additional_stream);
 
-			additional_channel_playing = false;
+			additional_channel_playing = false;
+			recorded_dialogue = false;
+
+			dialogue_typewriter.restart();
+
+			current_scenario_scene++;
 		}
 	}
+}
 
-	int characters_count = 0;
-	int focused_character = -1;
+// frame time percentiles and average time of frame phases over last FRAME_PROFILER_HISTORY frames
+void frame_profiler_overlay()
+{
+	ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 10, 10), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+	ImGui::SetNextWindowBgAlpha(0.75f);
+	ImGui::Begin("##FPSCOUNTER", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_::ImGuiWindowFlags_AlwaysAutoResize);
 
-	if (scene.person1.is_valid_texture() || (advanced_scenes && scene.person1.is_valid_texture_left()))
-		characters_count++;
+	ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+	ImGui::Text("p50: %.2f  p95: %.2f  p99: %.2f ms", frame_profiler.percentile(0.5f), frame_profiler.percentile(0.95f), frame_profiler.percentile(0.99f));
 
-	if (scene.person2.is_valid_texture() || (advanced_scenes && scene.person2.is_valid_texture_left()))
-		characters_count++;
+	ImGui::Separator();
 
-	if (scene.person3.is_valid_texture() || (advanced_scenes && scene.person3.is_valid_texture_left()))
-		characters_count++;
+	float frame_ms = frame_profiler.average_frame();
 
-	if (scene.person4.is_valid_texture() || (advanced_scenes && scene.person4.is_valid_texture_left()))
-		characters_count++;
+	for (int i = 0; i < FRAME_PHASE_COUNT; i++)
+	{
+		float phase_ms = frame_profiler.average(FramePhase_t(i));
 
-	int character_texture_resolution_x = 400 * float(ImGui::GetIO().DisplaySize.x / 1920.0f);
-	int character_texture_resolution_x_adv = 960 * float(ImGui::GetIO().DisplaySize.x / 1920.0f);
+		char label[32];
+		snprintf(label, sizeof(label), "%.2f ms", phase_ms);
 
-	std::wstring talking_text = L"";
-	std::wstring talking_name = L"";
+		ImGui::Text(FRAME_PHASE_NAMES[i]);
+		ImGui::SameLine(160);
+		ImGui::ProgressBar(frame_ms > 0.0f ? phase_ms / frame_ms : 0.0f, ImVec2(150, 0), label);
+	}
 
-	if (scene.person1.talking)
-	{
-		if (talking_name != L"")
-			talking_name += L"&";
+	ImGui::Separator();
 
-		talking_name += scene.person1.person_name;
+	// of previous frame
+	ImGui::Text("Draw calls: %d", render_stats.draw_calls);
+	ImGui::Text("Textures: %d", render_stats.texture_switches);
 
-		if (talking_text == L"")
-			talking_text = scene.person1.talking_text;
+	ImGui::Text("Scene sprites: %d, draw calls: %d (%d unbatched)", scene_sprite_batcher.sprites_count, scene_sprite_batcher.draw_calls, scene_sprite_batcher.unbatched_draw_calls);
 
-		if (focused_character == -1)
-			focused_character = 1;
-	}
+	// main thread heap allocations, steady frames should have none
+	ImGui::Text("Allocations: %.1f per frame", frame_profiler.average_allocations());
+	ImGui::Text("Frame arena: %d KB, peak %d KB", int(frame_arena.used / 1024), int(frame_arena.peak / 1024));
 
-	if (scene.person2.talking)
-	{
-		if (talking_name != L"")
-			talking_name += L"&";
+	ImGui::Text("Text runs: %d, hits: %d, misses: %d", int(text_run_cache.runs.size()), text_run_cache.hits, text_run_cache.misses);
 
-		talking_name += scene.person2.person_name;
+	ImGui::Text("Resident: %d MB, hits: %.0f%%", int(texture_residency.resident_bytes / (1024 * 1024)), texture_residency.hit_rate() * 100.0f);
 
-		if (talking_text == L"")
-			talking_text = scene.person2.talking_text;
+	// time from input waking idle loop to frame on screen, idle loop without input and loading doesnt wake
+	ImGui::Text("Wake: %.1f ms, wakes by input: %d, workers: %d, timers: %d", idle_rendering.wake_latency_ms, int(idle_rendering.wakes), int(idle_rendering.worker_wakes), int(idle_rendering.timer_wakes));
 
-		if (focused_character == -1)
-			focused_character = 2;
-	}
+	if (ImGui::Button("Export CSV"))
+		frame_profiler.export_csv(L".\\game\\profiles\\" + get_profile_name());
 
-	if (scene.person3.talking)
-	{
-		if (talking_name != L"")
-			talking_name += L"&";
+	ImGui::End();
+}
 
-		talking_name += scene.person3.person_name;
+void game_render()
+{
+	FrameProfilerScope_t profiler_scope(frame_profiler, FRAME_PHASE_GAME_LAYOUT);
 
-		if (talking_text == L"")
-			talking_text = scene.person3.talking_text;
+	ImGui::PushFont(game_fonts.main_menu_font.font_data);
 
-		if (focused_character == -1)
-			focused_character = 3;
-	}
+	frame_profiler.begin(FRAME_PHASE_AUDIO);
 
-	if (scene.person4.talking)
-	{
-		if (talking_name != L"")
-			talking_name += L"&";
+	float music_volume = float(float(audio_settings.music_volume) / float(100.0f));
+	BASS_ChannelSetAttribute(music_stream, BASS_ATTRIB_VOL, music_volume);
+
+	float sound_volume = float(float(audio_settings.sound_volume) / float(100.0f));
+	BASS_ChannelSetAttribute(additional_stream, BASS_ATTRIB_VOL, sound_volume);
 
-		talking_name += scene.person4.person_name;
+	frame_profiler.end();
 
-		if (talking_text == L"")
-			talking_text = scene.person4.talking_text;
+	if (paused_music && current_playing_music == L"")
+		paused_music = false;
 
-		if (focused_character == -1)
-			focused_character = 4;
-	}
+	if (game_settings.show_fps_counter)
+		frame_profiler_overlay();
 
-	if (scene.main_character.talking)
+	if (!game_started)
 	{
-		if (talking_name != L"")
-			talking_name += L"&";
+		if (current_playing_music != L"menu_background")
+		{
+			stream_music(L"menu_background", music_stream);
+			current_playing_music = L"menu_background";
+		}
 
-		talking_name += scene.main_character.person_name;
+		if (additional_channel_playing)
+		{
+			BASS_ChannelStop(additional_stream);
+			BASS_StreamFree(additional_stream);
 
-		if (talking_text == L"")
-			talking_text = scene.main_character.talking_text;
+			additional_channel_playing = false;
+		}
 
-		focused_character = -1;
-	}
+#ifndef DCS_OPENGL
+		ImGui::GetBackgroundDrawList()->AddImage(game_menu_data.main_menu_background.image_data, ImVec2(0, 0), ImGui::GetIO().DisplaySize);
+#else
+		ImGui::GetBackgroundDrawList()->AddImage(convertGLtoImTexture(game_menu_data.main_menu_background.image_data.getNativeHandle()), ImVec2(0, 0), ImGui::GetIO().DisplaySize);
+#endif
 
-	int drawn_characters = 0;
-	ImVec2 next_position = ImVec2(((ImGui::GetIO().DisplaySize.x - ((character_texture_resolution_x_adv - (character_texture_resolution_x_adv / (characters_count < 4 ? 3 : 2.4f))) * characters_count))) / 2 - (character_texture_resolution_x_adv / (characters_count < 4 ? 5 : 8)), 120 * float(ImGui::GetIO().DisplaySize.y / 1080.0f));
+		ImVec2 window_size = ImVec2(250, ImGui::GetIO().DisplaySize.y - 40);
+		ImVec2 window_pos = ImVec2(20, 20);
 
-	// characters rendering
-	if (scene.person1.is_valid_texture() || (advanced_scenes && scene.person1.is_valid_texture_left()))
-	{
-		if (advanced_scenes && scene.person1.is_valid_texture_left())
-		{
-			ImVec2 position = next_position;
-			ImVec2 size = ImVec2(character_texture_resolution_x_adv, ImGui::GetIO().DisplaySize.y - (120 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
+		ImGui::SetNextWindowSize(window_size);
+		ImGui::SetNextWindowPos(window_pos);
+		ImGui::Begin("##MAINMENU", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar);
 
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person1.person_texture_left, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+		settings_render_position = ImVec2(window_pos.x + window_size.x + 10, window_pos.y);
 
-			if (scene.person1.is_valid_texture_right())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person1.person_texture_right, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+		ImGui::Image(game_menu_data.game_logo.image_data, ImVec2(230, 120));
 
-			if (scene.person1.is_valid_texture_head())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person1.person_texture_head, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+		ImGui::Spacing();
+		ImGui::Separator();
+		ImGui::Spacing();
 
-			next_position = ImVec2(position.x + (character_texture_resolution_x_adv - (character_texture_resolution_x_adv / (characters_count < 4 ? 3 : 2))), position.y);
-		}
-		else
+		if (select_scenario)
 		{
-			ImVec2 position = ImVec2((ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x / 2), 170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f));
+			if (ImGui::Button("<", ImVec2(230, 20)))
+				select_scenario = false;
 
-			if (characters_count == 2)
-				position.x = (ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x + (character_texture_resolution_x * drawn_characters));
-			else if (characters_count == 3)
-				position.x = ((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + (character_texture_resolution_x / 2)) + (drawn_characters * character_texture_resolution_x));
-			else if (characters_count == 4)
-				position.x = (((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + character_texture_resolution_x)) + (drawn_characters * character_texture_resolution_x));
+#ifndef DCS_STORY_GAME
+			ImGui::Text(LANG(L"Select scenario", L"Âûáåðèòå ñöåíàðèé"));
 
-			ImVec2 size = ImVec2(character_texture_resolution_x + 50, ImGui::GetIO().DisplaySize.y - (170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
+			ImGui::SetNextItemWidth(230);
+			if (ImGui::BeginListBox("##Scenario selector"))
+			{
+				for (int i = 0; i < scenario_names.size(); i++)
+				{
+					if (ImGui::Selectable(scenario_names.at(i).c_str(), selected_scenario == i))
+						selected_scenario = i;
+				}
 
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person1.person_texture, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
-		}
+				ImGui::EndListBox();
+			}
+#endif
 
-		drawn_characters++;
-	}
+#ifdef DCS_STORY_GAME
+			selected_scenario = find_scenario_index(L"main.sc");
+#endif
 
-	if (scene.person2.is_valid_texture() || (advanced_scenes && scene.person2.is_valid_texture_left()))
-	{
-		if (advanced_scenes && scene.person2.is_valid_texture_left())
-		{
-			ImVec2 position = next_position;
-			ImVec2 size = ImVec2(character_texture_resolution_x_adv, ImGui::GetIO().DisplaySize.y - (120 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
+			if (scenario_editor)
+			{
+				ImGui::Spacing();
+				ImGui::Separator();
+				ImGui::Spacing();
+
+				static char scenario_name[64];
+				ImGui::Text(LANG(L"Enter new scenario name", L"Ââåäèòå íàçâàíèå íîâîãî ñöåíàðèÿ"));
 
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person2.person_texture_left, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+				ImGui::SetNextItemWidth(230);
+				ImGui::InputText("##Scenario name input", scenario_name, 64);
 
-			if (scene.person2.is_valid_texture_right())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person2.person_texture_right, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+				if (ImGui::Button(LANG(L"Create new scenario", L"Ñîçäàòü íîâûé ñöåíàðèé"), ImVec2(230, 20)))
+				{
+					create_new_scenario(s2ws(std::string(scenario_name)));
 
-			if (scene.person2.is_valid_texture_head())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person2.person_texture_head, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+					scenarios = load_scenarios(L".\\game\\scenarios", L".\\game\\textures", L".\\game\\sounds");
+					scenario_names = get_directory_files_name(".\\game\\scenarios", ".sc");
+				}
+			}
 
-			next_position = ImVec2(position.x + (character_texture_resolution_x_adv - (character_texture_resolution_x_adv / (characters_count < 4 ? 3 : 2))), position.y);
+			if (selected_scenario > -1)
+			{
+				ImGui::Spacing();
+				ImGui::Separator();
+				ImGui::Spacing();
+
+				static char player_name[32];
+				ImGui::Text(LANG(L"Enter player name", L"Ââåäèòå èìÿ èãðîêà"));
+
+				ImGui::SetNextItemWidth(230);
+				ImGui::InputText("##Player name input", player_name, 32);
+
+				if (std::string(player_name) != "" && std::string(player_name) != " ")
+				{
+					if (ImGui::Button(scenario_editor ? LANG(L"Edit", L"Ðåäàêòèðîâàòü") : LANG(L"Play", L"Èãðàòü"), ImVec2(230, 20)))
+					{
+						wchar_t WBuf[32];
+						mbstowcs(WBuf, player_name, 31);
+
+						main_character_name = std::wstring(WBuf);
+						scene_render_plan.invalidate();
+
+						game_started = true;
+
+						video_settings_open = false;
+						audio_settings_open = false;
+						game_settings_open = false;
+					}
+				}
+			}
 		}
-		else
+		else if (select_save)
 		{
-			ImVec2 position = ImVec2((ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x / 2), 170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f));
+			if (ImGui::Button("<", ImVec2(230, 20)))
+				select_save = false;
 
-			if (characters_count == 2)
-				position.x = (ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x + (character_texture_resolution_x * drawn_characters));
-			else if (characters_count == 3)
-				position.x = ((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + (character_texture_resolution_x / 2)) + (drawn_characters * character_texture_resolution_x));
-			else if (characters_count == 4)
-				position.x = (((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + character_texture_resolution_x)) + (drawn_characters * character_texture_resolution_x));
+			ImGui::Text(LANG(L"Select save", L"Âûáåðèòå ñîõðàíåíèå"));
 
-			ImVec2 size = ImVec2(character_texture_resolution_x + 50, ImGui::GetIO().DisplaySize.y - (170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
+			ImGui::SetNextItemWidth(230);
+			if (ImGui::BeginListBox("##Scenario save"))
+			{
+				for (int i = 0; i < save_names.size(); i++)
+				{
+					if (ImGui::Selectable(save_names.at(i).c_str(), selected_save == i))
+						selected_save = i;
+				}
 
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person2.person_texture, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
-		}
+				ImGui::EndListBox();
+			}
 
-		drawn_characters++;
-	}
+			if (ImGui::Button(LANG(L"Refresh list", L"Îáíîâèòü ñïèñîê"), ImVec2(230, 20)))
+			{
+				saves = get_directory_files_name_w(L".\\game\\saves", L".savegame");
+				save_names = get_directory_files_name(".\\game\\saves", ".savegame");
+			}
 
-	if (scene.person3.is_valid_texture() || (advanced_scenes && scene.person3.is_valid_texture_left()))
-	{
-		if (advanced_scenes && scene.person3.is_valid_texture_left())
-		{
-			ImVec2 position = next_position;
-			ImVec2 size = ImVec2(character_texture_resolution_x_adv, ImGui::GetIO().DisplaySize.y - (120 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
+			if (selected_save > -1)
+			{
+				ImGui::Spacing();
+				ImGui::Separator();
+				ImGui::Spacing();
+
+				if (ImGui::Button(LANG(L"Play", L"Èãðàòü"), ImVec2(230, 20)))
+				{
+					GameSave_t save;
 
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person3.person_texture_left, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+					if (load_save(saves.at(selected_save), save) && find_scenario_index(save.scenario_name) != -1)
+					{
+						main_character_name = save.player_name;
+						scene_render_plan.invalidate();
 
-			if (scene.person3.is_valid_texture_right())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person3.person_texture_right, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+						selected_scenario = find_scenario_index(save.scenario_name);
+						current_scenario_scene = save.scenario_scene;
 
-			if (scene.person3.is_valid_texture_head())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person3.person_texture_head, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+						game_started = true;
 
-			next_position = ImVec2(position.x + (character_texture_resolution_x_adv - (character_texture_resolution_x_adv / (characters_count < 4 ? 3 : 2))), position.y);
+						video_settings_open = false;
+						audio_settings_open = false;
+						game_settings_open = false;
+					}
+					else
+						MessageBoxW(GetForegroundWindow(), LANG_W(L"Failed to load save", L"Íå óäàëîñü çàãðóçèòü ñîõðàíåíèå"), LANG_W(L"Error", L"Îøèáêà"), 0);
+				}
+			}
 		}
 		else
 		{
-			ImVec2 position = ImVec2((ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x / 2), 170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f));
+			if (ImGui::Button(scenario_editor ? LANG(L"Edit scenario", L"Ðåäàêòèðîâàòü ñöåíàðèé") : LANG(L"Start new game", L"Íà÷àòü íîâóþ èãðó"), ImVec2(230, 20)))
+				select_scenario = true;
 
-			if (characters_count == 2)
-				position.x = (ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x + (character_texture_resolution_x * drawn_characters));
-			else if (characters_count == 3)
-				position.x = ((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + (character_texture_resolution_x / 2)) + (drawn_characters * character_texture_resolution_x));
-			else if (characters_count == 4)
-				position.x = (((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + character_texture_resolution_x)) + (drawn_characters * character_texture_resolution_x));
+			if (!scenario_editor)
+			{
+				if (ImGui::Button(LANG(L"Load save", L"Çàãðóçèòü ñîõðàíåíèå"), ImVec2(230, 20)))
+					select_save = true;
+			}
+
+			ImGui::Spacing();
+			ImGui::Separator();
+			ImGui::Spacing();
 
-			ImVec2 size = ImVec2(character_texture_resolution_x + 50, ImGui::GetIO().DisplaySize.y - (170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
+			if (ImGui::Button(LANG(L"Video settings", L"Íàñòðîéêè âèäåî"), ImVec2(230, 20)))
+				video_settings_open = !video_settings_open;
+
+			if (ImGui::Button(LANG(L"Audio settings", L"Íàñòðîéêè çâóêà"), ImVec2(230, 20)))
+				audio_settings_open = !audio_settings_open;
+
+			if (ImGui::Button(LANG(L"Game settings", L"Íàñòðîéêè èãðû"), ImVec2(230, 20)))
+				game_settings_open = !game_settings_open;
+
+			if (wcsstr(GetCommandLineW(), L"-skid1337"))
+			{
+				if (!add_start_scene && ImGui::Button("Click me!", ImVec2(230, 20)))
+					add_start_scene = true;
+			}
+
+			ImGui::Spacing();
+			ImGui::Separator();
+			ImGui::Spacing();
 
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person3.person_texture, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+			if (ImGui::Button(LANG(L"Quit game", L"Âûõîä èç èãðû"), ImVec2(230, 20)))
+				request_quit();
 		}
 
-		drawn_characters++;
-	}
+		ImGui::End();
 
-	if (scene.person4.is_valid_texture() || (advanced_scenes && scene.person4.is_valid_texture_left()))
+		button_menu_open = false;
+	}
+	else
 	{
-		if (advanced_scenes && scene.person4.is_valid_texture_left())
-		{
-			ImVec2 position = next_position;
-			ImVec2 size = ImVec2(character_texture_resolution_x_adv, ImGui::GetIO().DisplaySize.y - (120 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
-
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person4.person_texture_left, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+		select_scenario = false;
+		select_save = false;
 
-			if (scene.person4.is_valid_texture_right())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person4.person_texture_right, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+		// load scenario if it wasnt loaded during game init, headless runs wait for it so frames dont depend on load speed
+		if (headless)
+			load_scenario_data(selected_scenario);
+		else
+			request_scenario_data(selected_scenario);
 
-			if (scene.person4.is_valid_texture_head())
-				ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person4.person_texture_head, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+		if (selected_scenario >= 0 && selected_scenario < scenarios.size() && !scenarios.at(selected_scenario).loaded)
+		{
+			const char* loading_text = LANG(L"Loading...", L"Çàãðóçêà...");
 
-			next_position = ImVec2(position.x + (character_texture_resolution_x_adv - (character_texture_resolution_x_adv / (characters_count < 4 ? 3 : 2))), position.y);
+			ImVec2 text_size = ImGui::CalcTextSize(loading_text);
+			ImGui::GetForegroundDrawList()->AddText(ImVec2(ImGui::GetIO().DisplaySize.x / 2 - text_size.x / 2, ImGui::GetIO().DisplaySize.y / 2 - text_size.y / 2), IM_COL32_WHITE, loading_text);
 		}
 		else
 		{
-			ImVec2 position = ImVec2((ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x / 2), 170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f));
-
-			if (characters_count == 2)
-				position.x = (ImGui::GetIO().DisplaySize.x / 2 - character_texture_resolution_x + (character_texture_resolution_x * drawn_characters));
-			else if (characters_count == 3)
-				position.x = ((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + (character_texture_resolution_x / 2)) + (drawn_characters * character_texture_resolution_x));
-			else if (characters_count == 4)
-				position.x = (((ImGui::GetIO().DisplaySize.x / 2) - (character_texture_resolution_x + character_texture_resolution_x)) + (drawn_characters * character_texture_resolution_x));
+			static int prioritized_scenario = -1;
 
-			ImVec2 size = ImVec2(character_texture_resolution_x + 50, ImGui::GetIO().DisplaySize.y - (170 * float(ImGui::GetIO().DisplaySize.y / 1080.0f)));
+			if (prioritized_scenario != selected_scenario)
+			{
+				texture_loader.prioritize(get_texture_scenario_index(selected_scenario));
+				prioritized_scenario = selected_scenario;
+			}
 
-			ImGui::GetBackgroundDrawList()->AddImage(find_texture(scene.person4.person_texture, scenario), position, ImVec2(position.x + size.x, position.y + size.y));
+			main_game();
 		}
-
-		drawn_characters++;
 	}
 
-	ImVec2 position = ImVec2(200, (ImGui::GetIO().DisplaySize.y - ImGui::GetIO().DisplaySize.y / 4.0f));
-	ImVec2 size = ImVec2(ImGui::GetIO().DisplaySize.x - 400, ImGui::GetIO().DisplaySize.y / 4.0f - 50);
+	if (video_settings_open)
+		video_settings_menu();
+
+	if (audio_settings_open)
+		audio_settings_menu();
+
+	if (game_settings_open)
+		game_settings_menu();
+}
 
-	size.y = ImGui::CalcTextSize(utf8(talking_name.c_str())).y * 6 + 55;
-	position.y = ImGui::GetIO().DisplaySize.y - 20 - size.y;
+bool intro_render()
+{
+	FrameProfilerScope_t profiler_scope(frame_profiler, FRAME_PHASE_INTRO);
 
-	if (talking_name == scene.main_character.person_name && talking_text.at(scene.main_character.talking_text.length() - 1) == L'@')
-	{
-		talking_text.erase(scene.main_character.talking_text.length() - 1);
-		talking_name = L"";
-	}
+	static float delta_time_factor = 1.0f;
 
-	if (talking_text.find(L"@MAINCHARACTERNAME") != std::wstring::npos)
-	{
-		std::vector<std::wstring> splitted_str = split_string(talking_text, L'@');
-		talking_text = splitted_str.at(0) + main_character_name + splitted_str.at(1).substr(17);
-	}
+	if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)))
+		delta_time_factor = 8.0f;
 
-	if (talking_name != L"")
+	if (!rendered_intro)
 	{
-		ImGui::PushFont(game_fonts.dialogue_name_font.font_data);
+		idle_rendering.keep_awake();
 
-		ImGui::SetNextWindowPos(ImVec2(position.x + 30, position.y - ImGui::CalcTextSize(utf8(talking_name.c_str())).y - 20));
-		ImGui::SetNextWindowSize(ImVec2(ImGui::CalcTextSize(utf8(talking_name.c_str())).x + 20, ImGui::CalcTextSize(utf8(talking_name.c_str())).y + 22));
-
-		ImGui::Begin("##DIALOGUENAMEWINDOW", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_::ImGuiWindowFlags_NoBackground);
-		ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(position.x + 30, position.y - ImGui::CalcTextSize(utf8(talking_name.c_str())).y - 20), ImVec2(position.x + 30 + ImGui::CalcTextSize(utf8(talking_name.c_str())).x + 20, position.y + 2), ImColor(20, 20, 20, 135));
+		intro_alpha_fade_out = ImLerp(intro_alpha_fade_out, 3.0f, ImGui::GetIO().DeltaTime * (delta_time_factor - 0.6f));
 
-		ImGui::Text(utf8(talking_name.c_str()));
+		if (intro_alpha_fade_out > 2.60f)
+			intro_alpha_fade_in = ImLerp(intro_alpha_fade_in, 3.0f, ImGui::GetIO().DeltaTime * delta_time_factor);
 
-		ImGui::End();
+#ifndef DCS_OPENGL
+		ImGui::GetForegroundDrawList()->AddImage(game_menu_data.intro_logo.image_data, ImVec2(ImGui::GetIO().DisplaySize.x / 2 - 150, ImGui::GetIO().DisplaySize.y / 2 - 180), ImVec2(ImGui::GetIO().DisplaySize.x / 2 + 150, ImGui::GetIO().DisplaySize.y / 2 + 120), ImVec2(0, 0), ImVec2(1, 1), ImColor(255, 255, 255, int(255 * ImClamp(intro_alpha_fade_out - intro_alpha_fade_in, 0.0f, 1.0f))));
+#else
+		ImGui::GetForegroundDrawList()->AddImage(convertGLtoImTexture(game_menu_data.intro_logo.image_data.getNativeHandle()), ImVec2(ImGui::GetIO().DisplaySize.x / 2 - 150, ImGui::GetIO().DisplaySize.y / 2 - 180), ImVec2(ImGui::GetIO().DisplaySize.x / 2 + 150, ImGui::GetIO().DisplaySize.y / 2 + 120), ImVec2(0, 0), ImVec2(1, 1), ImColor(255, 255, 255, int(255 * ImClamp(intro_alpha_fade_out - intro_alpha_fade_in, 0.0f, 1.0f))));
+#endif
+		ImGui::GetForegroundDrawList()->AddText(game_fonts.intro_font.font_data, game_fonts.intro_font.font_size, ImVec2(ImGui::GetIO().DisplaySize.x / 2 - 150, ImGui::GetIO().DisplaySize.y / 2 + 120), ImColor(255, 255, 255, int(255 * ImClamp(intro_alpha_fade_out - intro_alpha_fade_in, 0.0f, 1.0f))), frame_arena.utf8(game_info.game_developer));
 
-		ImGui::PopFont();
+		if (intro_alpha_fade_in > 2.8f)
+			rendered_intro = true;
 	}
 
-	ImGui::SetNextWindowPos(position);
-	ImGui::SetNextWindowSize(size);
+	return rendered_intro;
+}
 
-	ImGui::Begin("##DIALOGUETEXTWINDOW", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_::ImGuiWindowFlags_NoBackground);
-	ImGui::GetWindowDrawList()->AddRectFilled(position, ImVec2(position.x + size.x, position.y + size.y), ImColor(20, 20, 20, 135));
+#define DCS_DEBUG
 
-	// text animation
-	if (game_settings.animated_dialogue_text)
-	{
-		if (!game_menu_open)
-			dialogue_text_animation_lerp = ImLerp(dialogue_text_animation_lerp, 1.0f, ImGui::GetIO().DeltaTime * float(float(game_settings.text_animation_speed) / 100.0f));
+void setup_imgui(ImGuiIO& io)
+{
+	io.IniFilename = NULL;
+	io.ConfigFlags |= ImGuiConfigFlags_NavEnableSetMousePos;
 
-		if (dialogue_added_text_symbols < talking_text.length() && dialogue_text_animation_lerp > 0.01f)
-		{
-			dialogue_text_to_render += talking_text.at(dialogue_added_text_symbols);
-			dialogue_added_text_symbols++;
-		}
+	ImGui::StyleColorsDCS_Dark();
 
-		if (dialogue_text_animation_lerp > 0.01f)
-			dialogue_text_animation_lerp = 0.0f;
-	}
-	else
-		dialogue_text_to_render = talking_text;
+	ImGui::GetStyle().WindowPadding = ImVec2(10, 10);
+	ImGui::GetStyle().WindowRounding = 2.0f;
 
-	ImGui::PushFont(game_fonts.dialogue_text_font.font_data);
-	ImGui::TextWrapped(utf8(dialogue_text_to_render.c_str()));
-	ImGui::PopFont();
+	ImGui::GetStyle().TabRounding = 2.0f;
+}
 
-	ImGui::End();
+int get_texture_worker_count()
+{
+	return std::thread::hardware_concurrency() > 1 ? int(std::thread::hardware_concurrency()) - 1 : 1;
+}
 
-	if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Escape)))
+// textures requested by frame are uploaded before it is drawn, so runs dont depend on decoding speed
+void wait_for_texture_loads()
+{
+	while (texture_loader.is_busy())
 	{
-		game_menu_open = !game_menu_open;
-
-		if (!game_menu_open)
-			save_menu_open = false;
+		process_texture_uploads(FLT_MAX);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
 	}
+}
 
-	if (scene.button1.is_present() || scene.button2.is_present() || scene.button3.is_present() || scene.button4.is_present())
-		button_menu_open = true;
-	else
-		button_menu_open = false;
-
-	bool clicked_button = false;
+// imgui context and game assets without window, rasterize enables CPU copies of textures for software_rasterizer
+ImGuiIO& start_headless(ImVec2 display_size, bool rasterize)
+{
+	software_rasterizer.enabled = rasterize;
 
-	if (button_menu_open)
-	{
-		disable_input_on_scene = true;
+#ifndef DCS_OPENGL
+	software_rasterizer.linear_filtering = true;
+#endif
 
-		ImVec2 size = ImVec2(250, 120);
-		ImVec2 position = ImVec2(ImGui::GetIO().DisplaySize.x / 2 - size.x / 2, ImGui::GetIO().DisplaySize.y / 2 - size.y / 2);
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
 
-		ImGui::SetNextWindowSize(size);
-		ImGui::SetNextWindowPos(position);
-		ImGui::Begin("##GAMEBUTTONMENU", &save_menu_open, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar);
+	ImGuiIO& io = ImGui::GetIO();
 
-		if (scene.button1.is_present())
-		{
-			if (ImGui::Button(utf8(scene.button1.button_name.c_str()), ImVec2(230, 20)))
-			{
-				button_menu_open = false;
-				clicked_button = true;
+	setup_imgui(io);
+	io.DisplaySize = display_size;
 
-				if (scene.button1.has_scenario_action())
-				{
-					int scenario_idx = find_scenario_index(scene.button1.button_scenario_to_load);
+	texture_loader.start(get_texture_worker_count(), 16);
+	scenario_loader.start(load_scenario_files);
 
-					if (scenario_idx != -1)
-					{
-						exit_to_main_menu(true);
+	if (software_rasterizer.enabled)
+		software_rasterizer.start(get_texture_worker_count());
 
-						game_started = true;
+	load_game_assets(io);
 
-						selected_scenario = scenario_idx;
-						load_scenario_data(selected_scenario);
+	// font atlas is only built, there is nothing to upload it to
+	unsigned char* font_pixels;
+	int font_width;
+	int font_height;
 
-						return;
-					}
-				}
-			}
-		}
+	io.Fonts->GetTexDataAsRGBA32(&font_pixels, &font_width, &font_height);
+	io.Fonts->SetTexID((ImTextureID)io.Fonts);
 
-		if (scene.button2.is_present())
-		{
-			if (ImGui::Button(utf8(scene.button2.button_name.c_str()), ImVec2(230, 20)))
-			{
-				button_menu_open = false;
-				clicked_button = true;
+	if (software_rasterizer.enabled)
+		software_rasterizer.set_texture(io.Fonts->TexID, font_width, font_height, font_pixels);
 
-				if (scene.button2.has_scenario_action())
-				{
-					int scenario_idx = find_scenario_index(scene.button2.button_scenario_to_load);
+	return io;
+}
 
-					if (scenario_idx != -1)
-					{
-						exit_to_main_menu(true);
+int stop_headless()
+{
+	ImGui::DestroyContext();
 
-						game_started = true;
+	software_rasterizer.shutdown();
+	scenario_loader.shutdown();
+	texture_loader.shutdown();
 
-						selected_scenario = scenario_idx;
-						load_scenario_data(selected_scenario);
+	if (tracer.enabled)
+		tracer.write(L".\\game\\profiles\\" + get_trace_name());
 
-						return;
-					}
-				}
-			}
-		}
+	BASS_Free();
 
-		if (scene.button3.is_present())
-		{
-			if (ImGui::Button(utf8(scene.button3.button_name.c_str()), ImVec2(230, 20)))
-			{
-				button_menu_open = false;
-				clicked_button = true;
+	return 0;
+}
 
-				if (scene.button3.has_scenario_action())
-				{
-					int scenario_idx = find_scenario_index(scene.button3.button_scenario_to_load);
+// -headless: runs game frames without window and GPU with script from game\config\headless_script.txt (see
+// HeadlessRun_t) and writes counts of draw data and CPU time of every frame to game\profiles
+int run_headless()
+{
+	HeadlessRun_t run;
 
-					if (scenario_idx != -1)
-					{
-						exit_to_main_menu(true);
+	run.display_size = ImVec2(video_settings.screen_width, video_settings.screen_height);
+	run.load_script(L".\\game\\config\\headless_script.txt");
 
-						game_started = true;
+	// textures keep their pixels only if some frame is drawn
+	ImGuiIO& io = start_headless(run.display_size, run.has_command("screenshot"));
 
-						selected_scenario = scenario_idx;
-						load_scenario_data(selected_scenario);
+	for (int frame = 0; frame < run.frames; frame++)
+	{
+		frame_profiler.begin_frame();
 
-						return;
-					}
-				}
-			}
-		}
+		io.DeltaTime = run.delta_time;
 
-		if (scene.button4.is_present())
-		{
-			if (ImGui::Button(utf8(scene.button4.button_name.c_str()), ImVec2(230, 20)))
-			{
-				if (scene.button4.has_scenario_action())
-				{
-					button_menu_open = false;
-					clicked_button = true;
+		run.release_input(io);
 
-					if (scene.button4.has_scenario_action())
-					{
-						int scenario_idx = find_scenario_index(scene.button4.button_scenario_to_load);
+		bool screenshot = false;
 
-						if (scenario_idx != -1)
-						{
-							exit_to_main_menu(true);
+		run.for_each_event(frame, [&](HeadlessInputEvent_t& event)
+		{
+			if (event.command == "screenshot")
+				screenshot = true;
 
-							game_started = true;
+			if (run.apply_input(io, event) || event.command != "start")
+				return;
 
-							selected_scenario = scenario_idx;
-							load_scenario_data(selected_scenario);
+			int scenario_idx = find_scenario_index(s2ws(event.name));
 
-							return;
-						}
-					}
-				}
-			}
-		}
+			if (scenario_idx == -1)
+				return;
 
-		ImGui::End();
-	}
+			selected_scenario = scenario_idx;
+			current_scenario_scene = -1;
 
-	if (advanced_scenes && scene.overlay_texture != L"NONE")
-	{
-#ifndef DCS_OPENGL
-		ID3D11ShaderResourceView* texture = find_texture(scene.overlay_texture, scenario);
+			main_character_name = s2ws(event.text);
+			scene_render_plan.invalidate();
 
-		ID3D11Resource* src;
-		texture->GetResource(&src);
+			rendered_intro = true;
+			game_started = true;
+		});
 
-		ID3D11Texture2D* t2d;
-		src->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&t2d));
+		frame_arena.reset();
+		text_run_cache.end_frame();
+		ImGui::NewFrame();
 
-		D3D11_TEXTURE2D_DESC desc;
-		t2d->GetDesc(&desc);
+		frame_profiler.begin(FRAME_PHASE_TEXTURE_STREAMING);
+		process_scenario_loads();
+		update_texture_residency();
+		wait_for_texture_loads();
+		frame_profiler.end();
 
-		ImGui::GetBackgroundDrawList()->AddImage(texture, ImVec2(ImGui::GetIO().DisplaySize.x / 2 - desc.Width / 2, ImGui::GetIO().DisplaySize.y / 2 - desc.Height / 2), ImVec2(ImGui::GetIO().DisplaySize.x / 2 + desc.Width / 2, ImGui::GetIO().DisplaySize.y / 2 + desc.Height / 2));
-#else
-		sf::Texture& texture = find_texture_sf(scene.overlay_texture, scenario);
-		ImGui::GetBackgroundDrawList()->AddImage(convertGLtoImTexture(texture.getNativeHandle()), ImVec2(ImGui::GetIO().DisplaySize.x / 2 - texture.getSize().x / 2, ImGui::GetIO().DisplaySize.y / 2 - texture.getSize().y / 2), ImVec2(ImGui::GetIO().DisplaySize.x / 2 + texture.getSize().x / 2, ImGui::GetIO().DisplaySize.y / 2 + texture.getSize().y / 2));
-#endif
-	}
+		if (intro_render())
+			game_render();
 
-	if (talking_name != L"" && talking_text != L"" && !recorded_dialogue)
-	{
-		dialogue_history.push_back(std::wstring(talking_name + L": " + talking_text));
-		recorded_dialogue = true;
-	}
+		frame_profiler.begin(FRAME_PHASE_IMGUI_RENDER);
 
-	if (game_menu_open)
-	{
-		disable_input_on_scene = true;
-		button_menu_open = false;
+		ImGui::Render();
+		render_stats.collect(ImGui::GetDrawData());
 
-		if (!paused_music && current_playing_music != L"")
-		{
-			BASS_ChannelPause(music_stream);
-			paused_music = true;
-		}
+		frame_profiler.end();
+		frame_profiler.end_frame();
 
-		main_game_menu(scenario);
-	}
-	else
-	{
-		video_settings_open = false;
-		audio_settings_open = false;
-		game_settings_open = false;
+		run.add_frame(frame_profiler.last_sample(), render_stats);
 
-		if (paused_music && current_playing_music != L"")
+		// not part of frame time, GPU draws frames of game
+		if (screenshot)
 		{
-			BASS_ChannelPlay(music_stream, FALSE);
-			paused_music = false;
+			software_rasterizer.render(ImGui::GetDrawData());
+			software_rasterizer.write_png(ws2s(L".\\game\\screenshots\\headless " + std::to_wstring(frame) + L" " + get_screenshot_name()));
 		}
-
-		if (!button_menu_open)
-			disable_input_on_scene = false;
 	}
 
-	if (!scenario_editor)
-	{
-		if (((!disable_input_on_scene && GetForegroundWindow() == hWnd) || clicked_button) && (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space), false) || ImGui::IsMouseClicked(0) || clicked_button) && (current_scenario_scene + 1) < scenario.scenes.size())
-		{
-			BASS_ChannelStop(additional_stream);
-			BASS_StreamFree(additional_stream);
-
-			additional_channel_playing = false;
-			recorded_dialogue = false;
-
-			dialogue_text_to_render = L"";
-			dialogue_added_text_symbols = 0;
+	run.write_csv(L".\\game\\profiles\\headless " + get_profile_name());
 
-			dialogue_text_animation_lerp = 0.0f;
-
-			current_scenario_scene++;
-		}
-	}
+	return stop_headless();
 }
 
-void game_render()
+// builds frame of current scene, again while textures it requested are loading
+void build_scene_frame(ImGuiIO& io)
 {
-	ImGui::PushFont(game_fonts.main_menu_font.font_data);
+	// first frame of new imgui windows isnt drawn
+	const int min_frames = 2;
+	const int max_frames = 8;
 
-	float music_volume = float(float(audio_settings.music_volume) / float(100.0f));
-	BASS_ChannelSetAttribute(music_stream, BASS_ATTRIB_VOL, music_volume);
+	for (int frame = 0; frame < max_frames; frame++)
+	{
+		io.DeltaTime = 1.0f / 60.0f;
 
-	float sound_volume = float(float(audio_settings.sound_volume) / float(100.0f));
-	BASS_ChannelSetAttribute(additional_stream, BASS_ATTRIB_VOL, sound_volume);
+		frame_arena.reset();
+		text_run_cache.end_frame();
+		ImGui::NewFrame();
 
-	if (paused_music && current_playing_music == L"")
-		paused_music = false;
+		update_texture_residency();
+		wait_for_texture_loads();
 
-	if (game_settings.show_fps_counter)
-	{
-		ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 105, 10));
-		ImGui::SetNextWindowSize(ImVec2(95, 35));
-		ImGui::Begin("##FPSCOUNTER", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_::ImGuiWindowFlags_NoBackground);
+		game_render();
 
-		ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(ImGui::GetIO().DisplaySize.x - 105, 10), ImVec2(ImGui::GetIO().DisplaySize.x - 10, 45), ImColor(10, 10, 10, 190));
-		ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+		ImGui::Render();
 
-		ImGui::End();
+		if (frame + 1 >= min_frames && !texture_loader.is_busy())
+			break;
 	}
+}
 
-	if (!game_started)
-	{
-		if (current_playing_music != L"menu_background")
-		{
-			stream_music(L"menu_background", music_stream);
-			current_playing_music = L"menu_background";
-		}
-
-		if (additional_channel_playing)
-		{
-			BASS_ChannelStop(additional_stream);
-			BASS_StreamFree(additional_stream);
-
-			additional_channel_playing = false;
-		}
+// -render_scenes: draws every scene of every scenario to game\screenshots\scenes\<scenario>\<scene>.png, optionally at
+// -render_size=<width>x<height>. Game state is single threaded, so frames are built in scene order on this thread,
+// rasterizer tiles, texture decoding and PNG encoding are spread over all cores.
+int render_scenes()
+{
+	ImVec2 display_size = ImVec2(video_settings.screen_width, video_settings.screen_height);
 
-#ifndef DCS_OPENGL
-		ImGui::GetBackgroundDrawList()->AddImage(game_menu_data.main_menu_background.image_data, ImVec2(0, 0), ImGui::GetIO().DisplaySize);
-#else
-		ImGui::GetBackgroundDrawList()->AddImage(convertGLtoImTexture(game_menu_data.main_menu_background.image_data.getNativeHandle()), ImVec2(0, 0), ImGui::GetIO().DisplaySize);
-#endif
+	const wchar_t* render_size = wcsstr(GetCommandLineW(), L"-render_size=");
 
-		ImVec2 window_size = ImVec2(250, ImGui::GetIO().DisplaySize.y - 40);
-		ImVec2 window_pos = ImVec2(20, 20);
+	int width;
+	int height;
 
-		ImGui::SetNextWindowSize(window_size);
-		ImGui::SetNextWindowPos(window_pos);
-		ImGui::Begin("##MAINMENU", (bool*)0, ImGuiWindowFlags_::ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_::ImGuiWindowFlags_NoMove | ImGuiWindowFlags_::ImGuiWindowFlags_NoResize | ImGuiWindowFlags_::ImGuiWindowFlags_NoTitleBar);
+	if (render_size && swscanf(render_size, L"-render_size=%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+		display_size = ImVec2(width, height);
 
-		settings_render_position = ImVec2(window_pos.x + window_size.x + 10, window_pos.y);
+	ImGuiIO& io = start_headless(display_size, true);
 
-		ImGui::Image(game_menu_data.game_logo.image_data, ImVec2(230, 120));
+	// whole text and no overlays on every picture
+	game_settings.animated_dialogue_text = false;
+	game_settings.show_fps_counter = false;
 
-		ImGui::Spacing();
-		ImGui::Separator();
-		ImGui::Spacing();
+	main_character_name = L"Player";
 
-		if (select_scenario)
-		{
-			if (ImGui::Button("<", ImVec2(230, 20)))
-				select_scenario = false;
+	rendered_intro = true;
+	game_started = true;
 
-#ifndef DCS_STORY_GAME
-			ImGui::Text(LANG(L"Select scenario", L"Âûáåðèòå ñöåíàðèé"));
+	ImageWriter_t image_writer;
+	image_writer.start(get_texture_worker_count(), get_texture_worker_count() * 2);
 
-			ImGui::SetNextItemWidth(230);
-			if (ImGui::BeginListBox("##Scenario selector"))
-			{
-				for (int i = 0; i < scenario_names.size(); i++)
-				{
-					if (ImGui::Selectable(scenario_names.at(i).c_str(), selected_scenario == i))
-						selected_scenario = i;
-				}
+	CreateDirectoryW(L".\\game\\screenshots\\scenes\\", NULL);
 
-				ImGui::EndListBox();
-			}
-#endif
+	for (int i = 0; i < scenarios.size(); i++)
+	{
+		Scenario_t& scenario = scenarios.at(i);
 
-#ifdef DCS_STORY_GAME
-			selected_scenario = find_scenario_index(L"main.sc");
-#endif
+		std::wstring directory = L".\\game\\screenshots\\scenes\\" + std::wstring(get_filename_without_ext(scenario.file_name)) + L"\\";
+		CreateDirectoryW(directory.c_str(), NULL);
 
-			if (scenario_editor)
-			{
-				ImGui::Spacing();
-				ImGui::Separator();
-				ImGui::Spacing();
+		selected_scenario = i;
 
-				static char scenario_name[64];
-				ImGui::Text(LANG(L"Enter new scenario name", L"Ââåäèòå íàçâàíèå íîâîãî ñöåíàðèÿ"));
+		for (int c = 0; c < scenario.scenes.size(); c++)
+		{
+			current_scenario_scene = c;
 
-				ImGui::SetNextItemWidth(230);
-				ImGui::InputText("##Scenario name input", scenario_name, 64);
+			build_scene_frame(io);
 
-				if (ImGui::Button(LANG(L"Create new scenario", L"Ñîçäàòü íîâûé ñöåíàðèé"), ImVec2(230, 20)))
-				{
-					create_new_scenario(s2ws(std::string(scenario_name)));
+			software_rasterizer.render(ImGui::GetDrawData());
 
-					scenarios = load_scenarios(L".\\game\\scenarios", L".\\game\\textures", L".\\game\\sounds");
-					scenario_names = get_directory_files_name(".\\game\\scenarios", ".sc");
-				}
-			}
+			wchar_t file_name[32];
+			swprintf(file_name, 32, L"%05d.png", c);
 
-			if (selected_scenario > -1)
-			{
-				ImGui::Spacing();
-				ImGui::Separator();
-				ImGui::Spacing();
+			ImageWriteJob_t job;
 
-				static char player_name[32];
-				ImGui::Text(LANG(L"Enter player name", L"Ââåäèòå èìÿ èãðîêà"));
+			job.path = ws2s(directory + file_name);
+			job.width = software_rasterizer.width;
+			job.height = software_rasterizer.height;
+			job.pixels = std::move(software_rasterizer.pixels);
 
-				ImGui::SetNextItemWidth(230);
-				ImGui::InputText("##Player name input", player_name, 32);
+			image_writer.write(job);
+		}
+	}
 
-				if (std::string(player_name) != "" && std::string(player_name) != " ")
-				{
-					if (ImGui::Button(scenario_editor ? LANG(L"Edit", L"Ðåäàêòèðîâàòü") : LANG(L"Play", L"Èãðàòü"), ImVec2(230, 20)))
-					{
-						wchar_t WBuf[32];
-						mbstowcs(WBuf, player_name, 31);
+	image_writer.finish();
 
-						main_character_name = std::wstring(WBuf);
+	// pictures which couldnt be written are listed in game\profiles
+	std::ofstream file(L".\\game\\profiles\\render_scenes " + get_report_name(), std::ios::trunc);
 
-						game_started = true;
+	file << image_writer.written << " scenes written, " << image_writer.failed << " failed\n";
 
-						video_settings_open = false;
-						audio_settings_open = false;
-						game_settings_open = false;
-					}
-				}
-			}
-		}
-		else if (select_save)
-		{
-			if (ImGui::Button("<", ImVec2(230, 20)))
-				select_save = false;
+	for (int i = 0; i < image_writer.failed_paths.size(); i++)
+		file << "failed: " << image_writer.failed_paths.at(i) << "\n";
 
-			ImGui::Text(LANG(L"Select save", L"Âûáåðèòå ñîõðàíåíèå"));
+	file.close();
 
-			ImGui::SetNextItemWidth(230);
-			if (ImGui::BeginListBox("##Scenario save"))
-			{
-				for (int i = 0; i < save_names.size(); i++)
-				{
-					if (ImGui::Selectable(save_names.at(i).c_str(), selected_save == i))
-						selected_save = i;
-				}
+	stop_headless();
 
-				ImGui::EndListBox();
-			}
+	return image_writer.failed > 0 ? 1 : 0;
+}
 
-			if (ImGui::Button(LANG(L"Refresh list", L"Îáíîâèòü ñïèñîê"), ImVec2(230, 20)))
-			{
-				saves = get_directory_files_name_w(L".\\game\\saves", L".savegame");
-				save_names = get_directory_files_name(".\\game\\saves", ".savegame");
-			}
+// -atlas_benchmark: builds every scene of every scenario with character textures in atlases, then again with every
+// texture on its own as with -noatlas. Draw calls and texture switches of both are written to game\profiles.
+int run_atlas_benchmark()
+{
+	ImGuiIO& io = start_headless(ImVec2(video_settings.screen_width, video_settings.screen_height), false);
 
-			if (selected_save > -1)
-			{
-				ImGui::Spacing();
-				ImGui::Separator();
-				ImGui::Spacing();
+	game_settings.animated_dialogue_text = false;
+	game_settings.show_fps_counter = false;
 
-				if (ImGui::Button(LANG(L"Play", L"Èãðàòü"), ImVec2(230, 20)))
-				{
-					GameSave_t save;
+	main_character_name = L"Player";
 
-					if (load_save(saves.at(selected_save), save) && find_scenario_index(save.scenario_name) != -1)
-					{
-						main_character_name = save.player_name;
+	rendered_intro = true;
+	game_started = true;
 
-						selected_scenario = find_scenario_index(save.scenario_name);
-						current_scenario_scene = save.scenario_scene;
+	std::vector<RenderStats_t> stats[2];
 
-						game_started = true;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		// textures are loaded again, atlases are chosen when they are uploaded
+		if (pass > 0)
+		{
+			unload_game_images_and_textures();
+			create_placeholder_texture();
 
-						video_settings_open = false;
-						audio_settings_open = false;
-						game_settings_open = false;
-					}
-					else
-						MessageBoxW(GetForegroundWindow(), LANG_W(L"Failed to load save", L"Íå óäàëîñü çàãðóçèòü ñîõðàíåíèå"), LANG_W(L"Error", L"Îøèáêà"), 0);
-				}
-			}
+			for (int i = 0; i < scenarios.size(); i++)
+				load_scenario_data(i);
 		}
-		else
+
+		texture_atlases_enabled = pass == 0;
+
+		for (int i = 0; i < scenarios.size(); i++)
 		{
-			if (ImGui::Button(scenario_editor ? LANG(L"Edit scenario", L"Ðåäàêòèðîâàòü ñöåíàðèé") : LANG(L"Start new game", L"Íà÷àòü íîâóþ èãðó"), ImVec2(230, 20)))
-				select_scenario = true;
+			selected_scenario = i;
 
-			if (!scenario_editor)
+			for (int c = 0; c < scenarios.at(i).scenes.size(); c++)
 			{
-				if (ImGui::Button(LANG(L"Load save", L"Çàãðóçèòü ñîõðàíåíèå"), ImVec2(230, 20)))
-					select_save = true;
+				current_scenario_scene = c;
+
+				build_scene_frame(io);
+
+				render_stats.collect(ImGui::GetDrawData());
+				stats[pass].push_back(render_stats);
 			}
+		}
+	}
 
-			ImGui::Spacing();
-			ImGui::Separator();
-			ImGui::Spacing();
+	std::ofstream file(L".\\game\\profiles\\atlas_benchmark " + get_profile_name(), std::ios::trunc);
 
-			if (ImGui::Button(LANG(L"Video settings", L"Íàñòðîéêè âèäåî"), ImVec2(230, 20)))
-				video_settings_open = !video_settings_open;
+	file << "scenario,scene,atlas_draw_calls,noatlas_draw_calls,atlas_texture_switches,noatlas_texture_switches\n";
 
-			if (ImGui::Button(LANG(L"Audio settings", L"Íàñòðîéêè çâóêà"), ImVec2(230, 20)))
-				audio_settings_open = !audio_settings_open;
+	RenderStats_t total[2];
+	int scene = 0;
 
-			if (ImGui::Button(LANG(L"Game settings", L"Íàñòðîéêè èãðû"), ImVec2(230, 20)))
-				game_settings_open = !game_settings_open;
+	for (int i = 0; i < scenarios.size(); i++)
+	{
+		for (int c = 0; c < scenarios.at(i).scenes.size() && scene < stats[0].size() && scene < stats[1].size(); c++, scene++)
+		{
+			file << ws2s(scenarios.at(i).file_name) << "," << c << "," << stats[0].at(scene).draw_calls << "," << stats[1].at(scene).draw_calls << "," << stats[0].at(scene).texture_switches << "," << stats[1].at(scene).texture_switches << "\n";
 
-			if (wcsstr(GetCommandLineW(), L"-skid1337"))
+			for (int pass = 0; pass < 2; pass++)
 			{
-				if (!add_start_scene && ImGui::Button("Click me!", ImVec2(230, 20)))
-					add_start_scene = true;
+				total[pass].draw_calls += stats[pass].at(scene).draw_calls;
+				total[pass].texture_switches += stats[pass].at(scene).texture_switches;
 			}
-
-			ImGui::Spacing();
-			ImGui::Separator();
-			ImGui::Spacing();
-
-			if (ImGui::Button(LANG(L"Quit game", L"Âûõîä èç èãðû"), ImVec2(230, 20)))
-				exit(0);
 		}
-
-		ImGui::End();
-
-		button_menu_open = false;
 	}
-	else
-	{
-		select_scenario = false;
-		select_save = false;
-
-		// load scenario if it wasnt loaded during game init
-		load_scenario_data(selected_scenario);
 
-		main_game();
-	}
+	file << "total,," << total[0].draw_calls << "," << total[1].draw_calls << "," << total[0].texture_switches << "," << total[1].texture_switches << "\n";
 
-	if (video_settings_open)
-		video_settings_menu();
+	bool written = file.good();
+	file.close();
 
-	if (audio_settings_open)
-		audio_settings_menu();
+	stop_headless();
 
-	if (game_settings_open)
-		game_settings_menu();
+	return written ? 0 : 1;
 }
 
-bool intro_render()
+// -benchmark: microbenchmarks of engine internals (see benchmarks.h), results are written to game\profiles
+int run_benchmarks()
 {
-	static float delta_time_factor = 1.0f;
+	std::ofstream file(L".\\game\\profiles\\benchmark " + get_report_name(), std::ios::trunc);
 
-	if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)))
-		delta_time_factor = 8.0f;
+	if (!file.is_open())
+		return 1;
 
-	if (!rendered_intro)
-	{
-		intro_alpha_fade_out = ImLerp(intro_alpha_fade_out, 3.0f, ImGui::GetIO().DeltaTime * (delta_time_factor - 0.6f));
+	benchmark_translation_lookups(file);
+	benchmark_text_encoding(file);
 
-		if (intro_alpha_fade_out > 2.60f)
-			intro_alpha_fade_in = ImLerp(intro_alpha_fade_in, 3.0f, ImGui::GetIO().DeltaTime * delta_time_factor);
+	return file.good() ? 0 : 1;
+}
 
-#ifndef DCS_OPENGL
-		ImGui::GetForegroundDrawList()->AddImage(game_menu_data.intro_logo.image_data, ImVec2(ImGui::GetIO().DisplaySize.x / 2 - 150, ImGui::GetIO().DisplaySize.y / 2 - 180), ImVec2(ImGui::GetIO().DisplaySize.x / 2 + 150, ImGui::GetIO().DisplaySize.y / 2 + 120), ImVec2(0, 0), ImVec2(1, 1), ImColor(255, 255, 255, int(255 * ImClamp(intro_alpha_fade_out - intro_alpha_fade_in, 0.0f, 1.0f))));
-#else
-		ImGui::GetForegroundDrawList()->AddImage(convertGLtoImTexture(game_menu_data.intro_logo.image_data.getNativeHandle()), ImVec2(ImGui::GetIO().DisplaySize.x / 2 - 150, ImGui::GetIO().DisplaySize.y / 2 - 180), ImVec2(ImGui::GetIO().DisplaySize.x / 2 + 150, ImGui::GetIO().DisplaySize.y / 2 + 120), ImVec2(0, 0), ImVec2(1, 1), ImColor(255, 255, 255, int(255 * ImClamp(intro_alpha_fade_out - intro_alpha_fade_in, 0.0f, 1.0f))));
-#endif
-		ImGui::GetForegroundDrawList()->AddText(game_fonts.intro_font.font_data, game_fonts.intro_font.font_size, ImVec2(ImGui::GetIO().DisplaySize.x / 2 - 150, ImGui::GetIO().DisplaySize.y / 2 + 120), ImColor(255, 255, 255, int(255 * ImClamp(intro_alpha_fade_out - intro_alpha_fade_in, 0.0f, 1.0f))), utf8(game_info.game_developer.c_str()));
+// -self_test: checks of engine internals (see self_tests.h), failed checks are written to game\profiles, exit code is 1
+// if any failed
+int run_self_tests()
+{
+	std::ofstream file(L".\\game\\profiles\\self_test " + get_report_name(), std::ios::trunc);
 
-		if (intro_alpha_fade_in > 2.8f)
-			rendered_intro = true;
-	}
+	bool passed = test_text_encoding(file);
+	passed &= test_software_rasterizer(file);
 
-	return rendered_intro;
-}
+	file << (passed ? "passed\n" : "failed\n");
 
-#define DCS_DEBUG
+	return passed ? 0 : 1;
+}
 
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR szCmdLine, int nShowCmd)
 {
+	if (wcsstr(GetCommandLineW(), L"-trace"))
+		tracer.start();
+
+	tracer.set_thread_name("Main");
+	tracer.begin("Startup");
+
+	// before any imgui context is created, so everything imgui allocates is counted
+	ImGui::SetAllocatorFunctions(counted_imgui_allocate, counted_imgui_free);
+
 	if (wcsstr(GetCommandLineW(), L"-scenario_editor"))
 		scenario_editor = true;
 
+	if (wcsstr(GetCommandLineW(), L"-noatlas"))
+		texture_atlases_enabled = false;
+
+	if (wcsstr(GetCommandLineW(), L"-headless") || wcsstr(GetCommandLineW(), L"-render_scenes") || wcsstr(GetCommandLineW(), L"-atlas_benchmark"))
+		headless = true;
+
 	video_settings.screen_width = 1280;
 	video_settings.screen_height = 720;
 
 	hInstance = hInst;
 	
 #ifndef DCS_OPENGL
-	hookKeyboardProc(hInstance);
+	if (!headless)
+		hookKeyboardProc(hInstance);
 #endif
 
 #ifdef DCS_DEBUG
@@ -3281,7 +4558,7 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR szCmdLine, int nShowC
 #endif
 
 #ifdef DISCORD_RPC
-	if (!wcsstr(GetCommandLineW(), L"-disable_discord_rpc"))
+	if (!wcsstr(GetCommandLineW(), L"-disable_discord_rpc") && !headless)
 	{
 		RPC_Initialize(utf8(game_info.game_rpc_app_id.c_str()));
 
@@ -3309,9 +4586,12 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR szCmdLine, int nShowC
 	CreateDirectoryW(L".\\game\\scenarios\\", NULL);
 	CreateDirectoryW(L".\\game\\translations\\", NULL);
 	CreateDirectoryW(L".\\game\\screenshots\\", NULL);
+	CreateDirectoryW(L".\\game\\profiles\\", NULL);
 	CreateDirectoryW(L".\\game\\saves\\", NULL);
 	CreateDirectoryW(L".\\game\\sounds\\", NULL);
 	CreateDirectoryW(L".\\game\\fonts\\", NULL);
+	CreateDirectoryW(L".\\game\\cache\\", NULL);
+	CreateDirectoryW(TEXTURE_CACHE_DIRECTORY, NULL);
 	CreateDirectoryW(L".\\game\\config\\", NULL);
 
 	scenarios = load_scenarios(L".\\game\\scenarios", L".\\game\\textures", L".\\game\\sounds");
@@ -3326,13 +4606,34 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR szCmdLine, int nShowC
 	read_video_settings_from_file();
 	write_video_settings_to_file(video_settings);
 
+	texture_residency.budget_bytes = size_t(video_settings.texture_memory_budget) * 1024 * 1024;
+	texture_residency.prefetch_scenes = video_settings.texture_prefetch_scenes;
+
 	read_game_settings_from_file();
 	write_game_settings_to_file(game_settings);
 
 	read_game_fonts_from_file();
 	write_game_fonts_to_file(game_fonts);
 
-	BASS_Init(-1, 44100, 0, 0, NULL);
+	// no sound device in headless mode
+	BASS_Init(headless ? 0 : -1, 44100, 0, 0, NULL);
+
+	tracer.end("Startup");
+
+	if (wcsstr(GetCommandLineW(), L"-benchmark"))
+		return run_benchmarks();
+
+	if (wcsstr(GetCommandLineW(), L"-self_test"))
+		return run_self_tests();
+
+	if (wcsstr(GetCommandLineW(), L"-render_scenes"))
+		return render_scenes();
+
+	if (wcsstr(GetCommandLineW(), L"-atlas_benchmark"))
+		return run_atlas_benchmark();
+
+	if (headless)
+		return run_headless();
 
 #ifdef DCS_OPENGL
 	if (video_settings.screen_mode == 0)
@@ -3379,28 +4680,40 @@ RENDER_INIT:
 	sf::ContextSettings window_settings = sf::ContextSettings();
 	window_settings.antialiasingLevel = 4;
 
+	// sfml graphics needs compatibility context, core features are used through it
+	if (video_settings.render_mode == 1)
+	{
+		window_settings.majorVersion = 3;
+		window_settings.minorVersion = 3;
+
+		game_renderer = L"OpenGL 3.3";
+	}
+
 	sf::RenderWindow window(sf::VideoMode(video_settings.screen_width, video_settings.screen_height), std::wstring(game_info.game_name + L" (" + game_renderer + L")").c_str(), sf::Style::Titlebar | sf::Style::Close | (video_settings.screen_mode == 0 ? sf::Style::Fullscreen : 0), window_settings);
 
 	hWnd = window.getSystemHandle();
 	window.setVerticalSyncEnabled(video_settings.vsync);
 
 	ImGui::SFML::Init(window);
-#endif
-
-	ImGuiIO& io = ImGui::GetIO(); (void)io;
 
-	io.IniFilename = NULL;
-	io.ConfigFlags |= ImGuiConfigFlags_NavEnableSetMousePos;
+	if (video_settings.render_mode == 1 && !gl_renderer.init())
+		game_renderer = L"OpenGL";
 
-	ImGui::StyleColorsDCS_Dark();
+	window.setTitle(std::wstring(game_info.game_name + L" (" + game_renderer + L")").c_str());
+#endif
 
-	ImGui::GetStyle().WindowPadding = ImVec2(10, 10);
-	ImGui::GetStyle().WindowRounding = 2.0f;
+	ImGuiIO& io = ImGui::GetIO(); (void)io;
 
-	ImGui::GetStyle().TabRounding = 2.0f;
+	setup_imgui(io);
 
 	if (!first_init)
 	{
+		texture_loader.ready = wake_idle_rendering;
+		scenario_loader.ready = wake_idle_rendering;
+
+		texture_loader.start(get_texture_worker_count(), 16);
+		scenario_loader.start(load_scenario_files);
+
 		load_game_assets(io);
 		first_init = true;
 	}
@@ -3420,8 +4733,15 @@ RENDER_INIT:
 
 	while (true)
 	{
+		if (game_settings.idle_rendering && idle_rendering.should_wait())
+			idle_rendering.wait();
+
+		bool had_input = false;
+
 		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 		{
+			had_input = true;
+
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
@@ -3429,17 +4749,34 @@ RENDER_INIT:
 		if (msg.message == WM_QUIT)
 			break;
 
+		// idle waits and message that quits loop are not part of frame time, every begun frame is ended
+		frame_profiler.begin_frame();
+
 		//else
 		//	SendMessage(hWnd, WM_RENDER, NULL, NULL);
 
 		ImGui_ImplDX11_NewFrame();
 		ImGui_ImplWin32_NewFrame();
 
+		frame_arena.reset();
+		text_run_cache.end_frame();
 		ImGui::NewFrame();
 
+		frame_profiler.begin(FRAME_PHASE_TEXTURE_STREAMING);
+		process_scenario_loads();
+		update_texture_residency();
+		process_texture_uploads(4.0f);
+		frame_profiler.end();
+
 		if (intro_render())
 			game_render();
 
+		// results left to next frames keep loop awake, workers wake it when they have more
+		if (texture_loader.has_decoded() || scenario_loader.has_loaded() || ImGui::GetIO().WantTextInput)
+			idle_rendering.keep_awake();
+
+		idle_rendering.end_frame(had_input);
+
 		if (GetAsyncKeyState(VK_F12) & 1)
 		{
 			HRESULT hr = S_OK;
@@ -3477,9 +4814,16 @@ RENDER_INIT:
 			pSurface->Release();
 		}
 
+		frame_profiler.begin(FRAME_PHASE_IMGUI_RENDER);
+
 		ImGui::EndFrame();
 
 		ImGui::Render();
+		render_stats.collect(ImGui::GetDrawData());
+
+		frame_profiler.end();
+
+		frame_profiler.begin(FRAME_PHASE_SUBMIT);
 
 		g_pd3dDeviceContext->OMSetRenderTargets(1, &backBuffer, NULL);
 		g_pd3dDeviceContext->ClearDepthStencilView(depthStancilBuffer, D3D11_CLEAR_DEPTH, 1.0f, 0);
@@ -3489,7 +4833,16 @@ RENDER_INIT:
 
 		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 
+		frame_profiler.end();
+
+		frame_profiler.begin(FRAME_PHASE_PRESENT);
+
 		g_pSwapChain->Present((int)video_settings.vsync, 0);
+
+		frame_profiler.end();
+		frame_profiler.end_frame();
+
+		idle_rendering.frame_presented();
 	}
 
 	if (should_recreate_d3d_device_and_window)
@@ -3504,10 +4857,20 @@ RENDER_INIT:
 	sf::Clock deltaClock;
 	while (window.isOpen()) 
 	{
+		if (game_settings.idle_rendering && idle_rendering.should_wait())
+			idle_rendering.wait();
+
+		// idle waits are not part of frame time
+		frame_profiler.begin_frame();
+
+		bool had_input = false;
+
 		sf::Event event;
 
 		while (window.pollEvent(event)) 
 		{
+			had_input = true;
+
 			if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F12)
 			{
 				sf::Image screenshot = window.capture();
@@ -3517,23 +4880,73 @@ RENDER_INIT:
 			ImGui::SFML::ProcessEvent(window, event);
 
 			if (event.type == sf::Event::Closed)
-				window.close();
+				quit_requested = true;
 		}
 
+		frame_arena.reset();
+		text_run_cache.end_frame();
 		ImGui::SFML::Update(window, deltaClock.restart());
 
+		frame_profiler.begin(FRAME_PHASE_TEXTURE_STREAMING);
+		process_scenario_loads();
+		update_texture_residency();
+		process_texture_uploads(4.0f);
+		frame_profiler.end();
+
 		if (intro_render())
 			game_render();
 
+		// results left to next frames keep loop awake, workers wake it when they have more
+		if (texture_loader.has_decoded() || scenario_loader.has_loaded() || ImGui::GetIO().WantTextInput)
+			idle_rendering.keep_awake();
+
+		idle_rendering.end_frame(had_input);
+
+		frame_profiler.begin(FRAME_PHASE_IMGUI_RENDER);
+
+		ImGui::Render();
+		render_stats.collect(ImGui::GetDrawData());
+
+		frame_profiler.end();
+
+		frame_profiler.begin(FRAME_PHASE_SUBMIT);
+
 		window.clear();
-		ImGui::SFML::Render(window);
+
+		// imgui-sfml doesnt render again when frame is already rendered, it only submits draw data
+		if (gl_renderer.ready)
+			gl_renderer.render(ImGui::GetDrawData());
+		else
+			ImGui::SFML::Render(window);
+
+		frame_profiler.end();
+
+		frame_profiler.begin(FRAME_PHASE_PRESENT);
 
 		window.display();
+
+		frame_profiler.end();
+		frame_profiler.end_frame();
+
+		idle_rendering.frame_presented();
+
+		// gl objects are deleted while context of window still exists
+		if (quit_requested)
+		{
+			gl_renderer.shutdown();
+			window.close();
+		}
 	}
 
 	ImGui::SFML::Shutdown();
 #endif
 
+	scenario_loader.shutdown();
+	texture_loader.shutdown();
+
+	if (tracer.enabled)
+		tracer.write(L".\\game\\profiles\\" + get_trace_name());
+
 	BASS_Free();
 
 	return 0;
@@ -3577,6 +4990,8 @@ LRESULT WINAPI wndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 bool initDirectX()
 {
+	TraceScope_t trace_scope("initDirectX");
+
 	// init dx
 	DXGI_SWAP_CHAIN_DESC sdesc;
 	ZeroMemory(&sdesc, sizeof(sdesc));